@@ -2,9 +2,17 @@
 #define SGI_ALLOC_H
 
 #include <new>
+#include <mutex>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 
-#define __THROW_BAD_ALLOC throw std::bad_alloc
+#define __THROW_BAD_ALLOC throw std::bad_alloc()
 
 namespace cyy
 {
@@ -40,13 +48,24 @@ public:
         return result;
     }
 
-    static void (* set_malloc_handler(void (*f)()))();
+    // bytes really usable at p returned by allocate(n), at least n
+    static std::size_t usable_size(void *p, std::size_t n)
+    {
+#if defined(__GLIBC__)
+        std::size_t size = malloc_usable_size(p);
+        return size > n ? size : n;
+#else
+        return n;
+#endif
+    }
+
+    static void (* set_malloc_handler(void (*f)()))()
     {
         void (* old)() = __malloc_alloc_oom_handler;
         __malloc_alloc_oom_handler = f;
         return (old);
     }
-}
+};
 
 template<int inst>
 void (* __malloc_alloc_template<inst>::__malloc_alloc_oom_handler)() = nullptr;
@@ -95,46 +114,281 @@ using malloc_alloc = __malloc_alloc_template<0>;
 namespace {
     constexpr static std::size_t __ALIGN = 8;                          // upper size
     constexpr static std::size_t __MAX_BYTES = 128;                     // max size of block
-    constexpr static std::size_t __NFREELISTS = __MAX_BYTE/__ALIGN;    // size of free-lists
+    constexpr static int __NOBJS = 20;                                  // blocks per refill, also size of a depot batch
 }
 
-tmeplate<bool threads, int inst>
+// Size classes of __default_alloc_template. A size class policy provides
+//     align      alignment of every block, at least sizeof(void*)
+//     max_bytes  largest block served by the pool, larger requests go to malloc_alloc
+//     nclasses   number of free-lists
+//     index(n)   free-list of the smallest class holding n bytes, 0 < n <= max_bytes
+//     size(i)    block size of free-list i, size(0) must be align
+
+// Align, 2 * Align, 3 * Align ... MaxBytes
+template<std::size_t Align, std::size_t MaxBytes>
+struct __uniform_size_class
+{
+    constexpr static std::size_t align = Align;
+    constexpr static std::size_t max_bytes = MaxBytes;
+    constexpr static std::size_t nclasses = MaxBytes / Align;
+
+    constexpr static std::size_t index(std::size_t bytes)
+    {
+        return ((bytes + Align - 1)/Align - 1);
+    }
+
+    constexpr static std::size_t size(std::size_t index)
+    {
+        return (index + 1) * Align;
+    }
+};
+
+using __default_size_class = __uniform_size_class<__ALIGN, __MAX_BYTES>;
+
+// map every multiple of Align up to MaxBytes to the smallest class holding it
+template<std::size_t Align, std::size_t MaxBytes>
+struct __size_class_index
+{
+    constexpr __size_class_index(const std::size_t *sizes)
+        : value()
+    {
+        std::size_t c = 0;
+        for (std::size_t i = 0; i <= MaxBytes / Align; ++i)
+        {
+            while (sizes[c] < i * Align)
+            {
+                ++c;
+            }
+            value[i] = static_cast<unsigned short>(c);
+        }
+    }
+
+    unsigned short value[MaxBytes / Align + 1];
+};
+
+// Size classes listed in a table. Sizes must be increasing multiples of
+// Align, and the first one must be Align.
+template<std::size_t Align, std::size_t... Sizes>
+struct __size_class_table
+{
+    constexpr static std::size_t align = Align;
+    constexpr static std::size_t nclasses = sizeof...(Sizes);
+    constexpr static std::size_t sizes[nclasses] = { Sizes... };
+    constexpr static std::size_t max_bytes = sizes[nclasses - 1];
+
+    constexpr static std::size_t index(std::size_t bytes)
+    {
+        return lookup.value[(bytes + Align - 1) / Align];
+    }
+
+    constexpr static std::size_t size(std::size_t index)
+    {
+        return sizes[index];
+    }
+
+private:
+    constexpr static __size_class_index<Align, max_bytes> lookup = __size_class_index<Align, max_bytes>(sizes);
+};
+
+// jemalloc style classes: Steps classes Align apart, then Steps classes for
+// every doubling of the size, up to MaxBytes (rounded up to a class).
+// With Align = 8 and Steps = 4: 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160 ...
+template<std::size_t Align, std::size_t MaxBytes, std::size_t Steps>
+struct __geometric_size_class_helper
+{
+    constexpr static std::size_t size(std::size_t i)
+    {
+        if (i < Steps)
+        {
+            return (i + 1) * Align;
+        }
+        std::size_t group = Steps * Align;
+        std::size_t step = Align;
+        for (i -= Steps; i >= Steps; i -= Steps)
+        {
+            group *= 2;
+            step *= 2;
+        }
+        return group + step * (i + 1);
+    }
+
+    constexpr static std::size_t count()
+    {
+        std::size_t n = 1;
+        while (size(n - 1) < MaxBytes)
+        {
+            ++n;
+        }
+        return n;
+    }
+
+    template<std::size_t... I>
+    static __size_class_table<Align, size(I)...> make_table(std::index_sequence<I...>);
+};
+
+template<std::size_t Align = __ALIGN, std::size_t MaxBytes = 4096, std::size_t Steps = 4>
+using __geometric_size_class = decltype(__geometric_size_class_helper<Align, MaxBytes, Steps>::make_table(
+    std::make_index_sequence<__geometric_size_class_helper<Align, MaxBytes, Steps>::count()>()));
+
+// Source of the chunks carved by __default_alloc_template. A chunk source provides
+//     good_size(n)     bytes worth asking for when n are needed, at least n
+//     allocate(n)      n bytes aligned to a max_align_t, nullptr on failure
+//     oom_allocate(n)  n bytes, called after allocate(n) failed: throws or succeeds
+//     deallocate(p, n) give back p returned by allocate(n) or oom_allocate(n)
+struct __malloc_chunk_source
+{
+    static std::size_t good_size(std::size_t n)
+    {
+        return n;
+    }
+
+    static void * allocate(std::size_t n)
+    {
+        return malloc(n);
+    }
+
+    static void * oom_allocate(std::size_t n)
+    {
+        return malloc_alloc::allocate(n);
+    }
+
+    static void deallocate(void * p, std::size_t)
+    {
+        free(p);
+    }
+};
+
+// Blocks up to SizeClass::max_bytes are served from free-lists, one per size
+// class, larger ones by malloc_alloc. The free-lists are refilled from chunks
+// obtained from ChunkSource.
+// If threads is false, all the free-lists are shared and must not be used by
+// more than one thread at a time.
+// If threads is true, every thread owns its free-lists and its own chunk, so
+// allocate() and deallocate() never take a lock. Blocks are exchanged between
+// threads in batches of __NOBJS through a global depot: a thread whose free-list
+// grows too long gives a batch away, and a thread whose free-list is empty takes
+// one before carving a new chunk.
+template<bool threads, int inst, typename SizeClass = __default_size_class,
+         typename ChunkSource = __malloc_chunk_source>
 class __default_alloc_template
 {
 private:
+    constexpr static std::size_t POOL_ALIGN = SizeClass::align;
+    constexpr static std::size_t POOL_MAX_BYTES = SizeClass::max_bytes;
+    constexpr static std::size_t POOL_NFREELISTS = SizeClass::nclasses;
+
+    static_assert(POOL_ALIGN >= sizeof(void *) && (POOL_ALIGN & (POOL_ALIGN - 1)) == 0,
+                  "alignment of size classes must be a power of 2 not less than a pointer");
+    static_assert(SizeClass::size(0) == POOL_ALIGN, "the smallest size class must be the alignment");
+
     static std::size_t ROUND_UP(std::size_t bytes)
     {
-        return ((bytes + __ALIGN - 1) & ~(__ALIGN - 1));
+        return ((bytes + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1));
     }
 
     union obj
     {
         union obj * free_list_link;
         char client_data[1];                   /* The client sees this. */
-    }
+    };
 
     // decide which free-list to ues according to size of the block
     static std::size_t FREELIST_INDEX(std::size_t bytes)
     {
-        return ((bytes + __ALIGN - 1)/__ALIGN - 1);
+        return SizeClass::index(bytes);
+    }
+
+    // size of the block really handed out for bytes
+    static std::size_t BLOCK_SIZE(std::size_t bytes)
+    {
+        return SizeClass::size(SizeClass::index(bytes));
+    }
+
+    // Every chunk starts with a header, all the chunks are linked in chunk_list.
+    // A chunk is retired once its owner has carved all of it into blocks, so
+    // it can be released when all its blocks are back in the free-lists.
+    struct chunk_header
+    {
+        chunk_header * next;
+        std::size_t size;                              // bytes after the header
+        std::size_t free_bytes;                        // only used in trim()
+        bool retired;
+    };
+
+    constexpr static std::size_t CHUNK_HEADER_SIZE = (sizeof(chunk_header) + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1);
+
+    struct chunk_registry
+    {
+        std::mutex lock;
+        chunk_header * head;
+    };
+
+    // free-lists and chunk of one pool. There is one pool for the whole
+    // process if threads is false, and one pool per thread otherwise.
+    struct pool_state
+    {
+        // give everything back to the depot when a thread exits
+        ~pool_state()
+        {
+            if constexpr (threads)
+            {
+                release_pool(*this);
+            }
+        }
+
+        obj * free_list[POOL_NFREELISTS];
+        std::size_t free_count[POOL_NFREELISTS];         // only maintained if threads
+        char *start_free;                              // Start of memory pool, only changed in chunk_alloc()
+        char *end_free;                                // End of memory pool, only changeed in chunk_alloc()
+        std::size_t heap_size;
+        chunk_header *chunk;                           // chunk of [start_free, end_free), null if it is a borrowed block
+    };
+
+    // free blocks shared between threads, one list per size
+    struct depot_list
+    {
+        std::mutex lock;
+        obj * head;
+        std::size_t count;
+    };
+
+    static pool_state& get_pool()
+    {
+        if constexpr (threads)
+        {
+            return thread_pool;
+        }
+        else
+        {
+            return shared_pool;
+        }
     }
 
     // Returns an object of size n, and optionally adds to size n free list.
     // We assume that n is properly aligned.
-    static void *refill(std::size_t n)
+    static void *refill(pool_state& pool, std::size_t n)
     {
-        int nobjs = 20;
-        char * chunk = chunk_alloc(n, nobjs);
-        obj * volatile * my_free_list;
+        if constexpr (threads)
+        {
+            void * result = fetch_batch(pool, FREELIST_INDEX(n));
+            if (result != nullptr)
+            {
+                return result;
+            }
+        }
+
+        int nobjs = __NOBJS;
+        char * chunk = chunk_alloc(pool, n, nobjs);
+        obj ** my_free_list;
         obj * result;
         obj * current_obj, * next_obj;
         int i;
 
-        if (nobj == 1)
+        if (nobjs == 1)
         {
             return chunk;
         }
-        my_free_list = free_list + FREELIST_INDEX(n);
+        my_free_list = pool.free_list + FREELIST_INDEX(n);
 
         result = (obj *)chunk;
         *my_free_list = next_obj = (obj *)(chunk + n);
@@ -152,108 +406,309 @@ private:
                 current_obj->free_list_link = next_obj;
             }
         }
+        if constexpr (threads)
+        {
+            pool.free_count[FREELIST_INDEX(n)] = nobjs - 1;
+        }
         return result;
     }
 
     // Allocates a chunk for nobjs of size size.  nobjs may be reduced
     // if it is inconvenient to allocate the requested number.
-    static char *chunk_alloc(std::size_t size, int &nobjs)
+    static char *chunk_alloc(pool_state& pool, std::size_t size, int &nobjs)
     {
         char * result;
         std::size_t total_bytes = size * nobjs;
-        std::size_t bytes_left  = end_free - start_free;
+        std::size_t bytes_left  = pool.end_free - pool.start_free;
 
         if (bytes_left >= total_bytes)
         {
-            result = start_free;
-            start_free += total_bytes;
+            result = pool.start_free;
+            pool.start_free += total_bytes;
             return result;
         }
         else if (bytes_left >= size)
         {
             nobjs = bytes_left / size;
             total_bytes = size * nobjs;
-            result = start_free;
-            start_free += total_bytes;
+            result = pool.start_free;
+            pool.start_free += total_bytes;
             return result;
         }
         else
         {
-            std::size_t bytes_to_get = 2 * total_bytes + ROUND_UP(heap_size >> 4);
+            std::size_t bytes_to_get = 2 * total_bytes + ROUND_UP(pool.heap_size >> 4);
+            bytes_to_get = ChunkSource::good_size(CHUNK_HEADER_SIZE + bytes_to_get) - CHUNK_HEADER_SIZE;
             // Try to make use of the left-over piece.
-            if (bytes_left > 0)
-            {
-                obj * volatile * my_free_list = free_list + FREELIST_INDEX(bytes_left);
-                ((obj *)start_free)->free_list_link = *my_free_list;
-                *my_free_list = (obj*)start_free;
-            }
+            push_region(pool, pool.start_free, bytes_left);
+            retire_chunk(pool);
+
+            char * chunk = (char *)ChunkSource::allocate(CHUNK_HEADER_SIZE + bytes_to_get);
 
-            start_free = (char *)malloc(bytes_to_get);
-            
-            if (start_free == nullptr)
+            if (chunk == nullptr)
             {
                 std::size_t i;
-                obj * volatile * my_free_list , *p;
+                obj ** my_free_list , *p;
                 // Try to make do with what we have.  That can't
                 // hurt.  We do not try smaller requests, since that tends
                 // to result in disaster on multi-process machines.
-                for (i = size; i < __MAX_BYTES; i += __ALIGN)
+                for (i = FREELIST_INDEX(size); i < POOL_NFREELISTS; ++i)
                 {
-                    my_free_list = free_list + FREELIST_INDEX(i);
+                    my_free_list = pool.free_list + i;
                     p = *my_free_list;
                     if (p != nullptr)
                     {
                         *my_free_list = p->free_list_link;
-                        start_free = (char *)p;
-                        end_free = start_free + i;
-                        return chunk_alloc(size, nobjs);
+                        if constexpr (threads)
+                        {
+                            --pool.free_count[i];
+                        }
+                        pool.start_free = (char *)p;
+                        pool.end_free = pool.start_free + SizeClass::size(i);
+                        return chunk_alloc(pool, size, nobjs);
                         // Any leftover piece will eventually make it to the
                         // right free list.
                     }
                 }
-                end_free = nullptr;
-                start_free = (char *)malloc_alloc::allocate(bytes_to_get);
+                pool.start_free = pool.end_free = nullptr;
+                chunk = (char *)ChunkSource::oom_allocate(CHUNK_HEADER_SIZE + bytes_to_get);
                 // This should either throw an
                 // exception or remedy the situation.  Thus we assume it
                 // succeeded.
             }
-            heap_size += bytes_to_get;
-            end_free = start_free + bytes_to_get;
-            return (chunk_alloc(size, nobjs));
+            register_chunk(pool, chunk, bytes_to_get);
+            pool.heap_size += bytes_to_get;
+            pool.start_free = chunk + CHUNK_HEADER_SIZE;
+            pool.end_free = pool.start_free + bytes_to_get;
+            return (chunk_alloc(pool, size, nobjs));
+        }
+    }
+
+    // link a new chunk of size bytes, it becomes the chunk carved by pool
+    static void register_chunk(pool_state& pool, char * p, std::size_t size)
+    {
+        chunk_header * h = (chunk_header *)p;
+        h->size = size;
+        h->free_bytes = 0;
+        h->retired = false;
+
+        std::lock_guard<std::mutex> guard(chunk_list.lock);
+        h->next = chunk_list.head;
+        chunk_list.head = h;
+        pool.chunk = h;
+    }
+
+    // pool has carved all of its chunk
+    static void retire_chunk(pool_state& pool)
+    {
+        if (pool.chunk != nullptr)
+        {
+            std::lock_guard<std::mutex> guard(chunk_list.lock);
+            pool.chunk->retired = true;
+            pool.chunk = nullptr;
+        }
+    }
+
+    // put a block of n bytes on the free-list of its size, n must be the
+    // size of a class
+    static void push_block(pool_state& pool, void * p, std::size_t n)
+    {
+        obj *q = (obj *)p;
+        obj ** my_free_list = pool.free_list + FREELIST_INDEX(n);
+        q->free_list_link = *my_free_list;
+        *my_free_list = q;
+        if constexpr (threads)
+        {
+            ++pool.free_count[FREELIST_INDEX(n)];
+        }
+    }
+
+    // cut n bytes from p into blocks as large as possible and put them on
+    // the free-lists, n must be a multiple of the alignment
+    static void push_region(pool_state& pool, char * p, std::size_t n)
+    {
+        while (n > 0)
+        {
+            std::size_t i = n >= POOL_MAX_BYTES ? POOL_NFREELISTS - 1 : FREELIST_INDEX(n);
+            if (SizeClass::size(i) > n)
+            {
+                --i;
+            }
+            std::size_t block_size = SizeClass::size(i);
+            push_block(pool, p, block_size);
+            p += block_size;
+            n -= block_size;
+        }
+    }
+
+    // Move the first __NOBJS blocks of free-list index to the depot.
+    // The free-list must hold at least __NOBJS blocks.
+    static void release_batch(pool_state& pool, std::size_t index)
+    {
+        obj * first = pool.free_list[index];
+        obj * last = first;
+        for (int i = 1; i < __NOBJS; ++i)
+        {
+            last = last->free_list_link;
+        }
+        pool.free_list[index] = last->free_list_link;
+        pool.free_count[index] -= __NOBJS;
+
+        depot_list& d = depot[index];
+        std::lock_guard<std::mutex> guard(d.lock);
+        last->free_list_link = d.head;
+        d.head = first;
+        d.count += __NOBJS;
+    }
+
+    // Take up to __NOBJS blocks of free-list index from the depot. One of them
+    // is returned, the others are put on the empty free-list of pool.
+    // Return nullptr if the depot has no block of that size.
+    static void *fetch_batch(pool_state& pool, std::size_t index)
+    {
+        obj * first;
+        obj * last;
+        std::size_t n = 1;
+        {
+            depot_list& d = depot[index];
+            std::lock_guard<std::mutex> guard(d.lock);
+            first = last = d.head;
+            if (first == nullptr)
+            {
+                return nullptr;
+            }
+            for (; n < __NOBJS && last->free_list_link != nullptr; ++n)
+            {
+                last = last->free_list_link;
+            }
+            d.head = last->free_list_link;
+            d.count -= n;
+        }
+        last->free_list_link = nullptr;
+        pool.free_list[index] = first->free_list_link;
+        pool.free_count[index] = n - 1;
+        return first;
+    }
+
+    // Give all the blocks of pool, including what is left of its chunk, to the depot
+    static void release_pool(pool_state& pool)
+    {
+        push_region(pool, pool.start_free, pool.end_free - pool.start_free);
+        pool.start_free = pool.end_free;
+        retire_chunk(pool);
+        for (std::size_t i = 0; i < POOL_NFREELISTS; ++i)
+        {
+            obj * first = pool.free_list[i];
+            if (first == nullptr)
+            {
+                continue;
+            }
+            obj * last = first;
+            while (last->free_list_link != nullptr)
+            {
+                last = last->free_list_link;
+            }
+
+            depot_list& d = depot[i];
+            std::lock_guard<std::mutex> guard(d.lock);
+            last->free_list_link = d.head;
+            d.head = first;
+            d.count += pool.free_count[i];
+            pool.free_list[i] = nullptr;
+            pool.free_count[i] = 0;
+        }
+    }
+
+    // find the chunk holding p in chunks sorted by address, null if none
+    static chunk_header *find_chunk(chunk_header ** first, chunk_header ** last, void * p)
+    {
+        std::uintptr_t addr = (std::uintptr_t)p;
+        chunk_header ** it = std::upper_bound(first, last, addr,
+            [] (std::uintptr_t a, chunk_header * h) { return a < (std::uintptr_t)h; });
+        if (it == first)
+        {
+            return nullptr;
+        }
+        chunk_header * h = *(it - 1);
+        std::uintptr_t begin = (std::uintptr_t)h + CHUNK_HEADER_SIZE;
+        return (addr >= begin && addr < begin + h->size) ? h : nullptr;
+    }
+
+    // add the size of every block of list to free_bytes of its chunk
+    static void count_free_bytes(chunk_header ** first, chunk_header ** last,
+                                 obj * list, std::size_t block_size)
+    {
+        for (; list != nullptr; list = list->free_list_link)
+        {
+            chunk_header * h = find_chunk(first, last, list);
+            if (h != nullptr)
+            {
+                h->free_bytes += block_size;
+            }
         }
     }
 
+    // unlink the blocks of the chunks going to be released from *list,
+    // return the number of blocks removed
+    static std::size_t remove_released_blocks(chunk_header ** first, chunk_header ** last, obj ** list)
+    {
+        std::size_t n = 0;
+        while (*list != nullptr)
+        {
+            chunk_header * h = find_chunk(first, last, *list);
+            if (h != nullptr && h->free_bytes == h->size)
+            {
+                *list = (*list)->free_list_link;
+                ++n;
+            }
+            else
+            {
+                list = &(*list)->free_list_link;
+            }
+        }
+        return n;
+    }
 
-    // 16 free-lists
-    static obj * volatile free_list[__NFREELISTS];
-    // Chunk allocation state
-    static char *start_free;                              // Start of memory pool, only changed in chunk_alloc()
-    static char *end_free;                                // End of memory pool, only changeed in chunk_alloc()
-    static std::size_t heap_size;
+    // the pool used when threads is false
+    static pool_state shared_pool;
+    // the pools used when threads is true
+    static thread_local pool_state thread_pool;
+    // blocks exchanged between the thread pools
+    static depot_list depot[POOL_NFREELISTS];
+    // all the chunks
+    static chunk_registry chunk_list;
 
 public:
 
+    // every block is aligned to it
+    constexpr static std::size_t alignment = POOL_ALIGN;
+
     // n must be > 0
     static void *allocate(std::size_t n)
     {
         void * result = nullptr;
-        // if larger than 128, then call the malloc_alloc::allocate
-        if (n > __MAX_BYTES)
+        // if larger than the largest class, then call the malloc_alloc::allocate
+        if (n > POOL_MAX_BYTES)
         {
             result = malloc_alloc::allocate(n);
         }
         else
         {
-            obj * volatile * my_free_list = free_list + FREELIST_INDEX(n);
+            pool_state& pool = get_pool();
+            obj ** my_free_list = pool.free_list + FREELIST_INDEX(n);
             result = *my_free_list;
             if (result == nullptr)
             {
                 // Refill free_list if fail to look for adequate one
-                result = refill(ROUND_UP(n));
+                result = refill(pool, BLOCK_SIZE(n));
             }
             else
             {
                 *my_free_list = (*my_free_list)->free_list_link;
+                if constexpr (threads)
+                {
+                    --pool.free_count[FREELIST_INDEX(n)];
+                }
             }
         }
         return result;
@@ -262,32 +717,51 @@ public:
     /* p may not be 0 */
     static void deallocate(void * p, std::size_t n)
     {
-        // Call malloc_alloc::deallocate if size > 128
-        if (n > __MAX_BYTES)
+        // Call malloc_alloc::deallocate if larger than the largest class
+        if (n > POOL_MAX_BYTES)
         {
             malloc_alloc::deallocate(p, n);
         }
         else
         {
             // Look for free_list
-            obj *q = (obj *)p;
-            obj * volatile * my_free_list = free_list + FREELIST_INDEX(n);
-            q->free_list_link = *my_free_list;
-            *my_free_list = q;
+            pool_state& pool = get_pool();
+            push_block(pool, p, n);
+            if constexpr (threads)
+            {
+                // keep at most two batches, give the rest to other threads
+                if (pool.free_count[FREELIST_INDEX(n)] >= 2 * __NOBJS)
+                {
+                    release_batch(pool, FREELIST_INDEX(n));
+                }
+            }
         }
     }
 
+    // number of bytes usable in the block returned by allocate(n)
+    static std::size_t block_size(std::size_t n)
+    {
+        return n > POOL_MAX_BYTES ? n : BLOCK_SIZE(n);
+    }
+
+    // block_size(n) for the block p, asking malloc for the blocks it holds
+    static std::size_t usable_size(void *p, std::size_t n)
+    {
+        return n > POOL_MAX_BYTES ? malloc_alloc::usable_size(p, n) : BLOCK_SIZE(n);
+    }
+
     static void *reallocate(void *p, std::size_t old_sz, std::size_t new_sz)
     {
-        if (old_sz > __MAX_BYTES && new_sz > __MAX_BYTES)
+        if (old_sz > POOL_MAX_BYTES && new_sz > POOL_MAX_BYTES)
         {
-            return realloc(p, new_sz);
+            return malloc_alloc::reallocate(p, old_sz, new_sz);
         }
-        if (ROUND_UP(old_sz) == ROUND_UP(new_sz))
+        if (old_sz <= POOL_MAX_BYTES && new_sz <= POOL_MAX_BYTES &&
+            FREELIST_INDEX(old_sz) == FREELIST_INDEX(new_sz))
         {
             return p;
         }
-        
+
         void * result;
         std::size_t copy_sz;
         result = allocate(new_sz);
@@ -296,23 +770,131 @@ public:
         deallocate(p, old_sz);
         return result;
     }
-}
 
-template<bool threads, int inst>
-char *__default_alloc_template<threads, inst>::start_free = 0;
+    // Give back to the system the chunks of which every block is free, and
+    // return the number of bytes released.
+    // If threads is true, only the free-lists of the calling thread and the
+    // depot are searched, so a chunk with blocks cached by another thread is kept.
+    static std::size_t trim()
+    {
+        pool_state& pool = get_pool();
+        std::lock_guard<std::mutex> guard(chunk_list.lock);
+        std::unique_lock<std::mutex> depot_guards[POOL_NFREELISTS];
+        if constexpr (threads)
+        {
+            for (std::size_t i = 0; i < POOL_NFREELISTS; ++i)
+            {
+                depot_guards[i] = std::unique_lock<std::mutex>(depot[i].lock);
+            }
+        }
+
+        // the chunk being carved by this pool can go too if nothing has been
+        // allocated from it, the rest of it counts as free
+        std::size_t n = 0;
+        for (chunk_header * h = chunk_list.head; h != nullptr; h = h->next)
+        {
+            if (h->retired || h == pool.chunk)
+            {
+                ++n;
+            }
+        }
+        if (n == 0)
+        {
+            return 0;
+        }
+        chunk_header ** first = (chunk_header **)malloc(n * sizeof(chunk_header *));
+        if (first == nullptr)
+        {
+            return 0;
+        }
+        chunk_header ** last = first;
+        for (chunk_header * h = chunk_list.head; h != nullptr; h = h->next)
+        {
+            if (h->retired || h == pool.chunk)
+            {
+                h->free_bytes = 0;
+                *last++ = h;
+            }
+        }
+        std::sort(first, last, [] (chunk_header * a, chunk_header * b) {
+            return (std::uintptr_t)a < (std::uintptr_t)b;
+        });
+
+        if (pool.chunk != nullptr)
+        {
+            pool.chunk->free_bytes += pool.end_free - pool.start_free;
+        }
+        for (std::size_t i = 0; i < POOL_NFREELISTS; ++i)
+        {
+            count_free_bytes(first, last, pool.free_list[i], SizeClass::size(i));
+            if constexpr (threads)
+            {
+                count_free_bytes(first, last, depot[i].head, SizeClass::size(i));
+            }
+        }
+
+        for (std::size_t i = 0; i < POOL_NFREELISTS; ++i)
+        {
+            std::size_t removed = remove_released_blocks(first, last, pool.free_list + i);
+            if constexpr (threads)
+            {
+                pool.free_count[i] -= removed;
+                depot[i].count -= remove_released_blocks(first, last, &depot[i].head);
+            }
+        }
+        chunk_header * own = pool.chunk;
+        if (own != nullptr && own->free_bytes == own->size)
+        {
+            pool.chunk = nullptr;
+            pool.start_free = pool.end_free = nullptr;
+        }
+        free(first);
+
+        std::size_t released = 0;
+        chunk_header ** link = &chunk_list.head;
+        while (*link != nullptr)
+        {
+            chunk_header * h = *link;
+            if ((h->retired || h == own) && h->free_bytes == h->size)
+            {
+                *link = h->next;
+                released += CHUNK_HEADER_SIZE + h->size;
+                ChunkSource::deallocate(h, CHUNK_HEADER_SIZE + h->size);
+            }
+            else
+            {
+                link = &h->next;
+            }
+        }
+        if constexpr (!threads)
+        {
+            // heap_size is per thread if threads, it only drives the growth of chunks
+            pool.heap_size -= released > pool.heap_size ? pool.heap_size : released;
+        }
+        return released;
+    }
+};
 
-template<bool threads, int inst>
-char *__default_alloc_template<threads, inst>::end_free = 0;
+template<bool threads, int inst, typename SizeClass, typename ChunkSource>
+typename __default_alloc_template<threads, inst, SizeClass, ChunkSource>::pool_state
+__default_alloc_template<threads, inst, SizeClass, ChunkSource>::shared_pool;
 
-template<bool threads, int inst>
-std::size_t __default_alloc_template<threads, inst>::heap_size = 0;
+template<bool threads, int inst, typename SizeClass, typename ChunkSource>
+thread_local typename __default_alloc_template<threads, inst, SizeClass, ChunkSource>::pool_state
+__default_alloc_template<threads, inst, SizeClass, ChunkSource>::thread_pool;
 
-template<bool threads, int inst>
-__default_alloc_template<threads, inst>::obj* volatile
-__default_alloc_template<threads, inst>::free_list[__NFREELISTS] = 
-{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+template<bool threads, int inst, typename SizeClass, typename ChunkSource>
+typename __default_alloc_template<threads, inst, SizeClass, ChunkSource>::depot_list
+__default_alloc_template<threads, inst, SizeClass, ChunkSource>::depot[__default_alloc_template<threads, inst, SizeClass, ChunkSource>::POOL_NFREELISTS];
 
+template<bool threads, int inst, typename SizeClass, typename ChunkSource>
+typename __default_alloc_template<threads, inst, SizeClass, ChunkSource>::chunk_registry
+__default_alloc_template<threads, inst, SizeClass, ChunkSource>::chunk_list;
 
+// node allocator shared by all the threads, each of them keeps its own cache
+using alloc = __default_alloc_template<true, 0>;
+// node allocator for single-threaded programs
+using single_client_alloc = __default_alloc_template<false, 0>;
 
 template <class Tp, class Alloc>
 class simple_alloc
@@ -320,17 +902,17 @@ class simple_alloc
 public:
     static Tp* allocate(size_t n)
     {
-        return n == 0 ? (Tp*) Alloc::allocate(n * sizeof(Tp));
+        return n == 0 ? nullptr : (Tp*) Alloc::allocate(n * sizeof(Tp));
     }
 
     static Tp* allocate(void)
     {
-        return (*Tp) Alloc::allocate(sizeof(Tp));
+        return (Tp*) Alloc::allocate(sizeof(Tp));
     }
 
     static void deallocate(Tp * p, std::size_t n)
     {
-        if (n == 0)
+        if (n != 0)
             Alloc::deallocate(p, n * sizeof(Tp));
     }
 
@@ -338,7 +920,7 @@ public:
     {
         Alloc::deallocate(p, sizeof(Tp));
     }
-}
+};
 }
 
-#endif /*SGI_ALLOC_H */
\ No newline at end of file
+#endif /*SGI_ALLOC_H */
@@ -6,6 +6,8 @@
 #include <cstdlib>
 #include <climits>
 #include <iostream>
+#include <type_traits>
+#include "type_traits.h"
 
 namespace cyy
 {
@@ -27,6 +29,8 @@ public:
 
     Allocator(const Allocator&) noexcept { }
 
+    Allocator& operator=(const Allocator&) noexcept = default;
+
     template<typename P>
     Allocator(const Allocator<P>&) noexcept { }
 
@@ -45,12 +49,27 @@ public:
         {
             throw std::bad_alloc();
         }
-        return static_cast<pointer>(::operator new(n * sizeof(T)));
+        // plain operator new only aligns to __STDCPP_DEFAULT_NEW_ALIGNMENT__
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            return static_cast<pointer>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        else
+        {
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        }
     }
 
     void deallocate(pointer p, size_type)
     {
-        ::operator delete(p);
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ::operator delete(p, std::align_val_t(alignof(T)));
+        }
+        else
+        {
+            ::operator delete(p);
+        }
     }
 
     pointer address(reference x) const noexcept
@@ -112,6 +131,94 @@ class Allocator<void>
 public:
     using pointer = void*;
 };
+
+// stateless, its destructor does nothing
+template<typename T>
+struct is_trivially_relocatable<Allocator<T>>
+    : std::true_type
+{
+};
+
+// Allocator whose storage is aligned to Align bytes at least, e.g. 64 for
+// cache lines or AVX-512 loads. Align must be a power of 2.
+template<typename T, std::size_t Align>
+class Aligned_allocator
+{
+    static_assert(Align != 0 && (Align & (Align - 1)) == 0, "Align must be a power of 2");
+
+public:
+    using value_type      = T;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using reference       = T&;
+    using const_reference = const T&;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    // the alignment really used, never less than the one of T
+    constexpr static std::size_t alignment = Align > alignof(T) ? Align : alignof(T);
+
+    // constructors
+    Aligned_allocator() noexcept { }
+
+    Aligned_allocator(const Aligned_allocator&) noexcept { }
+
+    Aligned_allocator& operator=(const Aligned_allocator&) noexcept = default;
+
+    template<typename P>
+    Aligned_allocator(const Aligned_allocator<P, Align>&) noexcept { }
+
+    template<typename T1>
+    struct rebind
+    {
+        using other = Aligned_allocator<T1, Align>;
+    };
+
+    pointer allocate(size_type n, const void* = nullptr)
+    {
+        if (n > this->max_size())
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<pointer>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+    }
+
+    void deallocate(pointer p, size_type) noexcept
+    {
+        ::operator delete(p, std::align_val_t(alignment));
+    }
+
+    size_type max_size() const noexcept
+    {
+        return size_type(-1) / sizeof(value_type);
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args) const
+    {
+        ::new((void*)p) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    void destroy(U* p)
+    {
+        p->~U();
+    }
+};
+
+template<typename T1, typename T2, std::size_t Align>
+inline bool operator==(const Aligned_allocator<T1, Align>&, const Aligned_allocator<T2, Align>&) noexcept
+{
+    return true;
+}
+
+template<typename T1, typename T2, std::size_t Align>
+inline bool operator!=(const Aligned_allocator<T1, Align>&, const Aligned_allocator<T2, Align>&) noexcept
+{
+    return false;
+}
 } // namespace cyy
 
 #endif // ALLOCATOR_H
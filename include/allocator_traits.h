@@ -37,6 +37,15 @@ struct rebind_alloc_helper<Alloc<U, Args...>, T, false>
     using type = Alloc<T, Args...>;
 };
 
+// storage returned by allocate_at_least: ptr holds count elements, count is
+// not less than the number asked for
+template<typename Pointer, typename SizeType = std::size_t>
+struct Allocation_result
+{
+    Pointer ptr;
+    SizeType count;
+};
+
 template<typename Alloc>
 struct Allocator_traits
 {
@@ -91,6 +100,15 @@ ALIAS_USING_SFINAE(propagate_on_container_move_assignment, std::false_type)
 ALIAS_USING_SFINAE(propagate_on_container_swap, std::false_type)
     using propagate_on_container_swap = _propagate_on_container_swap;
 
+// is_always_equal: Alloc::is_always_equal if present, otherwise std::is_empty<Alloc>::type
+ALIAS_USING_SFINAE(is_always_equal, typename std::is_empty<Alloc>::type)
+    using is_always_equal = _is_always_equal;
+
+// is_deallocate_noop: Alloc::is_deallocate_noop if present, otherwise std::false_type.
+// When true, containers may drop their nodes without giving them back one by one.
+ALIAS_USING_SFINAE(is_deallocate_noop, std::false_type)
+    using is_deallocate_noop = _is_deallocate_noop;
+
     // Alloc::rebind<T>::other if present, otherwise Alloc<T, Args> if this Alloc is Alloc<U, Args>
     template<typename T>
     using rebind_alloc = typename rebind_alloc_helper<Alloc, T>::type;
@@ -235,6 +253,77 @@ private:
         return a;
     }
 
+    // allocate_at_least_helper, use SFINAE
+    template<typename Alloc2>
+    struct allocate_at_least_helper
+    {
+        template<typename Alloc3, typename = decltype(std::declval<Alloc3&>().
+            allocate_at_least(std::declval<size_type>()))>
+        static std::true_type test(int);
+
+        template<typename>
+        static std::false_type test(...);
+
+        using type = decltype(test<Alloc2>(0));
+    };
+
+    template<typename Alloc2, typename = std::enable_if_t<allocate_at_least_helper<Alloc2>::type::value>>
+    static Allocation_result<pointer, size_type> allocate_at_least_impl(Alloc2& a, size_type n, int)
+    {
+        auto result = a.allocate_at_least(n);
+        return {result.ptr, result.count};
+    }
+
+    template<typename Alloc2, typename = std::enable_if_t<!allocate_at_least_helper<Alloc2>::type::value>>
+    static Allocation_result<pointer, size_type> allocate_at_least_impl(Alloc2& a, size_type n, ...)
+    {
+        return {a.allocate(n), n};
+    }
+
+    // try_expand_helper, use SFINAE
+    template<typename Alloc2>
+    struct try_expand_helper
+    {
+        template<typename Alloc3, typename = decltype(std::declval<Alloc3&>().
+            try_expand(std::declval<pointer>(), std::declval<size_type>(), std::declval<size_type>()))>
+        static std::true_type test(int);
+
+        template<typename>
+        static std::false_type test(...);
+
+        using type = decltype(test<Alloc2>(0));
+    };
+
+    template<typename Alloc2, typename = std::enable_if_t<try_expand_helper<Alloc2>::type::value>>
+    static bool try_expand_impl(Alloc2& a, pointer p, size_type n, size_type new_n, int)
+    {
+        return a.try_expand(p, n, new_n);
+    }
+
+    template<typename Alloc2, typename = std::enable_if_t<!try_expand_helper<Alloc2>::type::value>>
+    static bool try_expand_impl(Alloc2&, pointer, size_type, size_type, ...)
+    {
+        return false;
+    }
+
+    // reallocate_helper, use SFINAE
+    template<typename Alloc2>
+    struct reallocate_helper
+    {
+        template<typename Alloc3, typename = decltype(std::declval<Alloc3&>().
+            reallocate(std::declval<pointer>(), std::declval<size_type>(), std::declval<size_type>()))>
+        static std::true_type test(int);
+
+        template<typename>
+        static std::false_type test(...);
+
+        using type = decltype(test<Alloc2>(0));
+    };
+
+public:
+    // whether Alloc has reallocate(p, n, new_n)
+    using can_reallocate = typename reallocate_helper<Alloc>::type;
+
 public:
     // allocates uninitialized storage using the allocator 
     static pointer allocate(Alloc& a, size_type n)
@@ -291,6 +380,30 @@ public:
     {
         return select_impl(a, 0);
     }
+
+    // Calls a.allocate_at_least(n) if possible, the allocator then tells how
+    // many elements really fit in the storage. Otherwise returns {a.allocate(n), n}.
+    // The storage is given back by deallocate(a, ptr, count).
+    static Allocation_result<pointer, size_type> allocate_at_least(Alloc& a, size_type n)
+    {
+        return allocate_at_least_impl(a, n, 0);
+    }
+
+    // Calls a.try_expand(p, n, new_n) if possible: true if the storage of n
+    // elements at p now holds new_n elements and must be deallocated as such.
+    // Otherwise returns false, nothing changed.
+    static bool try_expand(Alloc& a, pointer p, size_type n, size_type new_n)
+    {
+        return try_expand_impl(a, p, n, new_n, 0);
+    }
+
+    // Calls a.reallocate(p, n, new_n), only if can_reallocate is true. Like
+    // realloc, the bytes are moved to the returned storage if it is not p,
+    // so it only suits trivially copyable elements.
+    static pointer reallocate(Alloc& a, pointer p, size_type n, size_type new_n)
+    {
+        return a.reallocate(p, n, new_n);
+    }
 };
 } // namespace cyy
 #endif // ALLOCATOR_TRAITS_H
\ No newline at end of file
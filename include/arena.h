@@ -0,0 +1,205 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace cyy
+{
+// Monotonic memory resource. Memory is bumped out of big blocks and never
+// given back one piece at a time: everything is released at once by reset()
+// or by the destructor.
+class Arena
+{
+public:
+    explicit Arena(std::size_t block_size = 64 * 1024) noexcept
+        : head_(nullptr), cur_(nullptr), end_(nullptr),
+          next_block_size_(block_size < sizeof(Block) * 2 ? sizeof(Block) * 2 : block_size)
+    {
+    }
+
+    Arena(const Arena&) = delete;
+
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena()
+    {
+        release_blocks(head_);
+    }
+
+    // return bytes of memory aligned to align, which must be a power of 2
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t))
+    {
+        char* p = align_up(cur_, align);
+        // aligning may step past the end of the block
+        if (cur_ == nullptr || p > end_ || bytes > static_cast<std::size_t>(end_ - p))
+        {
+            new_block(bytes + align);
+            p = align_up(cur_, align);
+        }
+        cur_ = p + bytes;
+        return p;
+    }
+
+    // Release all the memory handed out. The last block, which is the
+    // largest one, is kept for the memory allocated after.
+    void reset() noexcept
+    {
+        if (head_ == nullptr)
+        {
+            return;
+        }
+        release_blocks(head_->next);
+        head_->next = nullptr;
+        cur_ = reinterpret_cast<char*>(head_ + 1);
+    }
+
+    // release all the memory handed out and give every block back
+    void release() noexcept
+    {
+        release_blocks(head_);
+        head_ = nullptr;
+        cur_ = end_ = nullptr;
+    }
+
+    // bytes obtained from the system
+    std::size_t capacity() const noexcept
+    {
+        std::size_t n = 0;
+        for (Block* b = head_; b != nullptr; b = b->next)
+        {
+            n += b->size;
+        }
+        return n;
+    }
+
+private:
+    struct alignas(std::max_align_t) Block
+    {
+        Block* next;
+        std::size_t size;
+    };
+
+    static char* align_up(char* p, std::size_t align) noexcept
+    {
+        auto n = reinterpret_cast<std::uintptr_t>(p);
+        return p + ((align - n % align) % align);
+    }
+
+    static void release_blocks(Block* b) noexcept
+    {
+        while (b != nullptr)
+        {
+            Block* next = b->next;
+            ::operator delete(b);
+            b = next;
+        }
+    }
+
+    // the blocks grow geometrically, so that the number of them stays small
+    void new_block(std::size_t min_bytes)
+    {
+        std::size_t size = next_block_size_;
+        while (size - sizeof(Block) < min_bytes)
+        {
+            size *= 2;
+        }
+        Block* b = static_cast<Block*>(::operator new(size));
+        b->next = head_;
+        b->size = size;
+        head_ = b;
+        cur_ = reinterpret_cast<char*>(b + 1);
+        end_ = reinterpret_cast<char*>(b) + size;
+        next_block_size_ = size * 2;
+    }
+
+    Block* head_;            // the newest block
+    char* cur_;              // free memory of the newest block
+    char* end_;
+    std::size_t next_block_size_;
+};
+
+// Allocator taking its memory from an Arena. deallocate() does nothing, the
+// memory comes back when the arena is reset, so containers using it can
+// drop their nodes without walking them.
+template<typename T>
+class Arena_allocator
+{
+public:
+    using value_type      = T;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using reference       = T&;
+    using const_reference = const T&;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+    using is_deallocate_noop = std::true_type;
+
+    // constructors
+    Arena_allocator(Arena& arena) noexcept
+        : arena_(&arena)
+    {
+    }
+
+    Arena_allocator(const Arena_allocator&) noexcept = default;
+
+    template<typename P>
+    Arena_allocator(const Arena_allocator<P>& other) noexcept
+        : arena_(other.arena())
+    {
+    }
+
+    template<typename T1>
+    struct rebind
+    {
+        using other = Arena_allocator<T1>;
+    };
+
+    pointer allocate(size_type n)
+    {
+        if (n > this->max_size())
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<pointer>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(pointer, size_type) noexcept
+    {
+    }
+
+    size_type max_size() const noexcept
+    {
+        return size_type(-1) / sizeof(value_type);
+    }
+
+    // the arena memory comes from
+    Arena* arena() const noexcept
+    {
+        return arena_;
+    }
+
+private:
+    Arena* arena_;
+};
+
+template<typename T1, typename T2>
+inline bool operator==(const Arena_allocator<T1>& lhs, const Arena_allocator<T2>& rhs) noexcept
+{
+    return lhs.arena() == rhs.arena();
+}
+
+template<typename T1, typename T2>
+inline bool operator!=(const Arena_allocator<T1>& lhs, const Arena_allocator<T2>& rhs) noexcept
+{
+    return lhs.arena() != rhs.arena();
+}
+} // namespace cyy
+
+#endif // ARENA_H
@@ -0,0 +1,113 @@
+#ifndef DEFAULT_INIT_ALLOCATOR_H
+#define DEFAULT_INIT_ALLOCATOR_H
+
+#include <new>
+#include <type_traits>
+#include "allocator.h"
+#include "allocator_traits.h"
+
+namespace cyy
+{
+// Allocator whose construct(p) default-initializes instead of
+// value-initializing: resize() of a Vector<char> or Vector<float> then
+// leaves the new elements as the memory was, rather than zeroing them.
+// Everything else goes to Alloc.
+template<typename Alloc>
+class Default_init_allocator
+{
+    using Alloc_traits = cyy::Allocator_traits<Alloc>;
+
+public:
+    using value_type      = typename Alloc_traits::value_type;
+    using pointer         = typename Alloc_traits::pointer;
+    using const_pointer   = typename Alloc_traits::const_pointer;
+    using size_type       = typename Alloc_traits::size_type;
+    using difference_type = typename Alloc_traits::difference_type;
+    using propagate_on_container_copy_assignment = typename Alloc_traits::propagate_on_container_copy_assignment;
+    using propagate_on_container_move_assignment = typename Alloc_traits::propagate_on_container_move_assignment;
+    using propagate_on_container_swap = typename Alloc_traits::propagate_on_container_swap;
+    using is_always_equal = typename Alloc_traits::is_always_equal;
+    using is_deallocate_noop = typename Alloc_traits::is_deallocate_noop;
+
+    // constructors
+    Default_init_allocator() = default;
+
+    Default_init_allocator(const Alloc& alloc) noexcept
+        : alloc_(alloc)
+    {
+    }
+
+    template<typename A>
+    Default_init_allocator(const Default_init_allocator<A>& other) noexcept
+        : alloc_(other.underlying())
+    {
+    }
+
+    template<typename T1>
+    struct rebind
+    {
+        using other = Default_init_allocator<typename Alloc_traits::template rebind_alloc<T1>>;
+    };
+
+    pointer allocate(size_type n)
+    {
+        return Alloc_traits::allocate(alloc_, n);
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        Alloc_traits::deallocate(alloc_, p, n);
+    }
+
+    size_type max_size() const noexcept
+    {
+        return Alloc_traits::max_size(alloc_);
+    }
+
+    // no arguments: default-initialize
+    template<typename U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible_v<U>)
+    {
+        ::new(static_cast<void*>(p)) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        Alloc_traits::construct(alloc_, p, std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    void destroy(U* p)
+    {
+        Alloc_traits::destroy(alloc_, p);
+    }
+
+    Default_init_allocator select_on_container_copy_construction() const
+    {
+        return Default_init_allocator(Alloc_traits::select_on_container_copy_construction(alloc_));
+    }
+
+    const Alloc& underlying() const noexcept
+    {
+        return alloc_;
+    }
+
+private:
+    Alloc alloc_;
+};
+
+template<typename A1, typename A2>
+inline bool operator==(const Default_init_allocator<A1>& lhs, const Default_init_allocator<A2>& rhs) noexcept
+{
+    return lhs.underlying() == rhs.underlying();
+}
+
+template<typename A1, typename A2>
+inline bool operator!=(const Default_init_allocator<A1>& lhs, const Default_init_allocator<A2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+} // namespace cyy
+
+#endif // DEFAULT_INIT_ALLOCATOR_H
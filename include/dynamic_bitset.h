@@ -0,0 +1,552 @@
+#ifndef DYNAMIC_BITSET_H
+#define DYNAMIC_BITSET_H
+
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include "allocator.h"
+#include "allocator_traits.h"
+#include "vector.h"
+
+namespace cyy
+{
+namespace detail
+{
+inline std::size_t popcount(std::uint64_t word) noexcept
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (word * 0x0101010101010101ull) >> 56;
+#endif
+}
+
+// index of the lowest set bit, word must not be 0
+inline std::size_t countr_zero(std::uint64_t word) noexcept
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    std::size_t n = 0;
+    while ((word & 1) == 0)
+    {
+        word >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// dst[i] = op(dst[i], src[i]) over n words. The pointers don't alias, so
+// the compiler turns the loop into SIMD loads and stores.
+template<typename Operation>
+inline void bitwise_apply(std::uint64_t* __restrict dst, const std::uint64_t* __restrict src,
+                          std::size_t n, Operation op) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        dst[i] = op(dst[i], src[i]);
+    }
+}
+} // namespace detail
+
+// Sequence of bits whose size is chosen at run time, packed 64 to a word.
+// count, find_first and find_next look at a word at a time and &=, |= and
+// ^= work on whole words, vectorized. The bits of the last word past
+// size() are always 0.
+template<typename Alloc = cyy::Allocator<std::uint64_t>>
+class Dynamic_bitset
+{
+    using Words = Vector<std::uint64_t, typename Allocator_traits<Alloc>::template rebind_alloc<std::uint64_t>>;
+
+public:
+    using word_type       = std::uint64_t;
+    using size_type       = std::size_t;
+    using allocator_type  = Alloc;
+    using const_reference = bool;
+
+    constexpr static size_type bits_per_word = 64;
+    constexpr static size_type npos = static_cast<size_type>(-1);
+
+    // a proxy object to allow users to interact with individual bits
+    class reference
+    {
+    friend class Dynamic_bitset;
+    public:
+        reference& operator=(bool x) noexcept
+        {
+            if (x)
+            {
+                ref |= mask;
+            }
+            else
+            {
+                ref &= ~mask;
+            }
+            return *this;
+        }
+
+        reference& operator=(const reference& x) noexcept
+        {
+            return *this = static_cast<bool>(x);
+        }
+
+        // return the referenced bit
+        operator bool() const noexcept
+        {
+            return (ref & mask) != 0;
+        }
+
+        // return inverted referenced bit
+        bool operator~() const noexcept
+        {
+            return (ref & mask) == 0;
+        }
+
+        // inverts the referenced bit
+        reference& flip() noexcept
+        {
+            ref ^= mask;
+            return *this;
+        }
+
+    private:
+        reference(word_type& pref, word_type pmask) noexcept
+            : ref(pref), mask(pmask)
+        {
+        }
+
+        word_type& ref;
+        word_type mask;
+    };
+
+    // constructors
+    Dynamic_bitset()
+        : words(), nbits(0)
+    {
+    }
+
+    explicit Dynamic_bitset(const allocator_type& alloc)
+        : words(alloc), nbits(0)
+    {
+    }
+
+    explicit Dynamic_bitset(size_type n, bool value = false, const allocator_type& alloc = allocator_type())
+        : words(word_count(n), value ? ~word_type(0) : 0, alloc), nbits(n)
+    {
+        clear_unused_bits();
+    }
+
+    // bit i of the bitset is character size() - 1 - i of the string, as in Bitset
+    template<typename CharT, typename Traits, typename StrAlloc>
+    explicit Dynamic_bitset(const std::basic_string<CharT, Traits, StrAlloc>& str,
+                            CharT zero = CharT('0'), CharT one = CharT('1'),
+                            const allocator_type& alloc = allocator_type())
+        : Dynamic_bitset(str.size(), false, alloc)
+    {
+        for (size_type i = 0; i < nbits; ++i)
+        {
+            CharT bit = str[nbits - 1 - i];
+            if (Traits::eq(bit, one))
+            {
+                set(i);
+            }
+            else if (!Traits::eq(bit, zero))
+            {
+                throw std::invalid_argument("str can't have character other than zero or one");
+            }
+        }
+    }
+
+    // returns the associated allocator
+    allocator_type get_allocator() const
+    {
+        return words.get_allocator();
+    }
+
+    // compare the contents
+    bool operator==(const Dynamic_bitset& rhs) const
+    {
+        return nbits == rhs.nbits && words == rhs.words;
+    }
+
+    bool operator!=(const Dynamic_bitset& rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+    // access specific bit
+    bool test(size_type pos) const
+    {
+        if (pos >= nbits)
+        {
+            throw std::out_of_range("pos can't be larger than size");
+        }
+        return (*this)[pos];
+    }
+
+    // unlike test(), it doesn't check bound
+    bool operator[](size_type pos) const
+    {
+        return (words[pos / bits_per_word] & bit_mask(pos)) != 0;
+    }
+
+    reference operator[](size_type pos)
+    {
+        return reference(words[pos / bits_per_word], bit_mask(pos));
+    }
+
+    // check if all, any or none of the bits are set to true
+    bool all() const noexcept
+    {
+        return count() == nbits;
+    }
+
+    bool any() const noexcept
+    {
+        for (word_type word : words)
+        {
+            if (word != 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool none() const noexcept
+    {
+        return !any();
+    }
+
+    // count the number of bit that is true, a word at a time
+    size_type count() const noexcept
+    {
+        size_type count = 0;
+        for (word_type word : words)
+        {
+            count += detail::popcount(word);
+        }
+        return count;
+    }
+
+    // position of the first set bit, npos if there is none
+    size_type find_first() const noexcept
+    {
+        return find_from(0);
+    }
+
+    // position of the first set bit after pos, npos if there is none
+    size_type find_next(size_type pos) const noexcept
+    {
+        ++pos;
+        if (pos >= nbits)
+        {
+            return npos;
+        }
+        size_type index = pos / bits_per_word;
+        word_type word = words[index] >> (pos % bits_per_word);
+        if (word != 0)
+        {
+            return pos + detail::countr_zero(word);
+        }
+        return find_from(index + 1);
+    }
+
+    // get size
+    size_type size() const noexcept
+    {
+        return nbits;
+    }
+
+    bool empty() const noexcept
+    {
+        return nbits == 0;
+    }
+
+    size_type capacity() const noexcept
+    {
+        return words.capacity() * bits_per_word;
+    }
+
+    // number of words holding the bits, and the words themselves
+    size_type num_words() const noexcept
+    {
+        return words.size();
+    }
+
+    word_type* data() noexcept
+    {
+        return words.data();
+    }
+
+    const word_type* data() const noexcept
+    {
+        return words.data();
+    }
+
+    void reserve(size_type n)
+    {
+        words.reserve(word_count(n));
+    }
+
+    void shrink_to_fit()
+    {
+        words.shrink_to_fit();
+    }
+
+    // changes the number of bits, the new ones are value
+    void resize(size_type n, bool value = false)
+    {
+        size_type old_size = nbits;
+        words.resize(word_count(n), value ? ~word_type(0) : 0);
+        if (value && n > old_size && old_size % bits_per_word != 0)
+        {
+            words[old_size / bits_per_word] |= ~word_type(0) << (old_size % bits_per_word);
+        }
+        nbits = n;
+        clear_unused_bits();
+    }
+
+    void clear() noexcept
+    {
+        words.clear();
+        nbits = 0;
+    }
+
+    void push_back(bool value)
+    {
+        if (nbits % bits_per_word == 0)
+        {
+            words.push_back(0);
+        }
+        ++nbits;
+        set(nbits - 1, value);
+    }
+
+    void pop_back()
+    {
+        --nbits;
+        if (nbits % bits_per_word == 0)
+        {
+            words.pop_back();
+        }
+        else
+        {
+            clear_unused_bits();
+        }
+    }
+
+    // perform binary AND, OR, XOR and NOT, the sizes must be equal
+    Dynamic_bitset& operator&=(const Dynamic_bitset& other)
+    {
+        check_size(other);
+        if (&other != this)
+        {
+            detail::bitwise_apply(words.data(), other.words.data(), words.size(),
+                                  [] (word_type a, word_type b) { return a & b; });
+        }
+        return *this;
+    }
+
+    Dynamic_bitset& operator|=(const Dynamic_bitset& other)
+    {
+        check_size(other);
+        if (&other != this)
+        {
+            detail::bitwise_apply(words.data(), other.words.data(), words.size(),
+                                  [] (word_type a, word_type b) { return a | b; });
+        }
+        return *this;
+    }
+
+    Dynamic_bitset& operator^=(const Dynamic_bitset& other)
+    {
+        check_size(other);
+        if (&other == this)
+        {
+            return reset();
+        }
+        detail::bitwise_apply(words.data(), other.words.data(), words.size(),
+                              [] (word_type a, word_type b) { return a ^ b; });
+        return *this;
+    }
+
+    // clears the bits set in other: *this &= ~other
+    Dynamic_bitset& subtract(const Dynamic_bitset& other)
+    {
+        check_size(other);
+        if (&other == this)
+        {
+            return reset();
+        }
+        detail::bitwise_apply(words.data(), other.words.data(), words.size(),
+                              [] (word_type a, word_type b) { return a & ~b; });
+        return *this;
+    }
+
+    Dynamic_bitset operator~() const
+    {
+        return Dynamic_bitset(*this).flip();
+    }
+
+    // set all bits to true
+    Dynamic_bitset& set() noexcept
+    {
+        for (word_type& word : words)
+        {
+            word = ~word_type(0);
+        }
+        clear_unused_bits();
+        return *this;
+    }
+
+    // set the bit at position pos to the value.
+    Dynamic_bitset& set(size_type pos, bool value = true)
+    {
+        (*this)[pos] = value;
+        return *this;
+    }
+
+    // Sets all bits to false
+    Dynamic_bitset& reset() noexcept
+    {
+        for (word_type& word : words)
+        {
+            word = 0;
+        }
+        return *this;
+    }
+
+    Dynamic_bitset& reset(size_type pos)
+    {
+        if (pos >= nbits)
+        {
+            throw std::out_of_range("pos can't be larger than size");
+        }
+        (*this)[pos] = false;
+        return *this;
+    }
+
+    // flip bits
+    Dynamic_bitset& flip() noexcept
+    {
+        for (word_type& word : words)
+        {
+            word = ~word;
+        }
+        clear_unused_bits();
+        return *this;
+    }
+
+    Dynamic_bitset& flip(size_type pos)
+    {
+        if (pos >= nbits)
+        {
+            throw std::out_of_range("pos can't be larger than size");
+        }
+        (*this)[pos].flip();
+        return *this;
+    }
+
+    // convert the contents to a string, the highest bit first
+    template<typename CharT = char, typename Traits = std::char_traits<CharT>, typename StrAlloc = std::allocator<CharT>>
+    std::basic_string<CharT, Traits, StrAlloc> to_string(CharT zero = CharT('0'), CharT one = CharT('1')) const
+    {
+        std::basic_string<CharT, Traits, StrAlloc> ans(nbits, zero);
+        for (size_type i = find_first(); i != npos; i = find_next(i))
+        {
+            ans[nbits - 1 - i] = one;
+        }
+        return ans;
+    }
+
+    void swap(Dynamic_bitset& other)
+    {
+        words.swap(other.words);
+        std::swap(nbits, other.nbits);
+    }
+
+private:
+    static size_type word_count(size_type n) noexcept
+    {
+        return (n + bits_per_word - 1) / bits_per_word;
+    }
+
+    static word_type bit_mask(size_type pos) noexcept
+    {
+        return word_type(1) << (pos % bits_per_word);
+    }
+
+    // first set bit in the words from index on
+    size_type find_from(size_type index) const noexcept
+    {
+        for (; index < words.size(); ++index)
+        {
+            if (words[index] != 0)
+            {
+                return index * bits_per_word + detail::countr_zero(words[index]);
+            }
+        }
+        return npos;
+    }
+
+    // keep the bits of the last word past size() at 0
+    void clear_unused_bits() noexcept
+    {
+        if (nbits % bits_per_word != 0)
+        {
+            words.back() &= ~(~word_type(0) << (nbits % bits_per_word));
+        }
+    }
+
+    void check_size(const Dynamic_bitset& other) const
+    {
+        if (nbits != other.nbits)
+        {
+            throw std::invalid_argument("bitsets of different sizes");
+        }
+    }
+
+    Words words;
+    size_type nbits;
+};
+
+// perform binary logic operations on bitsets
+template<typename Alloc>
+Dynamic_bitset<Alloc> operator&(const Dynamic_bitset<Alloc>& lhs, const Dynamic_bitset<Alloc>& rhs)
+{
+    return Dynamic_bitset<Alloc>(lhs) &= rhs;
+}
+
+template<typename Alloc>
+Dynamic_bitset<Alloc> operator|(const Dynamic_bitset<Alloc>& lhs, const Dynamic_bitset<Alloc>& rhs)
+{
+    return Dynamic_bitset<Alloc>(lhs) |= rhs;
+}
+
+template<typename Alloc>
+Dynamic_bitset<Alloc> operator^(const Dynamic_bitset<Alloc>& lhs, const Dynamic_bitset<Alloc>& rhs)
+{
+    return Dynamic_bitset<Alloc>(lhs) ^= rhs;
+}
+
+template<typename Alloc>
+inline void swap(Dynamic_bitset<Alloc>& x, Dynamic_bitset<Alloc>& y)
+{
+    x.swap(y);
+}
+
+// perform stream output of bitsets
+template<typename CharT, typename Traits, typename Alloc>
+std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& os,
+                                              const Dynamic_bitset<Alloc>& x)
+{
+    return os << x.template to_string<CharT, Traits>();
+}
+
+} // namespace cyy
+
+#endif // DYNAMIC_BITSET_H
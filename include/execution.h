@@ -0,0 +1,292 @@
+#ifndef EXECUTION_H
+#define EXECUTION_H
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+#include "thread.h"
+
+namespace cyy
+{
+// Execution policy asking for work split among threads of the default
+// Thread_pool. The work is cut in threads chunks (0: one per thread of the
+// pool), none smaller than min_chunk elements, so small inputs stay on the
+// calling thread.
+struct Parallel_policy
+{
+    explicit constexpr Parallel_policy(unsigned threads = 0, std::size_t min_chunk = 1 << 15) noexcept
+        : threads(threads), min_chunk(min_chunk)
+    {
+    }
+
+    constexpr Parallel_policy with_threads(unsigned n) const noexcept
+    {
+        return Parallel_policy(n, min_chunk);
+    }
+
+    unsigned threads;
+    std::size_t min_chunk;
+};
+
+inline constexpr Parallel_policy par{};
+
+// Fixed set of cyy::Thread workers running fork-join jobs: run(tasks, f)
+// calls f(0) ... f(tasks - 1) on the workers and the calling thread, and
+// returns once all of them are done. One job runs at a time, a job started
+// from inside a task runs on the calling thread alone.
+class Thread_pool
+{
+public:
+    explicit Thread_pool(unsigned workers)
+        : workers_(new Thread[workers]), size_(0), generation_(0), stop_(false),
+          task_(nullptr), tasks_(0), next_(0), unfinished_(0), active_(0)
+    {
+        try
+        {
+            for (; size_ < workers; ++size_)
+            {
+                workers_[size_] = Thread([this] { work(); });
+            }
+        }
+        catch (...)
+        {
+            shutdown();
+            throw;
+        }
+    }
+
+    Thread_pool(const Thread_pool&) = delete;
+
+    Thread_pool& operator=(const Thread_pool&) = delete;
+
+    ~Thread_pool()
+    {
+        shutdown();
+    }
+
+    // number of threads taking part in a job, the caller included
+    unsigned concurrency() const noexcept
+    {
+        return size_ + 1;
+    }
+
+    // the first exception thrown by a task is rethrown once all have finished
+    void run(std::size_t tasks, const std::function<void(std::size_t)>& f)
+    {
+        if (tasks == 0)
+        {
+            return;
+        }
+        if (tasks == 1 || size_ == 0 || in_task())
+        {
+            for (std::size_t i = 0; i < tasks; ++i)
+            {
+                f(i);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> job_lock(job_mutex_);
+        {
+            // workers still leaving the last job must not see this one's counter
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] { return active_ == 0; });
+            task_ = &f;
+            tasks_ = tasks;
+            next_.store(0, std::memory_order_relaxed);
+            unfinished_ = tasks;
+            error_ = nullptr;
+            ++generation_;
+        }
+        start_.notify_all();
+        take_tasks(f, tasks);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return unfinished_ == 0 && active_ == 0; });
+        task_ = nullptr;
+        if (error_)
+        {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+private:
+    static bool& in_task() noexcept
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    void work()
+    {
+        in_task() = true;
+        unsigned long seen = 0;
+        for (;;)
+        {
+            const std::function<void(std::size_t)>* task;
+            std::size_t tasks;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+                if (stop_)
+                {
+                    return;
+                }
+                seen = generation_;
+                if (task_ == nullptr)
+                {
+                    continue;
+                }
+                task = task_;
+                tasks = tasks_;
+                ++active_;
+            }
+            take_tasks(*task, tasks);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_ == 0)
+            {
+                done_.notify_all();
+            }
+        }
+    }
+
+    // run tasks of the current job until none is left
+    void take_tasks(const std::function<void(std::size_t)>& f, std::size_t tasks)
+    {
+        bool was_in_task = in_task();
+        in_task() = true;
+        std::size_t finished = 0;
+        for (std::size_t i; (i = next_.fetch_add(1, std::memory_order_relaxed)) < tasks; ++finished)
+        {
+            try
+            {
+                f(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_)
+                {
+                    error_ = std::current_exception();
+                }
+            }
+        }
+        in_task() = was_in_task;
+        if (finished != 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            unfinished_ -= finished;
+            if (unfinished_ == 0 && active_ == 0)
+            {
+                done_.notify_all();
+            }
+        }
+    }
+
+    void shutdown() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            workers_[i].join();
+        }
+    }
+
+    std::unique_ptr<Thread[]> workers_;
+    unsigned size_;
+
+    std::mutex job_mutex_;
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    unsigned long generation_;
+    bool stop_;
+
+    const std::function<void(std::size_t)>* task_;
+    std::size_t tasks_;
+    std::atomic<std::size_t> next_;
+    std::size_t unfinished_;
+    unsigned active_;
+    std::exception_ptr error_;
+};
+
+// the pool used by the parallel algorithms, one worker less than the
+// hardware threads since the caller works too
+inline Thread_pool& default_thread_pool()
+{
+    static Thread_pool pool(Thread::hardware_concurrency() > 1 ? Thread::hardware_concurrency() - 1 : 0);
+    return pool;
+}
+
+namespace detail
+{
+// number of chunks n elements are cut in under policy
+inline std::size_t chunk_count(const Parallel_policy& policy, std::size_t n) noexcept
+{
+    std::size_t threads = policy.threads != 0 ? policy.threads : default_thread_pool().concurrency();
+    std::size_t min_chunk = policy.min_chunk != 0 ? policy.min_chunk : 1;
+    std::size_t by_size = n / min_chunk;
+    std::size_t chunks = by_size < threads ? by_size : threads;
+    return chunks != 0 ? chunks : 1;
+}
+
+// First element of chunk i out of chunks over n elements of elem_size
+// bytes, the first of them at base. The even split is moved back to the
+// first element starting in its 4 KB page, so that every page is first
+// touched, and placed on a NUMA node, by one thread; only an element
+// straddling two pages is shared with the chunk before.
+inline std::size_t chunk_begin(std::size_t i, std::size_t chunks, std::size_t n, std::size_t elem_size,
+                               const void* base) noexcept
+{
+    if (i >= chunks)
+    {
+        return n;
+    }
+    std::size_t begin = n / chunks * i + (n % chunks) * i / chunks;
+    auto first = reinterpret_cast<std::uintptr_t>(base);
+    std::uintptr_t page = (first + begin * elem_size) & ~std::uintptr_t(4095);
+    if (page <= first)
+    {
+        return 0;
+    }
+    return (page - first + elem_size - 1) / elem_size;
+}
+
+// call f(i, begin, end) on the default Thread_pool for each chunk i out of
+// chunks over n elements of elem_size bytes from base
+template<typename Function>
+void run_chunks(std::size_t chunks, std::size_t n, std::size_t elem_size, const void* base, Function f)
+{
+    default_thread_pool().run(chunks, [&f, chunks, n, elem_size, base] (std::size_t i) {
+        f(i, chunk_begin(i, chunks, n, elem_size, base), chunk_begin(i + 1, chunks, n, elem_size, base));
+    });
+}
+} // namespace detail
+
+// Call f(begin, end) on disjoint chunks covering [0, n), in parallel. When
+// f fills an array of elements of elem_size bytes from base, the chunks
+// start on its pages.
+template<typename Function>
+void parallel_for(const Parallel_policy& policy, std::size_t n, Function f, std::size_t elem_size = 1,
+                  const void* base = nullptr)
+{
+    detail::run_chunks(detail::chunk_count(policy, n), n, elem_size, base, [&f] (std::size_t, std::size_t begin, std::size_t end) {
+        if (begin != end)
+        {
+            f(begin, end);
+        }
+    });
+}
+} // namespace cyy
+
+#endif // EXECUTION_H
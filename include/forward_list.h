@@ -5,6 +5,8 @@
 #include "allocator.h"
 #include "aligned_buffer.h"
 #include "allocator_traits.h"
+#include "polymorphic_allocator.h"
+#include "list_sort.h"
 
 namespace cyy
 {
@@ -270,21 +272,32 @@ protected:
         Fwd_list_node_base head;
     };
 
+    // Memory of an allocator whose deallocate does nothing, like an Arena,
+    // may be reset under the list: its nodes are never kept.
+    static constexpr bool recycles_nodes = !Node_alloc_traits::is_deallocate_noop::value;
+
+    // nodes kept on the spare chain when no limit is asked for
+    static constexpr std::size_t default_spare_limit = 0;
+
     Fwd_list_impl head_impl;
+    // unconstructed nodes kept for reuse, linked by next
+    Fwd_list_node_base* spare;
+    std::size_t spare_count;
+    std::size_t spare_limit;
 
 public:
     Fwd_list_base()
-        : head_impl()
+        : head_impl(), spare(nullptr), spare_count(0), spare_limit(default_spare_limit)
     {
     }
 
     Fwd_list_base(const Node_alloc& alloc)
-        : head_impl(alloc)
+        : head_impl(alloc), spare(nullptr), spare_count(0), spare_limit(default_spare_limit)
     {
     }
 
     Fwd_list_base(Fwd_list_base&& list, const Node_alloc& alloc)
-        : head_impl(alloc)
+        : head_impl(alloc), spare(nullptr), spare_count(0), spare_limit(default_spare_limit)
     {
         if (list.get_node_allocator() == alloc)
         {
@@ -306,16 +319,20 @@ public:
         }
     }
 
+    // the spare nodes go with the allocator
     Fwd_list_base(Fwd_list_base&& list)
-        : head_impl(std::move(list.get_node_allocator()))
+        : head_impl(std::move(list.get_node_allocator())), spare(nullptr), spare_count(0), spare_limit(default_spare_limit)
     {
         head_impl.head.next = list.head_impl.head.next;
         list.head_impl.head.next = nullptr;
+        swap_spare(list);
     }
 
     ~Fwd_list_base()
     {
+        spare_limit = 0;
         erase_after_impl(&head_impl.head, nullptr);
+        release_spare();
     }
 
 protected:
@@ -341,12 +358,20 @@ protected:
         Allocator alloc(get_node_allocator());
         cyy::Allocator_traits<Allocator>::destroy(alloc, curr->valptr());
         Node_alloc_traits::destroy(get_node_allocator(), curr);
-        put_node(curr);
+        recycle_node(curr);
         return pos->next;
     }
 
+    // the nodes go to the spare chain while it has room
     Fwd_list_node_base* erase_after_impl(Fwd_list_node_base* pos, Fwd_list_node_base* last)
     {
+        using noop = typename Node_alloc_traits::is_deallocate_noop;
+        // nothing to destroy and nothing to give back, the nodes are just unlinked
+        if constexpr (noop::value && std::is_trivially_destructible<T>::value)
+        {
+            pos->next = last;
+            return last;
+        }
         Node* curr = static_cast<Node*>(pos->next);
         Allocator alloc(get_node_allocator());
         while (curr != last)
@@ -354,7 +379,7 @@ protected:
             Node* tmp = static_cast<Node*>(curr->next);
             cyy::Allocator_traits<Allocator>::destroy(alloc, curr->valptr());
             Node_alloc_traits::destroy(get_node_allocator(), curr);
-            put_node(curr);
+            recycle_node(curr);
             curr = tmp;
         }
         pos->next = last;
@@ -371,8 +396,16 @@ protected:
         return static_cast<const Node_alloc&>(head_impl);
     }
 
+    // a node from the spare chain, or a new one
     Node* get_node()
     {
+        if (spare != nullptr)
+        {
+            Fwd_list_node_base* p = spare;
+            spare = p->next;
+            --spare_count;
+            return static_cast<Node*>(p);
+        }
         auto ptr = Node_alloc_traits::allocate(get_node_allocator(), 1);
         return std::addressof(*ptr);
     }
@@ -384,6 +417,58 @@ protected:
         Node_alloc_traits::deallocate(get_node_allocator(), ptr, 1);
     }
 
+    // keep a node whose element is destroyed on the spare chain if it has
+    // room, give it back otherwise
+    void recycle_node(Node* p) noexcept
+    {
+        if (recycles_nodes && spare_count < spare_limit)
+        {
+            Fwd_list_node_base* n = ::new (static_cast<void*>(p)) Fwd_list_node_base();
+            n->next = spare;
+            spare = n;
+            ++spare_count;
+        }
+        else
+        {
+            put_node(p);
+        }
+    }
+
+    // make the spare chain hold n nodes at least and keep up to limit
+    void reserve_spare(std::size_t n, std::size_t limit)
+    {
+        if constexpr (!recycles_nodes)
+        {
+            return;
+        }
+        spare_limit = std::max(spare_limit, limit);
+        while (spare_count < n)
+        {
+            Fwd_list_node_base* p = ::new (static_cast<void*>(std::addressof(*Node_alloc_traits::allocate(get_node_allocator(), 1)))) Fwd_list_node_base();
+            p->next = spare;
+            spare = p;
+            ++spare_count;
+        }
+    }
+
+    void release_spare() noexcept
+    {
+        while (spare != nullptr)
+        {
+            Fwd_list_node_base* p = spare;
+            spare = p->next;
+            put_node(static_cast<Node*>(p));
+        }
+        spare_count = 0;
+    }
+
+    void swap_spare(Fwd_list_base& other) noexcept
+    {
+        std::swap(spare, other.spare);
+        std::swap(spare_count, other.spare_count);
+        std::swap(spare_limit, other.spare_limit);
+    }
+
     template<typename... Args>
     Node* create_node(Args&&... args)
     {
@@ -396,7 +481,7 @@ protected:
         }
         catch (...)
         {
-            put_node(node);
+            recycle_node(node);
             throw;
         }
         return node;
@@ -470,7 +555,7 @@ public:
     }
 
     Forward_list(const Forward_list& other)
-        : Base(other.get_node_allocator())
+        : Base(Node_alloc_traits::select_on_container_copy_construction(other.get_node_allocator()))
     {
         range_initialize(other.begin(), other.end());
     }
@@ -506,29 +591,34 @@ public:
         if (&other == this)
             return *this;
 
-        if (Alloc_traits::propagate_on_container_copy_assignment::value)
+        if constexpr (Alloc_traits::propagate_on_container_copy_assignment::value)
         {
+            // the nodes must go back to the allocator they came from
+            if (get_node_allocator() != other.get_node_allocator())
+            {
+                erase_after_impl(&head_impl.head, nullptr);
+                Base::release_spare();
+            }
             get_node_allocator() = other.get_node_allocator();
         }
-
-        if (get_node_allocator() != other.get_node_allocator())
-        {
-            erase_after_impl(&head_impl.head, nullptr);
-        }
         assign(other.begin(), other.end());
         return *this;
     }
 
     Forward_list& operator=(Forward_list&& other)
     {
-        if (Alloc_traits::propagate_on_container_move_assignment::value)
-        {
-            get_node_allocator() = other.get_node_allocator();
-        }
-
-        if (get_node_allocator() == other.get_node_allocator())
+        if (Alloc_traits::propagate_on_container_move_assignment::value
+            || get_node_allocator() == other.get_node_allocator())
         {
             erase_after_impl(&head_impl.head, nullptr);
+            if constexpr (Alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                if (get_node_allocator() != other.get_node_allocator())
+                {
+                    Base::release_spare();
+                }
+                get_node_allocator() = std::move(other.get_node_allocator());
+            }
             std::swap(head_impl.head.next, other.head_impl.head.next);
         }
         else
@@ -671,12 +761,38 @@ public:
         return Node_alloc_traits::max_size(get_node_allocator());
     }
 
-    // clear the contents
+    // clear the contents, the nodes are kept for reuse up to the limit set
+    // by reserve_nodes
     void clear() noexcept
     {
         erase_after_impl(&head_impl.head, nullptr);
     }
 
+    // Keep nodes for n elements: the list then grows to n elements with no
+    // allocation, and the nodes of up to n erased elements are kept for
+    // the next ones instead of being given back. Without it none are kept,
+    // nor with an allocator whose deallocate does nothing. The elements
+    // are counted.
+    void reserve_nodes(size_type n)
+    {
+        size_type size = std::distance(cbegin(), cend());
+        Base::reserve_spare(n > size ? n - size : 0, n);
+    }
+
+    // give back the spare nodes, and keep none from then on
+    void release_nodes() noexcept
+    {
+        Base::release_spare();
+        Base::spare_limit = Base::default_spare_limit;
+    }
+
+    // number of elements the list can hold without allocating, the
+    // elements are counted
+    size_type node_capacity() const noexcept
+    {
+        return std::distance(cbegin(), cend()) + Base::spare_count;
+    }
+
     // insert elements after an element
     iterator insert_after(const_iterator pos, const value_type& value)
     {
@@ -770,8 +886,13 @@ public:
     // swap the contents
     void swap(Forward_list& other)
     {
-        if (Node_alloc_traits::propagate_on_container_swap::value)
-            std::swap(head_impl.head.next, other.head_impl.head.next);
+        if constexpr (Node_alloc_traits::propagate_on_container_swap::value)
+        {
+            // the spare nodes go with the allocator
+            std::swap(get_node_allocator(), other.get_node_allocator());
+            Base::swap_spare(other);
+        }
+        std::swap(head_impl.head.next, other.head_impl.head.next);
     }
 
     // merge two sorted lists
@@ -952,10 +1073,30 @@ public:
         sort([] (const value_type& lhs, const value_type& rhs) { return lhs < rhs; });
     }
 
+    void sort(Sort_mode mode)
+    {
+        sort([] (const value_type& lhs, const value_type& rhs) { return lhs < rhs; }, mode);
+    }
+
+    // stable, the nodes are relinked and no element is moved
     template <typename Compare>
-    void sort(Compare comp)
+    void sort(Compare comp, Sort_mode mode = Sort_mode::automatic)
     {
-        head_impl.head.next =  merge_sort(head_impl.head.next, comp);
+        Node_base* first = head_impl.head.next;
+        if (mode == Sort_mode::index
+            || (mode == Sort_mode::automatic && detail::length_at_least(first, static_cast<Node_base*>(nullptr), detail::index_sort_threshold)))
+        {
+            Node_base* prev = &head_impl.head;
+            // the length is only known to be the threshold at least in automatic mode
+            std::size_t count = mode == Sort_mode::automatic ? detail::index_sort_threshold : 0;
+            detail::index_sort(first, static_cast<Node_base*>(nullptr), count,
+                [] (Node_base* p) -> const value_type& { return *static_cast<Node*>(p)->valptr(); },
+                comp,
+                [&prev] (Node_base* p) { prev->next = p; prev = p; });
+            prev->next = nullptr;
+            return;
+        }
+        head_impl.head.next =  merge_sort(first, comp);
     }
 
 private:
@@ -1069,20 +1210,8 @@ private:
         }
     }
 
-    // used for sort
-
-    Node_base* get_mid_node(Node_base* head)
-    {
-        Node_base* one_step = head;
-        Node_base* two_step = head;
-        while (two_step && two_step->next)
-        {
-            one_step = one_step->next;
-            two_step = two_step->next;
-        }
-        return one_step;
-    }
-
+    // merge the sorted lists @l1 and @l2, the nodes of @l1 first among
+    // equal ones
     template<typename Compare>
     Node_base* merge(Node_base* l1, Node_base* l2, Compare comp)
     {
@@ -1091,52 +1220,59 @@ private:
 
         while (l1 && l2)
         {
-            if (comp(*static_cast<Node*>(l1)->valptr(),
-                  *static_cast<Node*>(l2)->valptr()))
-            {
-                head->next = l1;
-                head = l1;
-                l1 = l1->next;
-            }
-            else
+            if (comp(*static_cast<Node*>(l2)->valptr(),
+                  *static_cast<Node*>(l1)->valptr()))
             {
                 head->next = l2;
                 head = l2;
                 l2 = l2->next;
             }
+            else
+            {
+                head->next = l1;
+                head = l1;
+                l1 = l1->next;
+            }
         }
-
-        auto l = l1 ? l1 : l2;
-        while (l)
-        {
-            head->next = l;
-            head = l;
-            l = l->next;
-        }
+        head->next = l1 ? l1 : l2;
 
         return tmp.next;
     }
 
+    // Bottom-up merge sort: nodes are taken one by one and merged into
+    // bins, bin i holds 2^i nodes or none. No walk looks for a middle and
+    // there is no recursion.
     template<typename Compare>
     Node_base* merge_sort(Node_base* head, Compare comp)
     {
-        if (head == nullptr || head->next == nullptr)
-            return head;
-        Node_base* mid = get_mid_node(head);
-        Node_base* mid_next;
-        if (mid->next == nullptr)
+        Node_base* bins[64] = {};
+        std::size_t fill = 0;
+        while (head != nullptr)
         {
-            mid_next = head->next;
-            head->next = nullptr;
+            Node_base* carry = head;
+            head = head->next;
+            carry->next = nullptr;
+            std::size_t i = 0;
+            for (; i < fill && bins[i] != nullptr; ++i)
+            {
+                carry = merge(bins[i], carry, comp);
+                bins[i] = nullptr;
+            }
+            bins[i] = carry;
+            if (i == fill)
+            {
+                ++fill;
+            }
         }
-        else
+        Node_base* result = nullptr;
+        for (std::size_t i = 0; i < fill; ++i)
         {
-            mid_next = mid->next;
-            mid->next = nullptr;
+            if (bins[i] != nullptr)
+            {
+                result = result ? merge(bins[i], result, comp) : bins[i];
+            }
         }
-        Node_base* l1 = merge_sort(head, comp);
-        Node_base* l2 = merge_sort(mid_next, comp);
-        return merge(l1, l2, comp);
+        return result;
     }
 }; // class Forward_list
 
@@ -1151,7 +1287,7 @@ bool operator==(const Forward_list<T,Alloc>& lhs,
         if (*lhs_it != *rhs_it)
             return false;
     }
-    return lhs_it == lhs.cend() && rhs_it == rhs_it.cend();
+    return lhs_it == lhs.cend() && rhs_it == rhs.cend();
 }
 
 template<typename T, typename Alloc>
@@ -1190,6 +1326,11 @@ bool operator<=(const Forward_list<T,Alloc>& lhs,
     return !(rhs < lhs);
 }
 
+namespace pmr
+{
+template<typename T>
+using Forward_list = cyy::Forward_list<T, polymorphic_allocator<T>>;
+} // namespace pmr
 } // namespace cyy
 
 #endif // FORWARD_LIST_H
\ No newline at end of file
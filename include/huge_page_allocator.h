@@ -0,0 +1,320 @@
+#ifndef HUGE_PAGE_ALLOCATOR_H
+#define HUGE_PAGE_ALLOCATOR_H
+
+#include <new>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "SGI_alloc.h"
+
+namespace cyy
+{
+namespace detail
+{
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+// smaller allocations would waste most of a huge page, they go to operator new
+constexpr std::size_t HUGE_PAGE_THRESHOLD = HUGE_PAGE_SIZE / 2;
+
+inline std::size_t huge_page_round(std::size_t bytes) noexcept
+{
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+// Set the memory policy of [p, p + len) to the NUMA node, through the mbind
+// system call so that libnuma is not needed. Return false if the kernel
+// can't, then the pages go to the node of the thread touching them first.
+inline bool bind_to_node(void* p, std::size_t len, int node) noexcept
+{
+#ifdef SYS_mbind
+    constexpr int MPOL_BIND_MODE = 2;
+    constexpr int MASK_WORDS = 16;
+    constexpr int MASK_BITS = MASK_WORDS * sizeof(unsigned long) * CHAR_BIT;
+    if (node < 0 || node >= MASK_BITS)
+    {
+        return false;
+    }
+    unsigned long mask[MASK_WORDS] = {};
+    mask[node / (sizeof(unsigned long) * CHAR_BIT)] = 1UL << (node % (sizeof(unsigned long) * CHAR_BIT));
+    return ::syscall(SYS_mbind, p, len, MPOL_BIND_MODE, mask, MASK_BITS + 1, 0) == 0;
+#else
+    (void)p; (void)len; (void)node;
+    return false;
+#endif
+}
+
+// Map bytes rounded up to 2 MB. Reserved huge pages (MAP_HUGETLB) are used
+// if there are any, otherwise normal pages aligned to 2 MB are mapped and
+// advised for transparent huge pages, which the kernel may or may not give.
+// If node is not negative the pages are bound to that NUMA node.
+// Return nullptr if no memory can be mapped.
+inline void* map_huge_pages(std::size_t bytes, int node = -1) noexcept
+{
+    std::size_t len = huge_page_round(bytes);
+    void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (p == MAP_FAILED)
+    {
+        // map one more huge page and cut the ends, so that the range is aligned
+        std::size_t over = len + HUGE_PAGE_SIZE;
+        char* q = static_cast<char*>(::mmap(nullptr, over, PROT_READ | PROT_WRITE,
+                                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (q == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        auto addr = reinterpret_cast<std::uintptr_t>(q);
+        char* start = q + ((HUGE_PAGE_SIZE - addr % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE);
+        if (start != q)
+        {
+            ::munmap(q, start - q);
+        }
+        if (start + len != q + over)
+        {
+            ::munmap(start + len, q + over - (start + len));
+        }
+        p = start;
+#ifdef MADV_HUGEPAGE
+        ::madvise(p, len, MADV_HUGEPAGE);
+#endif
+    }
+    if (node >= 0)
+    {
+        bind_to_node(p, len, node);
+    }
+    return p;
+}
+
+inline void unmap_huge_pages(void* p, std::size_t bytes) noexcept
+{
+    ::munmap(p, huge_page_round(bytes));
+}
+
+template<typename T>
+T* huge_page_allocate(std::size_t n, int node)
+{
+    if (n > std::size_t(-1) / sizeof(T))
+    {
+        throw std::bad_alloc();
+    }
+    std::size_t bytes = n * sizeof(T);
+    if (bytes < HUGE_PAGE_THRESHOLD)
+    {
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            return static_cast<T*>(::operator new(bytes, std::align_val_t(alignof(T))));
+        }
+        else
+        {
+            return static_cast<T*>(::operator new(bytes));
+        }
+    }
+    void* p = map_huge_pages(bytes, node);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return static_cast<T*>(p);
+}
+
+template<typename T>
+void huge_page_deallocate(T* p, std::size_t n) noexcept
+{
+    std::size_t bytes = n * sizeof(T);
+    if (bytes < HUGE_PAGE_THRESHOLD)
+    {
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ::operator delete(p, std::align_val_t(alignof(T)));
+        }
+        else
+        {
+            ::operator delete(p);
+        }
+    }
+    else
+    {
+        unmap_huge_pages(p, bytes);
+    }
+}
+} // namespace detail
+
+// Allocator for large buffers such as the storage of a big Vector: allocations
+// of 1 MB or more are mapped on 2 MB pages, fewer TLB entries then cover
+// them. Smaller ones come from operator new.
+template<typename T>
+class Huge_page_allocator
+{
+public:
+    using value_type      = T;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using reference       = T&;
+    using const_reference = const T&;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    // constructors
+    Huge_page_allocator() noexcept { }
+
+    Huge_page_allocator(const Huge_page_allocator&) noexcept { }
+
+    Huge_page_allocator& operator=(const Huge_page_allocator&) noexcept = default;
+
+    template<typename P>
+    Huge_page_allocator(const Huge_page_allocator<P>&) noexcept { }
+
+    template<typename T1>
+    struct rebind
+    {
+        using other = Huge_page_allocator<T1>;
+    };
+
+    pointer allocate(size_type n)
+    {
+        return detail::huge_page_allocate<T>(n, -1);
+    }
+
+    void deallocate(pointer p, size_type n) noexcept
+    {
+        detail::huge_page_deallocate(p, n);
+    }
+
+    size_type max_size() const noexcept
+    {
+        return size_type(-1) / sizeof(value_type);
+    }
+};
+
+template<typename T1, typename T2>
+inline bool operator==(const Huge_page_allocator<T1>&, const Huge_page_allocator<T2>&) noexcept
+{
+    return true;
+}
+
+template<typename T1, typename T2>
+inline bool operator!=(const Huge_page_allocator<T1>&, const Huge_page_allocator<T2>&) noexcept
+{
+    return false;
+}
+
+// Huge_page_allocator whose large allocations are bound to a NUMA node with
+// mbind. With a negative node, or where mbind fails, the pages are left
+// untouched and the kernel places each of them on the node of the thread
+// writing it first, so the buffer should be filled by the threads using it.
+// The node follows the container on copy, move and swap. Any Numa_allocator
+// can deallocate the memory of another one.
+template<typename T>
+class Numa_allocator
+{
+public:
+    using value_type      = T;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using reference       = T&;
+    using const_reference = const T&;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::true_type;
+
+    // constructors
+    explicit Numa_allocator(int node = -1) noexcept
+        : node_(node)
+    {
+    }
+
+    Numa_allocator(const Numa_allocator&) noexcept = default;
+
+    template<typename P>
+    Numa_allocator(const Numa_allocator<P>& other) noexcept
+        : node_(other.node())
+    {
+    }
+
+    template<typename T1>
+    struct rebind
+    {
+        using other = Numa_allocator<T1>;
+    };
+
+    pointer allocate(size_type n)
+    {
+        return detail::huge_page_allocate<T>(n, node_);
+    }
+
+    void deallocate(pointer p, size_type n) noexcept
+    {
+        detail::huge_page_deallocate(p, n);
+    }
+
+    size_type max_size() const noexcept
+    {
+        return size_type(-1) / sizeof(value_type);
+    }
+
+    // the NUMA node of the memory, negative for first touch
+    int node() const noexcept
+    {
+        return node_;
+    }
+
+private:
+    int node_;
+};
+
+template<typename T1, typename T2>
+inline bool operator==(const Numa_allocator<T1>&, const Numa_allocator<T2>&) noexcept
+{
+    return true;
+}
+
+template<typename T1, typename T2>
+inline bool operator!=(const Numa_allocator<T1>&, const Numa_allocator<T2>&) noexcept
+{
+    return false;
+}
+
+// chunk source of __default_alloc_template mapping its chunks on huge pages
+struct __huge_page_chunk_source
+{
+    static std::size_t good_size(std::size_t n)
+    {
+        return detail::huge_page_round(n);
+    }
+
+    static void * allocate(std::size_t n)
+    {
+        return detail::map_huge_pages(n);
+    }
+
+    static void * oom_allocate(std::size_t n)
+    {
+        void * p = detail::map_huge_pages(n);
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    static void deallocate(void * p, std::size_t n)
+    {
+        detail::unmap_huge_pages(p, n);
+    }
+};
+
+// node allocator carving its blocks from huge pages
+using huge_page_alloc = __default_alloc_template<true, 0, __default_size_class, __huge_page_chunk_source>;
+} // namespace cyy
+
+#endif // HUGE_PAGE_ALLOCATOR_H
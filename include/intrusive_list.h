@@ -0,0 +1,869 @@
+#ifndef INTRUSIVE_LIST_H
+#define INTRUSIVE_LIST_H
+
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include "list.h"
+#include "forward_list.h"
+
+namespace cyy
+{
+struct List_hook;
+struct Forward_list_hook;
+
+template<typename T, List_hook T::* Hook>
+class Intrusive_list;
+template<typename T, Forward_list_hook T::* Hook>
+class Intrusive_forward_list;
+
+// Links an object into an Intrusive_list, as a member of it. Copying the
+// object does not copy the links: the copy starts unlinked.
+struct List_hook : detail::List_node_base
+{
+    List_hook() = default;
+
+    List_hook(const List_hook&) noexcept
+        : List_node_base()
+    {
+    }
+
+    List_hook& operator=(const List_hook&) noexcept
+    {
+        return *this;
+    }
+
+    // whether the object is on a list
+    bool is_linked() const noexcept
+    {
+        return next != nullptr;
+    }
+};
+
+// Links an object into an Intrusive_forward_list, as a member of it.
+struct Forward_list_hook : detail::Fwd_list_node_base
+{
+    Forward_list_hook() = default;
+
+    Forward_list_hook(const Forward_list_hook&) noexcept
+        : Fwd_list_node_base()
+    {
+    }
+
+    Forward_list_hook& operator=(const Forward_list_hook&) noexcept
+    {
+        return *this;
+    }
+};
+
+namespace detail
+{
+// The object holding the hook at member Hook, from the hook. Only the
+// address of the member of a probe is taken, no object is read.
+template<typename T, typename H, H T::* Hook>
+struct Hook_owner
+{
+    static std::ptrdiff_t offset() noexcept
+    {
+        alignas(T) static unsigned char probe[sizeof(T)];
+        T* t = reinterpret_cast<T*>(probe);
+        return reinterpret_cast<unsigned char*>(std::addressof(t->*Hook)) - probe;
+    }
+
+    static T* get(H* hook) noexcept
+    {
+        return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(hook) - offset());
+    }
+};
+
+// iterator of Intrusive_list, over the List_node_base of the hooks
+template<typename T, List_hook T::* Hook, typename Ref, typename Ptr>
+class Intrusive_list_iterator
+{
+    template<typename U, List_hook U::* H, typename R, typename P>
+    friend class Intrusive_list_iterator;
+
+    template<typename U, List_hook U::* H>
+    friend class cyy::Intrusive_list;
+
+public:
+    using self = Intrusive_list_iterator;
+
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::remove_cv_t<T>;
+    using pointer = Ptr;
+    using reference = Ref;
+
+    Intrusive_list_iterator() noexcept
+        : node(nullptr)
+    {
+    }
+
+    explicit Intrusive_list_iterator(List_node_base* n) noexcept
+        : node(n)
+    {
+    }
+
+    // iterator to const_iterator
+    template<typename R, typename P, typename = std::enable_if_t<std::is_convertible_v<P, Ptr>>>
+    Intrusive_list_iterator(const Intrusive_list_iterator<T, Hook, R, P>& other) noexcept
+        : node(other.node)
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+        return *Hook_owner<T, List_hook, Hook>::get(static_cast<List_hook*>(node));
+    }
+
+    pointer operator->() const noexcept
+    {
+        return Hook_owner<T, List_hook, Hook>::get(static_cast<List_hook*>(node));
+    }
+
+    self& operator++() noexcept
+    {
+        node = node->next;
+        return *this;
+    }
+
+    self operator++(int) noexcept
+    {
+        auto tmp = *this;
+        node = node->next;
+        return tmp;
+    }
+
+    self& operator--() noexcept
+    {
+        node = node->prev;
+        return *this;
+    }
+
+    self operator--(int) noexcept
+    {
+        auto tmp = *this;
+        node = node->prev;
+        return tmp;
+    }
+
+    template<typename R, typename P>
+    bool operator==(const Intrusive_list_iterator<T, Hook, R, P>& other) const noexcept
+    {
+        return node == other.node;
+    }
+
+    template<typename R, typename P>
+    bool operator!=(const Intrusive_list_iterator<T, Hook, R, P>& other) const noexcept
+    {
+        return node != other.node;
+    }
+
+private:
+    List_node_base* node;
+};
+
+// iterator of Intrusive_forward_list, the end is nullptr
+template<typename T, Forward_list_hook T::* Hook, typename Ref, typename Ptr>
+class Intrusive_forward_list_iterator
+{
+    template<typename U, Forward_list_hook U::* H, typename R, typename P>
+    friend class Intrusive_forward_list_iterator;
+
+    template<typename U, Forward_list_hook U::* H>
+    friend class cyy::Intrusive_forward_list;
+
+public:
+    using self = Intrusive_forward_list_iterator;
+
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_cv_t<T>;
+    using pointer = Ptr;
+    using reference = Ref;
+
+    Intrusive_forward_list_iterator() noexcept
+        : node(nullptr)
+    {
+    }
+
+    explicit Intrusive_forward_list_iterator(Fwd_list_node_base* n) noexcept
+        : node(n)
+    {
+    }
+
+    // iterator to const_iterator
+    template<typename R, typename P, typename = std::enable_if_t<std::is_convertible_v<P, Ptr>>>
+    Intrusive_forward_list_iterator(const Intrusive_forward_list_iterator<T, Hook, R, P>& other) noexcept
+        : node(other.node)
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+        return *Hook_owner<T, Forward_list_hook, Hook>::get(static_cast<Forward_list_hook*>(node));
+    }
+
+    pointer operator->() const noexcept
+    {
+        return Hook_owner<T, Forward_list_hook, Hook>::get(static_cast<Forward_list_hook*>(node));
+    }
+
+    self& operator++() noexcept
+    {
+        node = node->next;
+        return *this;
+    }
+
+    self operator++(int) noexcept
+    {
+        auto tmp = *this;
+        node = node->next;
+        return tmp;
+    }
+
+    template<typename R, typename P>
+    bool operator==(const Intrusive_forward_list_iterator<T, Hook, R, P>& other) const noexcept
+    {
+        return node == other.node;
+    }
+
+    template<typename R, typename P>
+    bool operator!=(const Intrusive_forward_list_iterator<T, Hook, R, P>& other) const noexcept
+    {
+        return node != other.node;
+    }
+
+private:
+    Fwd_list_node_base* node;
+};
+} // namespace detail
+
+// Doubly linked list of objects that carry their links in a List_hook
+// member, Hook. Nothing is allocated, copied or destroyed: the list links
+// and unlinks objects owned elsewhere, which must outlive their time on
+// it. An object is on one list per hook it has. Unlinking, from any
+// position and given the object alone through iterator_to, is O(1), as
+// List does with its nodes. A hook is reset when its object leaves the
+// list, so that is_linked() tells whether it is on one.
+template<typename T, List_hook T::* Hook>
+class Intrusive_list
+{
+    using node_base = detail::List_node_base;
+
+public:
+    using value_type             = T;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T&;
+    using const_reference        = const T&;
+    using pointer                = T*;
+    using const_pointer          = const T*;
+    using iterator               = detail::Intrusive_list_iterator<T, Hook, T&, T*>;
+    using const_iterator         = detail::Intrusive_list_iterator<T, Hook, const T&, const T*>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    Intrusive_list() noexcept
+        : size_(0)
+    {
+        init();
+    }
+
+    Intrusive_list(const Intrusive_list&) = delete;
+
+    Intrusive_list(Intrusive_list&& other) noexcept
+        : size_(0)
+    {
+        init();
+        swap(other);
+    }
+
+    Intrusive_list& operator=(const Intrusive_list&) = delete;
+
+    Intrusive_list& operator=(Intrusive_list&& other) noexcept
+    {
+        if (&other != this)
+        {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    // the objects left are unlinked
+    ~Intrusive_list()
+    {
+        clear();
+    }
+
+    // access the first element
+    reference front() noexcept
+    {
+        return *begin();
+    }
+
+    const_reference front() const noexcept
+    {
+        return *begin();
+    }
+
+    // access the last element
+    reference back() noexcept
+    {
+        return *--end();
+    }
+
+    const_reference back() const noexcept
+    {
+        return *--end();
+    }
+
+    // iterators
+    iterator begin() noexcept
+    {
+        return iterator(head_.next);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(head_.next);
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(&head_);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(const_cast<node_base*>(&head_));
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    // the position of an object on the list
+    static iterator iterator_to(T& value) noexcept
+    {
+        return iterator(&(value.*Hook));
+    }
+
+    static const_iterator iterator_to(const T& value) noexcept
+    {
+        return const_iterator(const_cast<List_hook*>(&(value.*Hook)));
+    }
+
+    // capacity
+    bool empty() const noexcept
+    {
+        return head_.next == &head_;
+    }
+
+    size_type size() const noexcept
+    {
+        return size_;
+    }
+
+    // modifiers
+
+    // unlink all the objects
+    void clear() noexcept
+    {
+        for (node_base* p = head_.next; p != &head_; )
+        {
+            node_base* next = p->next;
+            p->prev = nullptr;
+            p->next = nullptr;
+            p = next;
+        }
+        init();
+        size_ = 0;
+    }
+
+    // link value before pos, it must not be on a list
+    iterator insert(const_iterator pos, T& value) noexcept
+    {
+        node_base* n = &(value.*Hook);
+        n->hook(pos.node->prev);
+        ++size_;
+        return iterator(n);
+    }
+
+    // unlink the object at pos
+    iterator erase(const_iterator pos) noexcept
+    {
+        node_base* n = pos.node;
+        node_base* next = n->next;
+        n->prev->connect(next);
+        n->prev = nullptr;
+        n->next = nullptr;
+        --size_;
+        return iterator(next);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) noexcept
+    {
+        while (first != last)
+        {
+            first = erase(first);
+        }
+        return iterator(last.node);
+    }
+
+    void push_back(T& value) noexcept
+    {
+        insert(cend(), value);
+    }
+
+    void pop_back() noexcept
+    {
+        erase(--cend());
+    }
+
+    void push_front(T& value) noexcept
+    {
+        insert(cbegin(), value);
+    }
+
+    void pop_front() noexcept
+    {
+        erase(cbegin());
+    }
+
+    void swap(Intrusive_list& other) noexcept
+    {
+        std::swap(head_.next, other.head_.next);
+        std::swap(head_.prev, other.head_.prev);
+        std::swap(size_, other.size_);
+        relink_head(other);
+        other.relink_head(*this);
+    }
+
+    // move objects from another list, in O(1) except for a range of
+    // another list, which is counted
+    void splice(const_iterator pos, Intrusive_list& other) noexcept
+    {
+        if (&other != this && !other.empty())
+        {
+            size_type n = other.size_;
+            transfer(pos.node, other.head_.next, &other.head_);
+            size_ += n;
+            other.size_ = 0;
+        }
+    }
+
+    void splice(const_iterator pos, Intrusive_list&& other) noexcept
+    {
+        splice(pos, other);
+    }
+
+    void splice(const_iterator pos, Intrusive_list& other, const_iterator it) noexcept
+    {
+        node_base* n = it.node;
+        if (pos.node == n || pos.node == n->next)
+        {
+            return;
+        }
+        transfer(pos.node, n, n->next);
+        --other.size_;
+        ++size_;
+    }
+
+    void splice(const_iterator pos, Intrusive_list&& other, const_iterator it) noexcept
+    {
+        splice(pos, other, it);
+    }
+
+    void splice(const_iterator pos, Intrusive_list& other, const_iterator first, const_iterator last) noexcept
+    {
+        if (first == last)
+        {
+            return;
+        }
+        if (&other != this)
+        {
+            size_type n = std::distance(first, last);
+            other.size_ -= n;
+            size_ += n;
+        }
+        transfer(pos.node, first.node, last.node);
+    }
+
+    void splice(const_iterator pos, Intrusive_list&& other, const_iterator first, const_iterator last) noexcept
+    {
+        splice(pos, other, first, last);
+    }
+
+    // unlink the objects satisfying specific criteria
+    template<typename UnaryPredicate>
+    void remove_if(UnaryPredicate p)
+    {
+        for (auto it = begin(); it != end(); )
+        {
+            if (p(*it))
+                it = erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // reverse the order of the objects
+    void reverse() noexcept
+    {
+        node_base* p = &head_;
+        do
+        {
+            std::swap(p->next, p->prev);
+            p = p->prev;
+        } while (p != &head_);
+    }
+
+private:
+    void init() noexcept
+    {
+        head_.prev = &head_;
+        head_.next = &head_;
+    }
+
+    // point the first and last nodes back at the head after the links of
+    // the head were swapped with other's
+    void relink_head(Intrusive_list& other) noexcept
+    {
+        if (head_.next == &other.head_)
+        {
+            init();
+        }
+        else
+        {
+            head_.next->prev = &head_;
+            head_.prev->next = &head_;
+        }
+    }
+
+    // move the nodes from first up to last before pos
+    static void transfer(node_base* pos, node_base* first, node_base* last) noexcept
+    {
+        node_base* tail = last->prev;
+        first->prev->connect(last);
+        pos->prev->connect(first);
+        tail->connect(pos);
+    }
+
+    node_base head_;
+    size_type size_;
+};
+
+// Singly linked list of objects that carry their link in a
+// Forward_list_hook member, Hook, with the interface of Forward_list.
+// Nothing is allocated, copied or destroyed, the objects are owned
+// elsewhere and must outlive their time on the list.
+template<typename T, Forward_list_hook T::* Hook>
+class Intrusive_forward_list
+{
+    using node_base = detail::Fwd_list_node_base;
+
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T&;
+    using const_reference = const T&;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using iterator        = detail::Intrusive_forward_list_iterator<T, Hook, T&, T*>;
+    using const_iterator  = detail::Intrusive_forward_list_iterator<T, Hook, const T&, const T*>;
+
+    Intrusive_forward_list() noexcept
+    {
+        head_.next = nullptr;
+    }
+
+    Intrusive_forward_list(const Intrusive_forward_list&) = delete;
+
+    Intrusive_forward_list(Intrusive_forward_list&& other) noexcept
+    {
+        head_.next = std::exchange(other.head_.next, nullptr);
+    }
+
+    Intrusive_forward_list& operator=(const Intrusive_forward_list&) = delete;
+
+    Intrusive_forward_list& operator=(Intrusive_forward_list&& other) noexcept
+    {
+        if (&other != this)
+        {
+            clear();
+            head_.next = std::exchange(other.head_.next, nullptr);
+        }
+        return *this;
+    }
+
+    // the objects left are unlinked
+    ~Intrusive_forward_list()
+    {
+        clear();
+    }
+
+    // access the first element
+    reference front() noexcept
+    {
+        return *begin();
+    }
+
+    const_reference front() const noexcept
+    {
+        return *begin();
+    }
+
+    // iterators
+    iterator before_begin() noexcept
+    {
+        return iterator(&head_);
+    }
+
+    const_iterator before_begin() const noexcept
+    {
+        return const_iterator(const_cast<node_base*>(&head_));
+    }
+
+    const_iterator cbefore_begin() const noexcept
+    {
+        return before_begin();
+    }
+
+    iterator begin() noexcept
+    {
+        return iterator(head_.next);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(head_.next);
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(nullptr);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(nullptr);
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    // the position of an object on the list
+    static iterator iterator_to(T& value) noexcept
+    {
+        return iterator(&(value.*Hook));
+    }
+
+    static const_iterator iterator_to(const T& value) noexcept
+    {
+        return const_iterator(const_cast<Forward_list_hook*>(&(value.*Hook)));
+    }
+
+    // capacity
+    bool empty() const noexcept
+    {
+        return head_.next == nullptr;
+    }
+
+    // modifiers
+
+    // unlink all the objects
+    void clear() noexcept
+    {
+        for (node_base* p = head_.next; p != nullptr; )
+        {
+            p = std::exchange(p->next, nullptr);
+        }
+        head_.next = nullptr;
+    }
+
+    // link value after pos, it must not be on a list
+    iterator insert_after(const_iterator pos, T& value) noexcept
+    {
+        node_base* n = &(value.*Hook);
+        n->next = pos.node->next;
+        pos.node->next = n;
+        return iterator(n);
+    }
+
+    // unlink the object after pos
+    iterator erase_after(const_iterator pos) noexcept
+    {
+        node_base* n = pos.node->next;
+        pos.node->next = n->next;
+        n->next = nullptr;
+        return iterator(pos.node->next);
+    }
+
+    iterator erase_after(const_iterator first, const_iterator last) noexcept
+    {
+        while (first.node->next != last.node)
+        {
+            erase_after(first);
+        }
+        return iterator(last.node);
+    }
+
+    void push_front(T& value) noexcept
+    {
+        insert_after(cbefore_begin(), value);
+    }
+
+    void pop_front() noexcept
+    {
+        erase_after(cbefore_begin());
+    }
+
+    void swap(Intrusive_forward_list& other) noexcept
+    {
+        std::swap(head_.next, other.head_.next);
+    }
+
+    // move the objects of other after pos
+    void splice_after(const_iterator pos, Intrusive_forward_list& other) noexcept
+    {
+        if (&other != this && !other.empty())
+        {
+            node_base* tail = other.head_.next;
+            while (tail->next)
+            {
+                tail = tail->next;
+            }
+            tail->next = pos.node->next;
+            pos.node->next = std::exchange(other.head_.next, nullptr);
+        }
+    }
+
+    void splice_after(const_iterator pos, Intrusive_forward_list&& other) noexcept
+    {
+        splice_after(pos, other);
+    }
+
+    // move the object after it
+    void splice_after(const_iterator pos, Intrusive_forward_list&, const_iterator it) noexcept
+    {
+        node_base* n = it.node->next;
+        if (pos.node == it.node || pos.node == n)
+        {
+            return;
+        }
+        it.node->next = n->next;
+        n->next = pos.node->next;
+        pos.node->next = n;
+    }
+
+    void splice_after(const_iterator pos, Intrusive_forward_list&& other, const_iterator it) noexcept
+    {
+        splice_after(pos, other, it);
+    }
+
+    // move the objects between first and last, both excluded
+    void splice_after(const_iterator pos, Intrusive_forward_list&,
+                      const_iterator first, const_iterator last) noexcept
+    {
+        if (first.node->next == last.node)
+        {
+            return;
+        }
+        node_base* head = first.node->next;
+        node_base* tail = head;
+        while (tail->next != last.node)
+        {
+            tail = tail->next;
+        }
+        first.node->next = last.node;
+        tail->next = pos.node->next;
+        pos.node->next = head;
+    }
+
+    void splice_after(const_iterator pos, Intrusive_forward_list&& other,
+                      const_iterator first, const_iterator last) noexcept
+    {
+        splice_after(pos, other, first, last);
+    }
+
+    // unlink the objects satisfying specific criteria
+    template<typename UnaryPredicate>
+    void remove_if(UnaryPredicate p)
+    {
+        for (auto prev = before_begin(); prev.node->next != nullptr; )
+        {
+            if (p(*iterator(prev.node->next)))
+                erase_after(prev);
+            else
+                ++prev;
+        }
+    }
+
+    // reverse the order of the objects
+    void reverse() noexcept
+    {
+        node_base* curr = head_.next;
+        node_base* head = nullptr;
+        while (curr)
+        {
+            curr = std::exchange(curr->next, std::exchange(head, curr));
+        }
+        head_.next = head;
+    }
+
+private:
+    node_base head_;
+};
+
+template<typename T, List_hook T::* Hook>
+void swap(Intrusive_list<T, Hook>& lhs, Intrusive_list<T, Hook>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+template<typename T, Forward_list_hook T::* Hook>
+void swap(Intrusive_forward_list<T, Hook>& lhs, Intrusive_forward_list<T, Hook>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+} // namespace cyy
+
+#endif // INTRUSIVE_LIST_H
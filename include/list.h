@@ -4,6 +4,8 @@
 #include "allocator.h"
 #include "aligned_buffer.h"
 #include "allocator_traits.h"
+#include "polymorphic_allocator.h"
+#include "list_sort.h"
 
 namespace cyy
 {
@@ -350,8 +352,16 @@ protected:
         head.node.data-= n;
     }
 
+    // a node from the spare chain, or a new one
     node_type* get_node()
     {
+        if (spare != nullptr)
+        {
+            List_node_base* p = spare;
+            spare = p->next;
+            --spare_count;
+            return static_cast<node_type*>(p);
+        }
         return node_alloc_traits::allocate(get_node_allocator(), 1);
     }
 
@@ -360,6 +370,58 @@ protected:
         node_alloc_traits::deallocate(get_node_allocator(), p, 1);
     }
 
+    // keep a node whose element is destroyed on the spare chain if it has
+    // room, give it back otherwise
+    void recycle_node(List_node<T>* p) noexcept
+    {
+        if (recycles_nodes && spare_count < spare_limit)
+        {
+            List_node_base* n = ::new (static_cast<void*>(p)) List_node_base();
+            n->next = spare;
+            spare = n;
+            ++spare_count;
+        }
+        else
+        {
+            put_node(p);
+        }
+    }
+
+    // make the spare chain hold n nodes at least and keep up to limit
+    void reserve_spare(size_t n, size_t limit)
+    {
+        if constexpr (!recycles_nodes)
+        {
+            return;
+        }
+        spare_limit = std::max(spare_limit, limit);
+        while (spare_count < n)
+        {
+            List_node_base* p = ::new (static_cast<void*>(node_alloc_traits::allocate(get_node_allocator(), 1))) List_node_base();
+            p->next = spare;
+            spare = p;
+            ++spare_count;
+        }
+    }
+
+    void release_spare() noexcept
+    {
+        while (spare != nullptr)
+        {
+            List_node_base* p = spare;
+            spare = p->next;
+            put_node(static_cast<node_type*>(p));
+        }
+        spare_count = 0;
+    }
+
+    void swap_spare(List_base& other) noexcept
+    {
+        std::swap(spare, other.spare);
+        std::swap(spare_count, other.spare_count);
+        std::swap(spare_limit, other.spare_limit);
+    }
+
     template<typename... Args>
     node_type* create_node(Args&&... args)
     {
@@ -371,7 +433,7 @@ protected:
         }
         catch(...)
         {
-            put_node(p);
+            recycle_node(p);
             throw;
         }
     }
@@ -382,20 +444,49 @@ protected:
         head.node.next = &head.node;
     }
 
+    // destroy the elements, the nodes go to the spare chain while it has room
     void clear()
     {
+        using noop = typename node_alloc_traits::is_deallocate_noop;
+        // nothing to destroy and nothing to give back, the nodes are just dropped
+        if constexpr (noop::value && std::is_trivially_destructible<T>::value)
+        {
+            return;
+        }
         List_node_base* tail = std::addressof(head.node);
         List_node_base* curr = head.node.next;
+        if constexpr (std::is_trivially_destructible<T>::value)
+        {
+            // nothing to destroy, nodes that all fit join the spare chain at once
+            if (curr != tail && spare_count + get_size() <= spare_limit)
+            {
+                tail->prev->next = spare;
+                spare = curr;
+                spare_count += get_size();
+                return;
+            }
+        }
         while (curr != tail)
         {
             auto tmp = curr->next;
             node_alloc_traits::destroy(get_node_allocator(), static_cast<List_node<T>*>(curr));
-            put_node(static_cast<List_node<T>*>(curr));
+            recycle_node(static_cast<List_node<T>*>(curr));
             curr = tmp;
         }
     }
 
+    // Memory of an allocator whose deallocate does nothing, like an Arena,
+    // may be reset under the list: its nodes are never kept.
+    static constexpr bool recycles_nodes = !node_alloc_traits::is_deallocate_noop::value;
+
+    // nodes kept on the spare chain when no limit is asked for
+    static constexpr size_t default_spare_limit = 0;
+
     List_base_impl head;
+    // unconstructed nodes kept for reuse, linked by next
+    List_node_base* spare;
+    size_t spare_count;
+    size_t spare_limit;
 
 public:
 
@@ -422,32 +513,36 @@ public:
     }
 
     List_base()
-      : head()
+      : head(), spare(nullptr), spare_count(0), spare_limit(default_spare_limit)
     {
         init();
     }
 
     List_base(const node_alloc_type& alloc) noexcept
-      : head(alloc)
+      : head(alloc), spare(nullptr), spare_count(0), spare_limit(default_spare_limit)
     {
         init();
     }
 
+    // the spare nodes go with the allocator
     List_base(List_base&& other) noexcept
-      : head(std::move(other.get_node_allocator()))
+      : head(std::move(other.get_node_allocator())), spare(nullptr), spare_count(0), spare_limit(default_spare_limit)
     {
         move_ctor_impl(std::move(other));
+        swap_spare(other);
     }
 
     List_base(List_base&& other, const node_alloc_type& alloc) noexcept
-      : head(alloc)
+      : head(alloc), spare(nullptr), spare_count(0), spare_limit(default_spare_limit)
     {
         move_ctor_impl(std::move(other));
     }
 
     ~List_base() noexcept
     {
+        spare_limit = 0;
         clear();
+        release_spare();
     }
 
 private:
@@ -484,6 +579,7 @@ class List : protected detail::List_base<T, Alloc>
     using base_type::head;
     using base_type::put_node;
     using base_type::get_node;
+    using base_type::recycle_node;
     using base_type::get_value_allocator;
     using base_type::get_node_allocator;
     using base_type::create_node;
@@ -542,7 +638,7 @@ public:
     }
 
     List(const List& other)
-      : base_type(node_alloc_type(other.get_node_allocator()))
+      : base_type(node_alloc_traits::select_on_container_copy_construction(other.get_node_allocator()))
     {
         range_initialize(other.begin(), other.end());
     }
@@ -559,8 +655,17 @@ public:
     }
 
     List(List&& other, const allocator_type& alloc)
-      : base_type(std::move(other), node_alloc_type(alloc))
+      : base_type(node_alloc_type(alloc))
     {
+        // the nodes of other can only be taken if alloc can deallocate them
+        if (get_node_allocator() == other.get_node_allocator())
+        {
+            swap_nodes(other);
+        }
+        else
+        {
+            range_initialize(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        }
     }
 
     List(std::initializer_list<value_type> init, const allocator_type& alloc = allocator_type())
@@ -581,8 +686,25 @@ public:
 
     List& operator=(List&& other)
     {
-        swap(other);
-        other.clear();
+        if (node_alloc_traits::propagate_on_container_move_assignment::value
+            || get_node_allocator() == other.get_node_allocator())
+        {
+            // the nodes must go back to the allocator they came from
+            clear();
+            if constexpr (node_alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                if (get_node_allocator() != other.get_node_allocator())
+                {
+                    base_type::release_spare();
+                }
+                get_node_allocator() = std::move(other.get_node_allocator());
+            }
+            swap_nodes(other);
+        }
+        else
+        {
+            range_assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        }
         return *this;
     }
 
@@ -725,7 +847,8 @@ public:
         return node_alloc_traits::max_size(get_node_allocator());
     }
 
-    // clear the contents
+    // clear the contents, the nodes are kept for reuse up to the limit set
+    // by reserve_nodes
     void clear() noexcept
     {
         base_type::clear();
@@ -733,6 +856,28 @@ public:
         set_size(0);
     }
 
+    // Keep nodes for n elements: the list then grows to n elements with no
+    // allocation, and the nodes of up to n erased elements are kept for
+    // the next ones instead of being given back. Without it none are kept,
+    // nor with an allocator whose deallocate does nothing.
+    void reserve_nodes(size_type n)
+    {
+        base_type::reserve_spare(n > size() ? n - size() : 0, n);
+    }
+
+    // give back the spare nodes, and keep none from then on
+    void release_nodes() noexcept
+    {
+        base_type::release_spare();
+        base_type::spare_limit = base_type::default_spare_limit;
+    }
+
+    // number of elements the list can hold without allocating
+    size_type node_capacity() const noexcept
+    {
+        return size() + base_type::spare_count;
+    }
+
     // insert element(s) before 
     iterator insert(const_iterator pos, const value_type& value)
     {
@@ -787,7 +932,7 @@ public:
         auto next = p->next;
         auto prev = p->prev;
         node_alloc_traits::destroy(get_node_allocator(), p);
-        put_node(p);
+        recycle_node(p);
         next->prev = prev;
         prev->next = next;
         dec_size(1);
@@ -796,13 +941,10 @@ public:
 
     iterator erase(const_iterator first, const_iterator last)
     {
-        size_t count = 0;
         while (first != last)
         {
             first = erase(first);
-            ++count;
         }
-        dec_size(count);
         return iterator(const_cast<node_base_type*>(last.node));
     }
 
@@ -882,14 +1024,13 @@ public:
     // swap the contents
     void swap(List& other)
     {
-        std::swap(head.node.prev, other.head.node.prev);
-        head.node.prev->next = &head.node;
-        other.head.node.prev->next = &other.head.node;
-        std::swap(head.node.next, other.head.node.next);
-        head.node.next->prev = &head.node;
-        head.node.next->prev = &head.node;
-        other.head.node.next->prev = &other.head.node;
-        std::swap(head.node.data, other.head.node.data);
+        if constexpr (node_alloc_traits::propagate_on_container_swap::value)
+        {
+            // the spare nodes go with the allocator
+            std::swap(get_node_allocator(), other.get_node_allocator());
+            base_type::swap_spare(other);
+        }
+        swap_nodes(other);
     }
 
     // merge two sorted lists
@@ -906,6 +1047,10 @@ public:
     template<typename Compare>
     void merge(List& other, Compare comp)
     {
+        if (&other == this || other.empty())
+        {
+            return;
+        }
         auto count = other.size();
         auto first1 = begin().node, last1 = end().node, first2 = other.begin().node, last2 = other.end().node;
         node_base_type h, *curr = &h;
@@ -933,6 +1078,8 @@ public:
         first->prev = curr;
         last->next = &head.node;
         head.node.prev = last;
+        head.node.next = h.next;
+        h.next->prev = &head.node;
         inc_size(count);
         other.init();
     }
@@ -1023,11 +1170,15 @@ public:
     template<typename UnaryPredicate>
     void remove_if(UnaryPredicate p)
     {
-        for (auto it = cbegin(); it != cend(); ++it)
+        for (auto it = cbegin(); it != cend(); )
         {
             if (p(*it))
             {
-                erase(it);
+                it = erase(it);
+            }
+            else
+            {
+                ++it;
             }
         }
     }
@@ -1073,22 +1224,55 @@ public:
         sort(std::less<value_type>());
     }
 
+    void sort(Sort_mode mode)
+    {
+        sort(std::less<value_type>(), mode);
+    }
+
+    // stable, the nodes are relinked and no element is moved
     template<typename Compare>
-    void sort(Compare comp)
+    void sort(Compare comp, Sort_mode mode = Sort_mode::automatic)
     {
-        if (empty())
+        if (head.node.next == head.node.prev)
+        {
+            return;
+        }
+        if (mode == Sort_mode::index || (mode == Sort_mode::automatic && size() >= detail::index_sort_threshold))
         {
+            node_base_type* prev = &head.node;
+            detail::index_sort(head.node.next, static_cast<node_base_type*>(&head.node), size(),
+                [] (node_base_type* p) -> const value_type& { return static_cast<node_type*>(p)->data; },
+                comp,
+                [&prev] (node_base_type* p) { prev->connect(p); prev = p; });
+            prev->connect(&head.node);
             return;
         }
-        auto first = head.node.next, last = head.node.prev;
-        last->connect(first);
-        first = sort_impl(first, comp);
-        last = first->prev;
+        head.node.prev->next = nullptr;
+        node_base_type* first = sort_impl(head.node.next, comp);
+        node_base_type* last = first->prev;
         head.node.connect(first);
         last->connect(&head.node);
     }
 
 private:
+    // exchange the nodes only, an empty list points at its own head
+    void swap_nodes(List& other) noexcept
+    {
+        node_base_type* h1 = &head.node;
+        node_base_type* h2 = &other.head.node;
+        std::swap(h1->prev, h2->prev);
+        std::swap(h1->next, h2->next);
+        if (h1->next == h2)
+            h1->next = h1->prev = h1;
+        else
+            h1->next->prev = h1->prev->next = h1;
+        if (h2->next == h1)
+            h2->next = h2->prev = h2;
+        else
+            h2->next->prev = h2->prev->next = h2;
+        std::swap(head.node.data, other.head.node.data);
+    }
+
     void default_initialize(size_t count)
     {
         for (size_t i = 0; i < count; ++i)
@@ -1158,63 +1342,80 @@ private:
         return n;
     }
 
-    // merge sort of list
+    // Bottom-up merge sort of the chain from first, linked by next and
+    // ending with nullptr. Nodes are taken one by one and merged into bins:
+    // bin i holds 2^i nodes or none, so no walk looks for a middle and
+    // there is no recursion. The sorted chain is returned, the prev of its
+    // first node is the last one.
     template<typename Compare>
     node_base_type* sort_impl(node_base_type* first, Compare comp)
     {
-        if (first == first->next)
-            return first;
-        node_base_type *fast = first->next, *mid = first->next, *last = first->prev;
-        while (fast != first && fast->next != first)
+        node_base_type* bins[64] = {};
+        std::size_t fill = 0;
+        while (first != nullptr)
         {
-            fast = fast->next->next;
-            mid = mid->next;
+            node_base_type* carry = first;
+            first = first->next;
+            carry->next = nullptr;
+            carry->prev = carry;
+            std::size_t i = 0;
+            for (; i < fill && bins[i] != nullptr; ++i)
+            {
+                carry = merge_sorted_list(bins[i], carry, comp);
+                bins[i] = nullptr;
+            }
+            bins[i] = carry;
+            if (i == fill)
+            {
+                ++fill;
+            }
+        }
+        node_base_type* result = nullptr;
+        for (std::size_t i = 0; i < fill; ++i)
+        {
+            if (bins[i] != nullptr)
+            {
+                result = result ? merge_sorted_list(bins[i], result, comp) : bins[i];
+            }
         }
-        auto mid_prev = mid->prev;
-        mid_prev->connect(first);
-        last->connect(mid);
-        return merge_sorted_list(sort_impl(first, comp), sort_impl(mid, comp), comp);
+        return result;
     }
 
-    // merge two sorted list @l1 and @l2
+    // Merge the sorted chains @l1 and @l2, ending with nullptr and with the
+    // prev of their first node pointing at the last one, into one such
+    // chain. The nodes of @l1 come first among equal ones. The prev links
+    // are kept up as the nodes are visited: a pass to fix them afterwards
+    // would miss the cache on every node again.
     template<typename Compare>
     node_base_type* merge_sorted_list(node_base_type* l1, node_base_type* l2, Compare comp)
     {
-        auto l1_last = l1->prev;
-        auto l2_last = l2->prev;
-        l1_last->next = nullptr;
-        l2_last->next = nullptr;
-        node_type* p1 = static_cast<node_type*>(l1), *p2 = static_cast<node_type*>(l2);
+        node_base_type* l1_last = l1->prev;
+        node_base_type* l2_last = l2->prev;
         node_base_type h, *prev = &h;
-        while (p1 && p2)
+        while (l1 && l2)
         {
-            node_base_type *p;
-            if (comp(p1->data, p2->data))
+            if (comp(static_cast<node_type*>(l2)->data, static_cast<node_type*>(l1)->data))
             {
-                p = p1;
-                p1 = static_cast<node_type*>(p1->next);
+                prev->connect(l2);
+                prev = l2;
+                l2 = l2->next;
             }
             else
             {
-                p = p2;
-                p2 = static_cast<node_type*>(p2->next);
+                prev->connect(l1);
+                prev = l1;
+                l1 = l1->next;
             }
-            prev->connect(p);
-            prev = p;
         }
-        if (p1)
+        if (l1)
         {
-            l1_last->connect(h.next);
-            prev->connect(p1);
-        }
-        else if (p2)
-        {
-            l2_last->connect(h.next);
-            prev->connect(p2);
+            prev->connect(l1);
+            h.next->prev = l1_last;
         }
         else
         {
-            prev->connect(h.next);
+            prev->connect(l2);
+            h.next->prev = l2_last;
         }
         return h.next;
     }
@@ -1274,6 +1475,12 @@ void swap(List<T,Alloc>& lhs,
 {
     lhs.swap(rhs);
 }
+
+namespace pmr
+{
+template<typename T>
+using List = cyy::List<T, polymorphic_allocator<T>>;
+} // namespace pmr
 } // namespace cyy
 
 #endif // LIST_H
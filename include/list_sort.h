@@ -0,0 +1,83 @@
+#ifndef LIST_SORT_H
+#define LIST_SORT_H
+
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include "vector.h"
+
+namespace cyy
+{
+// how List::sort and Forward_list::sort work
+enum class Sort_mode
+{
+    automatic,  // index from index_sort_threshold elements on, merge below
+    merge,      // bottom-up merge sort of the nodes
+    index       // sort an array of the nodes, then relink them
+};
+
+namespace detail
+{
+// Lists this long are sorted by index when the mode is automatic: merging
+// the nodes then misses the cache on most steps.
+constexpr std::size_t index_sort_threshold = 1 << 13;
+
+// whether the nodes from first on, up to last, are n at least
+template<typename NodeBase>
+bool length_at_least(const NodeBase* first, const NodeBase* last, std::size_t n) noexcept
+{
+    for (; n > 0 && first != last; --n)
+    {
+        first = first->next;
+    }
+    return n == 0;
+}
+
+// Stable sort of the nodes from first up to last by index: the node
+// pointers, with a copy of small trivially copyable and assignable
+// values beside them, are sorted in a Vector, then link(node) is called on each node in the
+// sorted order. value(node) gives the element of a node. Nothing is
+// relinked if it throws and no element is moved. count is a hint.
+template<typename NodeBase, typename Value, typename Compare, typename Link>
+void index_sort(NodeBase* first, NodeBase* last, std::size_t count, Value value, Compare comp, Link link)
+{
+    using T = std::remove_cv_t<std::remove_reference_t<decltype(value(first))>>;
+    if constexpr (std::is_trivially_copyable_v<T> && std::is_move_assignable_v<T> && sizeof(T) <= 2 * sizeof(void*))
+    {
+        // the keys are compared where they are, without a visit to the node
+        Vector<std::pair<T, NodeBase*>> keyed;
+        keyed.reserve(count);
+        for (NodeBase* p = first; p != last; p = p->next)
+        {
+            keyed.emplace_back(value(p), p);
+        }
+        std::stable_sort(keyed.begin(), keyed.end(), [&comp] (const auto& a, const auto& b) {
+            return comp(a.first, b.first);
+        });
+        for (auto& k : keyed)
+        {
+            link(k.second);
+        }
+    }
+    else
+    {
+        Vector<NodeBase*> nodes;
+        nodes.reserve(count);
+        for (NodeBase* p = first; p != last; p = p->next)
+        {
+            nodes.push_back(p);
+        }
+        std::stable_sort(nodes.begin(), nodes.end(), [&comp, &value] (NodeBase* a, NodeBase* b) {
+            return comp(value(a), value(b));
+        });
+        for (NodeBase* p : nodes)
+        {
+            link(p);
+        }
+    }
+}
+} // namespace detail
+} // namespace cyy
+
+#endif // LIST_SORT_H
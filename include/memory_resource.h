@@ -0,0 +1,460 @@
+#ifndef MEMORY_RESOURCE_H
+#define MEMORY_RESOURCE_H
+
+#include <mutex>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include "polymorphic_allocator.h"
+
+namespace cyy
+{
+namespace pmr
+{
+// options of the pool resources, 0 means the default value
+struct pool_options
+{
+    std::size_t max_blocks_per_chunk = 0;
+    std::size_t largest_required_pool_block = 0;
+};
+
+// Pools of blocks, one free-list per power of 2 from 8 bytes up to
+// largest_required_pool_block. Chunks come from the upstream resource and
+// grow geometrically up to max_blocks_per_chunk blocks. Larger requests go
+// to upstream directly. Nothing goes back to upstream before release().
+class unsynchronized_pool_resource
+    : public memory_resource
+{
+public:
+    unsynchronized_pool_resource(const pool_options& opts, memory_resource* upstream)
+        : upstream_(upstream), chunks_(nullptr), large_(nullptr)
+    {
+        max_blocks_ = opts.max_blocks_per_chunk != 0 ? opts.max_blocks_per_chunk : 1024;
+        std::size_t largest = opts.largest_required_pool_block != 0 ? opts.largest_required_pool_block : 4096;
+        npools_ = 0;
+        while (npools_ < MAX_POOLS && pool_block_size(npools_) < largest)
+        {
+            ++npools_;
+        }
+        if (npools_ < MAX_POOLS)
+        {
+            ++npools_;
+        }
+        for (std::size_t i = 0; i < npools_; ++i)
+        {
+            pools_[i].free_list = nullptr;
+            pools_[i].next_blocks = 4;
+        }
+    }
+
+    unsynchronized_pool_resource()
+        : unsynchronized_pool_resource(pool_options(), get_default_resource())
+    {
+    }
+
+    explicit unsynchronized_pool_resource(memory_resource* upstream)
+        : unsynchronized_pool_resource(pool_options(), upstream)
+    {
+    }
+
+    explicit unsynchronized_pool_resource(const pool_options& opts)
+        : unsynchronized_pool_resource(opts, get_default_resource())
+    {
+    }
+
+    unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+
+    unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+
+    ~unsynchronized_pool_resource()
+    {
+        release();
+    }
+
+    // give all the memory back to upstream
+    void release()
+    {
+        while (chunks_ != nullptr)
+        {
+            Chunk* next = chunks_->next;
+            upstream_->deallocate(chunks_, chunks_->bytes, chunks_->align);
+            chunks_ = next;
+        }
+        while (large_ != nullptr)
+        {
+            Chunk* next = large_->next;
+            upstream_->deallocate(large_, large_->bytes, large_->align);
+            large_ = next;
+        }
+        for (std::size_t i = 0; i < npools_; ++i)
+        {
+            pools_[i].free_list = nullptr;
+            pools_[i].next_blocks = 4;
+        }
+    }
+
+    memory_resource* upstream_resource() const noexcept
+    {
+        return upstream_;
+    }
+
+    pool_options options() const noexcept
+    {
+        return pool_options{max_blocks_, pool_block_size(npools_ - 1)};
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        std::size_t i = pool_index(bytes, alignment);
+        if (i >= npools_)
+        {
+            return allocate_large(bytes, alignment);
+        }
+        Pool& pool = pools_[i];
+        if (pool.free_list == nullptr)
+        {
+            refill(i);
+        }
+        Block* b = pool.free_list;
+        pool.free_list = b->next;
+        return b;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        std::size_t i = pool_index(bytes, alignment);
+        if (i >= npools_)
+        {
+            deallocate_large(p);
+            return;
+        }
+        Block* b = static_cast<Block*>(p);
+        b->next = pools_[i].free_list;
+        pools_[i].free_list = b;
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    enum { MIN_BLOCK_SHIFT = 3, MAX_POOLS = 20 };
+
+    struct Block
+    {
+        Block* next;
+    };
+
+    // header of the memory taken from upstream
+    struct alignas(std::max_align_t) Chunk
+    {
+        Chunk* prev;
+        Chunk* next;
+        std::size_t bytes;
+        std::size_t align;
+    };
+
+    struct Pool
+    {
+        Block* free_list;
+        std::size_t next_blocks;   // number of blocks of the next chunk
+    };
+
+    static std::size_t pool_block_size(std::size_t i) noexcept
+    {
+        return std::size_t(1) << (i + MIN_BLOCK_SHIFT);
+    }
+
+    // blocks of the pool i are aligned to their size, which can't be less
+    // than alignment
+    std::size_t pool_index(std::size_t bytes, std::size_t alignment) const noexcept
+    {
+        if (bytes < alignment)
+        {
+            bytes = alignment;
+        }
+        if (bytes > pool_block_size(npools_ - 1))
+        {
+            return npools_;
+        }
+        std::size_t i = 0;
+        while (pool_block_size(i) < bytes)
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    void refill(std::size_t i)
+    {
+        Pool& pool = pools_[i];
+        std::size_t size = pool_block_size(i);
+        std::size_t n = pool.next_blocks;
+        // the blocks start after a header of size bytes at least, so that
+        // every block stays aligned to its size
+        std::size_t header = size < sizeof(Chunk) ? sizeof(Chunk) : size;
+        std::size_t align = size < alignof(std::max_align_t) ? alignof(std::max_align_t) : size;
+        std::size_t bytes = header + n * size;
+        Chunk* c = static_cast<Chunk*>(upstream_->allocate(bytes, align));
+        c->prev = nullptr;
+        c->next = chunks_;
+        c->bytes = bytes;
+        c->align = align;
+        chunks_ = c;
+
+        char* p = reinterpret_cast<char*>(c) + header;
+        for (std::size_t k = 0; k < n; ++k, p += size)
+        {
+            Block* b = reinterpret_cast<Block*>(p);
+            b->next = pool.free_list;
+            pool.free_list = b;
+        }
+        if (pool.next_blocks < max_blocks_)
+        {
+            pool.next_blocks = pool.next_blocks * 2 < max_blocks_ ? pool.next_blocks * 2 : max_blocks_;
+        }
+    }
+
+    // large blocks are linked in a list, so that they can be released alone
+    void* allocate_large(std::size_t bytes, std::size_t alignment)
+    {
+        std::size_t align = alignment < alignof(Chunk) ? alignof(Chunk) : alignment;
+        std::size_t header = (sizeof(Chunk) + sizeof(Chunk*) + align - 1) / align * align;
+        Chunk* c = static_cast<Chunk*>(upstream_->allocate(header + bytes, align));
+        c->prev = nullptr;
+        c->next = large_;
+        c->bytes = header + bytes;
+        c->align = align;
+        if (large_ != nullptr)
+        {
+            large_->prev = c;
+        }
+        large_ = c;
+        // the header is found right before the block
+        char* p = reinterpret_cast<char*>(c) + header;
+        reinterpret_cast<Chunk**>(p)[-1] = c;
+        return p;
+    }
+
+    void deallocate_large(void* p)
+    {
+        Chunk* c = static_cast<Chunk**>(p)[-1];
+        if (c->prev != nullptr)
+        {
+            c->prev->next = c->next;
+        }
+        else
+        {
+            large_ = c->next;
+        }
+        if (c->next != nullptr)
+        {
+            c->next->prev = c->prev;
+        }
+        upstream_->deallocate(c, c->bytes, c->align);
+    }
+
+    memory_resource* upstream_;
+    Chunk* chunks_;              // chunks cut into pool blocks
+    Chunk* large_;               // blocks too large for the pools
+    std::size_t max_blocks_;
+    std::size_t npools_;
+    Pool pools_[MAX_POOLS];
+};
+
+// unsynchronized_pool_resource usable from several threads at once
+class synchronized_pool_resource
+    : public memory_resource
+{
+public:
+    synchronized_pool_resource(const pool_options& opts, memory_resource* upstream)
+        : pool_(opts, upstream)
+    {
+    }
+
+    synchronized_pool_resource()
+        : pool_()
+    {
+    }
+
+    explicit synchronized_pool_resource(memory_resource* upstream)
+        : pool_(upstream)
+    {
+    }
+
+    explicit synchronized_pool_resource(const pool_options& opts)
+        : pool_(opts)
+    {
+    }
+
+    synchronized_pool_resource(const synchronized_pool_resource&) = delete;
+
+    synchronized_pool_resource& operator=(const synchronized_pool_resource&) = delete;
+
+    void release()
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        pool_.release();
+    }
+
+    memory_resource* upstream_resource() const noexcept
+    {
+        return pool_.upstream_resource();
+    }
+
+    pool_options options() const noexcept
+    {
+        return pool_.options();
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return pool_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        pool_.deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    std::mutex lock_;
+    unsynchronized_pool_resource pool_;
+};
+
+// Bump allocation from an optional initial buffer, then from buffers taken
+// from upstream that grow geometrically. deallocate() does nothing, the
+// memory goes back at release() or destruction.
+class monotonic_buffer_resource
+    : public memory_resource
+{
+public:
+    explicit monotonic_buffer_resource(memory_resource* upstream)
+        : monotonic_buffer_resource(nullptr, 0, upstream)
+    {
+    }
+
+    monotonic_buffer_resource(std::size_t initial_size, memory_resource* upstream)
+        : upstream_(upstream), initial_buffer_(nullptr), initial_size_(0),
+          cur_(nullptr), left_(0), next_size_(initial_size != 0 ? initial_size : 1024), buffers_(nullptr)
+    {
+    }
+
+    monotonic_buffer_resource(void* buffer, std::size_t buffer_size, memory_resource* upstream)
+        : upstream_(upstream), initial_buffer_(buffer), initial_size_(buffer_size),
+          cur_(static_cast<char*>(buffer)), left_(buffer_size),
+          next_size_(buffer_size != 0 ? buffer_size * 2 : 1024), buffers_(nullptr)
+    {
+    }
+
+    monotonic_buffer_resource()
+        : monotonic_buffer_resource(get_default_resource())
+    {
+    }
+
+    explicit monotonic_buffer_resource(std::size_t initial_size)
+        : monotonic_buffer_resource(initial_size, get_default_resource())
+    {
+    }
+
+    monotonic_buffer_resource(void* buffer, std::size_t buffer_size)
+        : monotonic_buffer_resource(buffer, buffer_size, get_default_resource())
+    {
+    }
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+    ~monotonic_buffer_resource()
+    {
+        release();
+    }
+
+    // give the buffers back to upstream, the initial buffer is used again
+    void release()
+    {
+        while (buffers_ != nullptr)
+        {
+            Buffer* next = buffers_->next;
+            upstream_->deallocate(buffers_, buffers_->bytes, alignof(Buffer));
+            buffers_ = next;
+        }
+        cur_ = static_cast<char*>(initial_buffer_);
+        left_ = initial_size_;
+    }
+
+    memory_resource* upstream_resource() const noexcept
+    {
+        return upstream_;
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        void* p = cur_;
+        if (p == nullptr || std::align(alignment, bytes, p, left_) == nullptr)
+        {
+            new_buffer(bytes + alignment);
+            p = cur_;
+            std::align(alignment, bytes, p, left_);
+        }
+        cur_ = static_cast<char*>(p) + bytes;
+        left_ -= bytes;
+        return p;
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override
+    {
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    struct alignas(std::max_align_t) Buffer
+    {
+        Buffer* next;
+        std::size_t bytes;
+    };
+
+    void new_buffer(std::size_t min_bytes)
+    {
+        std::size_t bytes = next_size_;
+        while (bytes < min_bytes + sizeof(Buffer))
+        {
+            bytes *= 2;
+        }
+        Buffer* b = static_cast<Buffer*>(upstream_->allocate(bytes, alignof(Buffer)));
+        b->next = buffers_;
+        b->bytes = bytes;
+        buffers_ = b;
+        cur_ = reinterpret_cast<char*>(b + 1);
+        left_ = bytes - sizeof(Buffer);
+        next_size_ = bytes * 2;
+    }
+
+    memory_resource* upstream_;
+    void* initial_buffer_;
+    std::size_t initial_size_;
+    char* cur_;
+    std::size_t left_;
+    std::size_t next_size_;
+    Buffer* buffers_;
+};
+} // namespace pmr
+} // namespace cyy
+
+#endif // MEMORY_RESOURCE_H
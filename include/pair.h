@@ -174,6 +174,12 @@ make_pair(T1 &&first, T2 &&second)
            (std::forward<T1>(first), std::forward<T2>(second));
 }
 
+template<typename T1, typename T2>
+struct is_trivially_relocatable<pair<T1, T2>>
+    : std::conjunction<is_trivially_relocatable<T1>, is_trivially_relocatable<T2>>
+{
+};
+
 // TODO: get<>, class tuple_size<pair>, class tuple_element<pair>
 
 } // namespace cyy
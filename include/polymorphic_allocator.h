@@ -0,0 +1,246 @@
+#ifndef POLYMORPHIC_ALLOCATOR_H
+#define POLYMORPHIC_ALLOCATOR_H
+
+#include <new>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+// memory_resource and polymorphic_allocator alone, for the containers and
+// their pmr aliases. The resources themselves are in memory_resource.h.
+namespace cyy
+{
+namespace pmr
+{
+// Interface of the memory resources. Containers using polymorphic_allocator
+// have the same type whatever the resource behind it is.
+class memory_resource
+{
+public:
+    virtual ~memory_resource() = default;
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        return do_allocate(bytes, alignment);
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    // whether memory allocated from this can be deallocated from other and vice versa
+    bool is_equal(const memory_resource& other) const noexcept
+    {
+        return do_is_equal(other);
+    }
+
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+
+    virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) = 0;
+
+    virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept
+{
+    return &lhs == &rhs || lhs.is_equal(rhs);
+}
+
+inline bool operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+namespace detail
+{
+// resource using the global operator new and operator delete
+class New_delete_resource
+    : public memory_resource
+{
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+        return ::operator new(bytes);
+    }
+
+    void do_deallocate(void* p, std::size_t, std::size_t alignment) override
+    {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ::operator delete(p, std::align_val_t(alignment));
+        }
+        else
+        {
+            ::operator delete(p);
+        }
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// resource failing every allocation
+class Null_resource
+    : public memory_resource
+{
+    void* do_allocate(std::size_t, std::size_t) override
+    {
+        throw std::bad_alloc();
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override
+    {
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+} // namespace detail
+
+inline memory_resource* new_delete_resource() noexcept
+{
+    static detail::New_delete_resource resource;
+    return &resource;
+}
+
+inline memory_resource* null_memory_resource() noexcept
+{
+    static detail::Null_resource resource;
+    return &resource;
+}
+
+namespace detail
+{
+inline std::atomic<memory_resource*>& default_resource() noexcept
+{
+    static std::atomic<memory_resource*> resource{new_delete_resource()};
+    return resource;
+}
+} // namespace detail
+
+// the resource used by default constructed polymorphic_allocator
+inline memory_resource* get_default_resource() noexcept
+{
+    return detail::default_resource().load();
+}
+
+// set the default resource, new_delete_resource() if r is nullptr,
+// return the previous one
+inline memory_resource* set_default_resource(memory_resource* r) noexcept
+{
+    return detail::default_resource().exchange(r != nullptr ? r : new_delete_resource());
+}
+
+// Allocator holding a memory_resource*. It is not propagated by the
+// containers: the resource stays with the container it was given to.
+template<typename T>
+class polymorphic_allocator
+{
+public:
+    using value_type      = T;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using reference       = T&;
+    using const_reference = const T&;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using is_always_equal = std::false_type;
+
+    // constructors
+    polymorphic_allocator() noexcept
+        : resource_(get_default_resource())
+    {
+    }
+
+    polymorphic_allocator(memory_resource* r) noexcept
+        : resource_(r)
+    {
+    }
+
+    polymorphic_allocator(const polymorphic_allocator&) = default;
+
+    template<typename U>
+    polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+        : resource_(other.resource())
+    {
+    }
+
+    polymorphic_allocator& operator=(const polymorphic_allocator&) = delete;
+
+    template<typename T1>
+    struct rebind
+    {
+        using other = polymorphic_allocator<T1>;
+    };
+
+    pointer allocate(size_type n)
+    {
+        if (n > this->max_size())
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<pointer>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    size_type max_size() const noexcept
+    {
+        return size_type(-1) / sizeof(value_type);
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        ::new((void*)p) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    void destroy(U* p)
+    {
+        p->~U();
+    }
+
+    // a copied container gets the default resource, as a new one would
+    polymorphic_allocator select_on_container_copy_construction() const noexcept
+    {
+        return polymorphic_allocator();
+    }
+
+    memory_resource* resource() const noexcept
+    {
+        return resource_;
+    }
+
+private:
+    memory_resource* resource_;
+};
+
+template<typename T1, typename T2>
+inline bool operator==(const polymorphic_allocator<T1>& lhs, const polymorphic_allocator<T2>& rhs) noexcept
+{
+    return *lhs.resource() == *rhs.resource();
+}
+
+template<typename T1, typename T2>
+inline bool operator!=(const polymorphic_allocator<T1>& lhs, const polymorphic_allocator<T2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+} // namespace pmr
+} // namespace cyy
+
+#endif // POLYMORPHIC_ALLOCATOR_H
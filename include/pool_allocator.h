@@ -0,0 +1,173 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include "SGI_alloc.h"
+#include "allocator_traits.h"
+#include "type_traits.h"
+
+namespace cyy
+{
+// Allocator taking its memory from a __default_alloc_template pool, so that
+// node containers get pooled nodes: List<T, Pool_allocator<T>>.
+// It holds no state, every Pool_allocator using the same Pool is equal.
+template <typename T, typename Pool = cyy::alloc>
+class Pool_allocator
+{
+public:
+    using value_type      = T;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using reference       = T&;
+    using const_reference = const T&;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    // constructors
+    Pool_allocator() noexcept { }
+
+    Pool_allocator(const Pool_allocator&) noexcept { }
+
+    Pool_allocator& operator=(const Pool_allocator&) noexcept = default;
+
+    template<typename P>
+    Pool_allocator(const Pool_allocator<P, Pool>&) noexcept { }
+
+    // destructor
+    ~Pool_allocator() noexcept { }
+
+    template<typename T1>
+    struct rebind
+    {
+        using other = Pool_allocator<T1, Pool>;
+    };
+
+    pointer allocate(size_type n, const void* = nullptr)
+    {
+        if (n > this->max_size())
+        {
+            throw std::bad_alloc();
+        }
+        if (n == 0)
+        {
+            return nullptr;
+        }
+        // the pool only aligns blocks to Pool::alignment
+        if constexpr (alignof(T) > Pool::alignment)
+        {
+            return static_cast<pointer>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        else
+        {
+            return static_cast<pointer>(Pool::allocate(n * sizeof(T)));
+        }
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if (p == nullptr)
+        {
+            return;
+        }
+        if constexpr (alignof(T) > Pool::alignment)
+        {
+            ::operator delete(p, std::align_val_t(alignof(T)));
+        }
+        else
+        {
+            Pool::deallocate(p, n * sizeof(T));
+        }
+    }
+
+    // allocate(n), telling how many elements fit in the block: the rest of
+    // the size class, or the slack malloc left for a large block
+    Allocation_result<pointer> allocate_at_least(size_type n)
+    {
+        pointer p = allocate(n);
+        if constexpr (alignof(T) > Pool::alignment)
+        {
+            return {p, n};
+        }
+        else
+        {
+            return {p, p == nullptr ? 0 : Pool::usable_size(p, n * sizeof(T)) / sizeof(T)};
+        }
+    }
+
+    // grow the block of n elements at p to new_n elements if it is large enough
+    bool try_expand(pointer p, size_type n, size_type new_n)
+    {
+        if constexpr (alignof(T) > Pool::alignment)
+        {
+            return false;
+        }
+        else
+        {
+            return p != nullptr && new_n * sizeof(T) <= Pool::usable_size(p, n * sizeof(T));
+        }
+    }
+
+    // resize the block of n elements at p as realloc does, new_n must be > 0
+    template<typename U = T, typename = std::enable_if_t<alignof(U) <= Pool::alignment>>
+    pointer reallocate(pointer p, size_type n, size_type new_n)
+    {
+        if (new_n > this->max_size())
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<pointer>(Pool::reallocate(p, n * sizeof(T), new_n * sizeof(T)));
+    }
+
+    pointer address(reference x) const noexcept
+    {
+        return std::addressof(x);
+    }
+
+    const_pointer address(const_reference x) const noexcept
+    {
+        return std::addressof(x);
+    }
+
+    size_type max_size() const
+    {
+        return size_type(-1) / sizeof(value_type);
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args) const
+    {
+        ::new((void*)p) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    void destroy(U* p)
+    {
+        p->~U();
+    }
+};
+
+// stateless, its destructor does nothing
+template<typename T, typename Pool>
+struct is_trivially_relocatable<Pool_allocator<T, Pool>>
+    : std::true_type
+{
+};
+
+template<typename T1, typename T2, typename Pool>
+inline bool operator==(const Pool_allocator<T1, Pool>&, const Pool_allocator<T2, Pool>&) noexcept
+{
+    return true;
+}
+
+template<typename T1, typename T2, typename Pool>
+inline bool operator!=(const Pool_allocator<T1, Pool>&, const Pool_allocator<T2, Pool>&) noexcept
+{
+    return false;
+}
+} // namespace cyy
+
+#endif // POOL_ALLOCATOR_H
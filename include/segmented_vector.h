@@ -0,0 +1,881 @@
+#ifndef SEGMENTED_VECTOR_H
+#define SEGMENTED_VECTOR_H
+
+#include <limits>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "allocator.h"
+#include "allocator_traits.h"
+#include "uninitialized.h"
+#include "construct.h"
+#include "vector.h"
+
+namespace cyy
+{
+namespace detail
+{
+// elements in a segment of about 4 KB, a power of 2 and 16 at least
+constexpr std::size_t default_segment_size(std::size_t elem_size)
+{
+    std::size_t n = 16;
+    while (n * 2 * elem_size <= 4096)
+    {
+        n *= 2;
+    }
+    return n;
+}
+
+constexpr std::size_t segment_shift(std::size_t segment_size)
+{
+    std::size_t shift = 0;
+    while ((std::size_t(1) << shift) < segment_size)
+    {
+        ++shift;
+    }
+    return shift;
+}
+
+// Iterator of Segmented_vector: the segment table and an index, the element
+// is table[index / SegmentSize][index % SegmentSize]. It is invalidated when
+// the table grows, the elements never move.
+template<typename T, typename Ref, typename Ptr, std::size_t SegmentSize>
+class Segmented_vector_iterator
+{
+    template<typename U, typename R, typename P, std::size_t S>
+    friend class Segmented_vector_iterator;
+
+    constexpr static std::size_t shift = segment_shift(SegmentSize);
+    constexpr static std::size_t mask = SegmentSize - 1;
+
+public:
+    using self = Segmented_vector_iterator;
+
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using pointer = Ptr;
+    using reference = Ref;
+
+    Segmented_vector_iterator() noexcept
+        : table(nullptr), index(0)
+    {
+    }
+
+    Segmented_vector_iterator(T* const* table, difference_type index) noexcept
+        : table(table), index(index)
+    {
+    }
+
+    // iterator to const_iterator
+    template<typename R, typename P, typename = std::enable_if_t<std::is_convertible_v<P, Ptr>>>
+    Segmented_vector_iterator(const Segmented_vector_iterator<T, R, P, SegmentSize>& other) noexcept
+        : table(other.table), index(other.index)
+    {
+    }
+
+    reference operator*() const
+    {
+        return table[std::size_t(index) >> shift][std::size_t(index) & mask];
+    }
+
+    pointer operator->() const
+    {
+        return std::addressof(**this);
+    }
+
+    reference operator[](difference_type n) const
+    {
+        return *(*this + n);
+    }
+
+    self& operator++() noexcept
+    {
+        ++index;
+        return *this;
+    }
+
+    self operator++(int) noexcept
+    {
+        auto tmp = *this;
+        ++index;
+        return tmp;
+    }
+
+    self& operator--() noexcept
+    {
+        --index;
+        return *this;
+    }
+
+    self operator--(int) noexcept
+    {
+        auto tmp = *this;
+        --index;
+        return tmp;
+    }
+
+    self& operator+=(difference_type n) noexcept
+    {
+        index += n;
+        return *this;
+    }
+
+    self& operator-=(difference_type n) noexcept
+    {
+        index -= n;
+        return *this;
+    }
+
+    friend self operator+(self it, difference_type n) noexcept
+    {
+        return it += n;
+    }
+
+    friend self operator+(difference_type n, self it) noexcept
+    {
+        return it += n;
+    }
+
+    friend self operator-(self it, difference_type n) noexcept
+    {
+        return it -= n;
+    }
+
+    template<typename R, typename P>
+    difference_type operator-(const Segmented_vector_iterator<T, R, P, SegmentSize>& other) const noexcept
+    {
+        return index - other.index;
+    }
+
+    template<typename R, typename P>
+    bool operator==(const Segmented_vector_iterator<T, R, P, SegmentSize>& other) const noexcept
+    {
+        return index == other.index;
+    }
+
+    template<typename R, typename P>
+    bool operator!=(const Segmented_vector_iterator<T, R, P, SegmentSize>& other) const noexcept
+    {
+        return index != other.index;
+    }
+
+    template<typename R, typename P>
+    bool operator<(const Segmented_vector_iterator<T, R, P, SegmentSize>& other) const noexcept
+    {
+        return index < other.index;
+    }
+
+    template<typename R, typename P>
+    bool operator>(const Segmented_vector_iterator<T, R, P, SegmentSize>& other) const noexcept
+    {
+        return index > other.index;
+    }
+
+    template<typename R, typename P>
+    bool operator<=(const Segmented_vector_iterator<T, R, P, SegmentSize>& other) const noexcept
+    {
+        return index <= other.index;
+    }
+
+    template<typename R, typename P>
+    bool operator>=(const Segmented_vector_iterator<T, R, P, SegmentSize>& other) const noexcept
+    {
+        return index >= other.index;
+    }
+
+private:
+    T* const* table;
+    difference_type index;
+};
+} // namespace detail
+
+// Sequence with the interface of Vector whose elements live in segments of
+// SegmentSize elements, found through a table of segment pointers. Growing
+// adds a segment and never moves an element, so push_back costs no copy of
+// the elements and pointers and references to them stay valid until they
+// are erased. Only the table, one pointer per segment, is reallocated.
+// The elements are not contiguous: there is no data().
+template<typename T, typename Alloc = cyy::Allocator<T>,
+         std::size_t SegmentSize = detail::default_segment_size(sizeof(T))>
+class Segmented_vector
+{
+    static_assert(std::is_same<typename Alloc::value_type, T>::value,
+                  "Allocator::value_type and T must be the same type.");
+    static_assert(SegmentSize != 0 && (SegmentSize & (SegmentSize - 1)) == 0,
+                  "SegmentSize must be a power of 2");
+
+    using Alloc_traits = cyy::Allocator_traits<Alloc>;
+    using Table = Vector<T*, typename Alloc_traits::template rebind_alloc<T*>>;
+
+    constexpr static std::size_t shift = detail::segment_shift(SegmentSize);
+    constexpr static std::size_t mask = SegmentSize - 1;
+
+public:
+    using value_type             = T;
+    using allocator_type         = Alloc;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = value_type&;
+    using const_reference        = const value_type&;
+    using pointer                = T*;
+    using const_pointer          = const T*;
+    using iterator               = detail::Segmented_vector_iterator<T, T&, T*, SegmentSize>;
+    using const_iterator         = detail::Segmented_vector_iterator<T, const T&, const T*, SegmentSize>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    constexpr static size_type segment_size = SegmentSize;
+
+    // construct
+    Segmented_vector()
+        : alloc_(), table_(), size_(0)
+    {
+    }
+
+    explicit Segmented_vector(const allocator_type& alloc)
+        : alloc_(alloc), table_(alloc), size_(0)
+    {
+    }
+
+    Segmented_vector(size_type count, const value_type& value, const allocator_type& alloc = Alloc())
+        : Segmented_vector(alloc)
+    {
+        guarded([&] { append_fill(count, value); });
+    }
+
+    explicit Segmented_vector(size_type count, const allocator_type& alloc = Alloc())
+        : Segmented_vector(alloc)
+    {
+        guarded([&] {
+            append_bulk(count, [this] (pointer p, size_type n) {
+                cyy::uninitialized_default_n_a(p, n, alloc_);
+            });
+        });
+    }
+
+    template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
+    Segmented_vector(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : Segmented_vector(alloc)
+    {
+        guarded([&] { append_range(first, last); });
+    }
+
+    Segmented_vector(std::initializer_list<value_type> l, const allocator_type& alloc = allocator_type())
+        : Segmented_vector(l.begin(), l.end(), alloc)
+    {
+    }
+
+    Segmented_vector(const Segmented_vector& other)
+        : Segmented_vector(other.begin(), other.end(),
+                           Alloc_traits::select_on_container_copy_construction(other.alloc_))
+    {
+    }
+
+    Segmented_vector(const Segmented_vector& other, const allocator_type& alloc)
+        : Segmented_vector(other.begin(), other.end(), alloc)
+    {
+    }
+
+    Segmented_vector(Segmented_vector&& other) noexcept
+        : alloc_(std::move(other.alloc_)), table_(std::move(other.table_)), size_(other.size_)
+    {
+        other.size_ = 0;
+    }
+
+    Segmented_vector(Segmented_vector&& other, const allocator_type& alloc)
+        : Segmented_vector(alloc)
+    {
+        if (Alloc_traits::is_always_equal::value || alloc_ == other.alloc_)
+        {
+            take_storage(other);
+        }
+        else
+        {
+            guarded([&] { append_range(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end())); });
+            other.clear();
+        }
+    }
+
+    // destruct
+    ~Segmented_vector()
+    {
+        clear();
+        release_segments(0);
+    }
+
+    // assignment
+    Segmented_vector& operator=(const Segmented_vector& rhs)
+    {
+        if (&rhs == this)
+        {
+            return *this;
+        }
+        if constexpr (Alloc_traits::propagate_on_container_copy_assignment::value)
+        {
+            // the old segments must go back to the allocator they came from
+            if (!Alloc_traits::is_always_equal::value && alloc_ != rhs.alloc_)
+            {
+                clear();
+                release_segments(0);
+            }
+            alloc_ = rhs.alloc_;
+        }
+        assign(rhs.begin(), rhs.end());
+        return *this;
+    }
+
+    Segmented_vector& operator=(Segmented_vector&& rhs)
+    {
+        if (&rhs == this)
+        {
+            return *this;
+        }
+        if (Alloc_traits::propagate_on_container_move_assignment::value
+            || Alloc_traits::is_always_equal::value || alloc_ == rhs.alloc_)
+        {
+            clear();
+            release_segments(0);
+            if constexpr (Alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                alloc_ = std::move(rhs.alloc_);
+            }
+            take_storage(rhs);
+        }
+        else
+        {
+            // the segments of rhs can't be taken, move the elements one by one
+            assign(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+        }
+        return *this;
+    }
+
+    Segmented_vector& operator=(std::initializer_list<value_type> ilist)
+    {
+        assign(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    // replace the contents, the segments are kept
+    void assign(size_type count, const value_type& value)
+    {
+        clear();
+        append_fill(count, value);
+    }
+
+    template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
+    void assign(InputIterator first, InputIterator last)
+    {
+        clear();
+        append_range(first, last);
+    }
+
+    void assign(std::initializer_list<value_type> ilist)
+    {
+        assign(ilist.begin(), ilist.end());
+    }
+
+    // returns the associated allocator
+    allocator_type get_allocator() const noexcept
+    {
+        return alloc_;
+    }
+
+    // access specified element
+    reference operator[](size_type index)
+    {
+        return table_[index >> shift][index & mask];
+    }
+
+    const_reference operator[](size_type index) const
+    {
+        return table_[index >> shift][index & mask];
+    }
+
+    // access specified element with bounds checking
+    reference at(size_type index)
+    {
+        if (index >= size())
+            throw std::out_of_range("index is out of range");
+
+        return (*this)[index];
+    }
+
+    const_reference at(size_type index) const
+    {
+        if (index >= size())
+            throw std::out_of_range("index is out of range");
+
+        return (*this)[index];
+    }
+
+    // access the first element
+    reference front()
+    {
+        if (empty())
+            throw std::logic_error("Empty segmented vector has no front");
+
+        return (*this)[0];
+    }
+
+    const_reference front() const
+    {
+        if (empty())
+            throw std::logic_error("Empty segmented vector has no front");
+
+        return (*this)[0];
+    }
+
+    // access the last element
+    reference back()
+    {
+        if (empty())
+            throw std::logic_error("Empty segmented vector has no back");
+
+        return (*this)[size_ - 1];
+    }
+
+    const_reference back() const
+    {
+        if (empty())
+            throw std::logic_error("Empty segmented vector has no back");
+
+        return (*this)[size_ - 1];
+    }
+
+    // get iterators
+    iterator begin() noexcept
+    {
+        return iterator(table_.data(), 0);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(table_.data(), 0);
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(table_.data(), size_);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(table_.data(), size_);
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept
+    {
+        return rbegin();
+    }
+
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept
+    {
+        return rend();
+    }
+
+    // checks whether the container is empty
+    bool empty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    // returns the number of elements
+    size_type size() const noexcept
+    {
+        return size_;
+    }
+
+    // returns the maximum possible number of elements
+    size_type max_size() const noexcept
+    {
+        return std::numeric_limits<difference_type>::max();
+    }
+
+    // returns the number of elements that can be held in the segments allocated
+    size_type capacity() const noexcept
+    {
+        return table_.size() * SegmentSize;
+    }
+
+    // allocate segments for new_cap elements, no element moves
+    void reserve(size_type new_cap)
+    {
+        if (new_cap > max_size())
+            throw std::length_error("too large");
+
+        size_type segments = (new_cap + mask) >> shift;
+        if (segments > table_.size())
+        {
+            table_.reserve(segments);
+        }
+        while (table_.size() < segments)
+        {
+            add_segment();
+        }
+    }
+
+    // frees the segments no element lives in
+    void shrink_to_fit()
+    {
+        release_segments((size_ + mask) >> shift);
+        table_.shrink_to_fit();
+    }
+
+    // erase all elements, the segments are kept
+    void clear() noexcept
+    {
+        erase_at_end(0);
+    }
+
+    // insert lvalue before pos
+    iterator insert(const_iterator pos, const value_type& value)
+    {
+        return emplace(pos, value);
+    }
+
+    // insert rvalue before pos
+    iterator insert(const_iterator pos, value_type&& value)
+    {
+        return emplace(pos, std::move(value));
+    }
+
+    // inserts count copies of the value before pos
+    iterator insert(const_iterator pos, size_type count, const value_type& value)
+    {
+        size_type index = pos - cbegin();
+        size_type orignal_size = size_;
+        try
+        {
+            append_fill(count, value);
+        }
+        catch (...)
+        {
+            erase_at_end(orignal_size);
+            throw;
+        }
+        return rotate_in(index, orignal_size);
+    }
+
+    // inserts elements from range [first, last) before pos
+    template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
+    iterator insert(const_iterator pos, InputIterator first, InputIterator last)
+    {
+        size_type index = pos - cbegin();
+        size_type orignal_size = size_;
+        try
+        {
+            append_range(first, last);
+        }
+        catch (...)
+        {
+            erase_at_end(orignal_size);
+            throw;
+        }
+        return rotate_in(index, orignal_size);
+    }
+
+    // inserts elements from initializer list ilist before pos
+    iterator insert(const_iterator pos, std::initializer_list<value_type> ilist)
+    {
+        return insert(pos, ilist.begin(), ilist.end());
+    }
+
+    // constructs element in-place, appended first then rotated in place
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        size_type index = pos - cbegin();
+        size_type orignal_size = size_;
+        emplace_back(std::forward<Args>(args)...);
+        return rotate_in(index, orignal_size);
+    }
+
+    // constructs an element in-place at the end
+    template<typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (size_ == capacity())
+        {
+            add_segment();
+        }
+        pointer p = std::addressof((*this)[size_]);
+        Alloc_traits::construct(alloc_, p, std::forward<Args>(args)...);
+        ++size_;
+        return *p;
+    }
+
+    // removes the element at pos
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+
+    // removes the elements in the range [first, last)
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_type index = first - cbegin();
+        iterator target = begin() + index;
+        if (first != last)
+        {
+            iterator finish = std::move(begin() + (last - cbegin()), end(), target);
+            erase_at_end(finish - begin());
+        }
+        return target;
+    }
+
+    // Appends the given element value to the end of the container
+
+    /// The new element is initialized as a copy of value.
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    /// value is moved into the new element.
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    // removes the last element
+    void pop_back()
+    {
+        --size_;
+        Alloc_traits::destroy(alloc_, std::addressof((*this)[size_]));
+    }
+
+    // changes the number of elements stored
+    void resize(size_type count)
+    {
+        if (count > size_)
+        {
+            append_bulk(count - size_, [this] (pointer p, size_type n) {
+                cyy::uninitialized_default_n_a(p, n, alloc_);
+            });
+        }
+        else
+        {
+            erase_at_end(count);
+        }
+    }
+
+    void resize(size_type count, const value_type& value)
+    {
+        if (count > size_)
+        {
+            append_fill(count - size_, value);
+        }
+        else
+        {
+            erase_at_end(count);
+        }
+    }
+
+    // exchange contents
+    void swap(Segmented_vector& other)
+    {
+        if constexpr (Alloc_traits::propagate_on_container_swap::value)
+        {
+            std::swap(alloc_, other.alloc_);
+        }
+        table_.swap(other.table_);
+        std::swap(size_, other.size_);
+    }
+
+private:
+    // run f, destroying everything if it throws, for the constructors
+    template<typename Function>
+    void guarded(Function f)
+    {
+        try
+        {
+            f();
+        }
+        catch (...)
+        {
+            clear();
+            release_segments(0);
+            throw;
+        }
+    }
+
+    void add_segment()
+    {
+        pointer segment = Alloc_traits::allocate(alloc_, SegmentSize);
+        try
+        {
+            table_.push_back(segment);
+        }
+        catch (...)
+        {
+            Alloc_traits::deallocate(alloc_, segment, SegmentSize);
+            throw;
+        }
+    }
+
+    // free the segments from the index first on, they hold no element
+    void release_segments(size_type first) noexcept
+    {
+        while (table_.size() > first)
+        {
+            Alloc_traits::deallocate(alloc_, table_.back(), SegmentSize);
+            table_.pop_back();
+        }
+    }
+
+    void take_storage(Segmented_vector& other) noexcept
+    {
+        table_.swap(other.table_);
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+
+    // destroy the elements from index pos on
+    void erase_at_end(size_type pos) noexcept
+    {
+        while (size_ > pos)
+        {
+            size_type first = std::max(pos, (size_ - 1) & ~mask);
+            cyy::Destroy(std::addressof((*this)[first]), std::addressof((*this)[size_ - 1]) + 1, alloc_);
+            size_ = first;
+        }
+    }
+
+    // Append n elements a segment at a time: construct(p, k) builds k
+    // elements at p inside one segment, cleaning up after itself if it
+    // throws. The segments are allocated first.
+    template<typename Construct>
+    void append_bulk(size_type n, Construct construct)
+    {
+        if (n > max_size() - size_)
+            throw std::length_error("Segmented_vector::append_bulk");
+
+        reserve(size_ + n);
+        while (n > 0)
+        {
+            size_type k = std::min(n, SegmentSize - (size_ & mask));
+            construct(std::addressof((*this)[size_]), k);
+            size_ += k;
+            n -= k;
+        }
+    }
+
+    void append_fill(size_type n, const value_type& value)
+    {
+        append_bulk(n, [this, &value] (pointer p, size_type k) {
+            cyy::uninitialized_fill_n_a(p, k, value, alloc_);
+        });
+    }
+
+    template<typename InputIterator>
+    void append_range(InputIterator first, InputIterator last)
+    {
+        using Iterator_category = typename std::iterator_traits<InputIterator>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Iterator_category>)
+        {
+            append_bulk(std::distance(first, last), [this, &first] (pointer p, size_type k) {
+                InputIterator mid = std::next(first, k);
+                cyy::uninitialized_copy_a(first, mid, p, alloc_);
+                first = mid;
+            });
+        }
+        else
+        {
+            for (; first != last; ++first)
+            {
+                emplace_back(*first);
+            }
+        }
+    }
+
+    // move the elements appended from orignal_size on to index
+    iterator rotate_in(size_type index, size_type orignal_size)
+    {
+        std::rotate(begin() + index, begin() + orignal_size, end());
+        return begin() + index;
+    }
+
+    allocator_type alloc_;
+    Table table_;
+    size_type size_;
+}; // class Segmented_vector
+
+// lexicographically compares the values in the segmented vector
+template<typename T, typename Alloc, std::size_t S>
+inline bool operator==(const Segmented_vector<T, Alloc, S>& lhs, const Segmented_vector<T, Alloc, S>& rhs)
+{
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template<typename T, typename Alloc, std::size_t S>
+inline bool operator!=(const Segmented_vector<T, Alloc, S>& lhs, const Segmented_vector<T, Alloc, S>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename T, typename Alloc, std::size_t S>
+inline bool operator<(const Segmented_vector<T, Alloc, S>& lhs, const Segmented_vector<T, Alloc, S>& rhs)
+{
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template<typename T, typename Alloc, std::size_t S>
+inline bool operator>(const Segmented_vector<T, Alloc, S>& lhs, const Segmented_vector<T, Alloc, S>& rhs)
+{
+    return rhs < lhs;
+}
+
+template<typename T, typename Alloc, std::size_t S>
+inline bool operator<=(const Segmented_vector<T, Alloc, S>& lhs, const Segmented_vector<T, Alloc, S>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template<typename T, typename Alloc, std::size_t S>
+inline bool operator>=(const Segmented_vector<T, Alloc, S>& lhs, const Segmented_vector<T, Alloc, S>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+// swap Segmented_vector
+template<typename T, typename Alloc, std::size_t S>
+inline void swap(Segmented_vector<T, Alloc, S>& x, Segmented_vector<T, Alloc, S>& y)
+{
+    x.swap(y);
+}
+
+} // namespace cyy
+
+#endif // SEGMENTED_VECTOR_H
@@ -0,0 +1,367 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include "vector.h"
+
+namespace cyy
+{
+namespace detail
+{
+// room for N elements inside a Small_vector, in_use tells whether it holds
+// the storage of the Small_vector right now
+template<typename T, std::size_t N>
+struct Small_vector_storage
+{
+    Small_vector_storage() noexcept
+        : in_use(false)
+    {
+    }
+
+    // the buffer belongs to one object, it is never copied
+    Small_vector_storage(const Small_vector_storage&) noexcept
+        : in_use(false)
+    {
+    }
+
+    Small_vector_storage& operator=(const Small_vector_storage&) noexcept
+    {
+        return *this;
+    }
+
+    T* buffer() noexcept
+    {
+        return reinterpret_cast<T*>(bytes);
+    }
+
+    bool in_use;
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+};
+} // namespace detail
+
+// Allocator of Small_vector: a request of N elements or fewer gets the inline
+// buffer while it is free, anything else goes to Alloc. Copies share the
+// buffer, so a temporary made with get_allocator() can hand it back.
+// Two of them are equal only if they share the buffer, the memory of one
+// Small_vector is never taken over by another through the allocator.
+template<typename T, std::size_t N, typename Alloc = cyy::Allocator<T>>
+class Small_buffer_allocator
+{
+    using Alloc_traits = cyy::Allocator_traits<Alloc>;
+
+public:
+    using value_type      = T;
+    using pointer         = T*;
+    using const_pointer   = const T*;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::false_type;
+    using Storage = detail::Small_vector_storage<T, N>;
+
+    // constructors
+    Small_buffer_allocator() noexcept
+        : storage_(nullptr), alloc_()
+    {
+    }
+
+    explicit Small_buffer_allocator(Storage* storage, const Alloc& alloc = Alloc()) noexcept
+        : storage_(storage), alloc_(alloc)
+    {
+    }
+
+    // a rebound allocator has no buffer
+    template<typename U, std::size_t M, typename A>
+    Small_buffer_allocator(const Small_buffer_allocator<U, M, A>& other) noexcept
+        : storage_(nullptr), alloc_(other.underlying())
+    {
+    }
+
+    template<typename T1>
+    struct rebind
+    {
+        using other = Small_buffer_allocator<T1, N, typename Alloc_traits::template rebind_alloc<T1>>;
+    };
+
+    pointer allocate(size_type n)
+    {
+        if (n <= N && storage_ != nullptr && !storage_->in_use)
+        {
+            storage_->in_use = true;
+            return storage_->buffer();
+        }
+        return Alloc_traits::allocate(alloc_, n);
+    }
+
+    // the inline buffer is given whole
+    Allocation_result<pointer, size_type> allocate_at_least(size_type n)
+    {
+        if (n <= N && storage_ != nullptr && !storage_->in_use)
+        {
+            storage_->in_use = true;
+            return {storage_->buffer(), N};
+        }
+        auto result = Alloc_traits::allocate_at_least(alloc_, n);
+        return {result.ptr, result.count};
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if (is_inline(p))
+        {
+            storage_->in_use = false;
+        }
+        else
+        {
+            Alloc_traits::deallocate(alloc_, p, n);
+        }
+    }
+
+    size_type max_size() const noexcept
+    {
+        return Alloc_traits::max_size(alloc_);
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        Alloc_traits::construct(alloc_, p, std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    void destroy(U* p)
+    {
+        Alloc_traits::destroy(alloc_, p);
+    }
+
+    Small_buffer_allocator select_on_container_copy_construction() const
+    {
+        return Small_buffer_allocator(nullptr, Alloc_traits::select_on_container_copy_construction(alloc_));
+    }
+
+    // whether p is the inline buffer
+    bool is_inline(const_pointer p) const noexcept
+    {
+        return storage_ != nullptr && p == storage_->buffer();
+    }
+
+    Storage* storage() const noexcept
+    {
+        return storage_;
+    }
+
+    const Alloc& underlying() const noexcept
+    {
+        return alloc_;
+    }
+
+private:
+    Storage* storage_;
+    Alloc alloc_;
+};
+
+template<typename T1, typename T2, std::size_t N1, std::size_t N2, typename A1, typename A2>
+inline bool operator==(const Small_buffer_allocator<T1, N1, A1>& lhs,
+                       const Small_buffer_allocator<T2, N2, A2>& rhs) noexcept
+{
+    return static_cast<const void*>(lhs.storage()) == static_cast<const void*>(rhs.storage())
+        && lhs.underlying() == rhs.underlying();
+}
+
+template<typename T1, typename T2, std::size_t N1, std::size_t N2, typename A1, typename A2>
+inline bool operator!=(const Small_buffer_allocator<T1, N1, A1>& lhs,
+                       const Small_buffer_allocator<T2, N2, A2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+// Vector keeping up to N elements inside the object, it allocates from
+// Alloc only when it grows past them. All the work is done by Vector
+// through Small_buffer_allocator, Small_vector only has to keep the
+// buffer out of moves and swaps: an inline buffer can't change owner, so
+// its elements are moved one by one, heap storage is taken as Vector does.
+template<typename T, std::size_t N, typename Alloc = cyy::Allocator<T>>
+class Small_vector
+    : private detail::Small_vector_storage<T, N>,
+      public Vector<T, Small_buffer_allocator<T, N, Alloc>>
+{
+    static_assert(N > 0, "Small_vector needs room for one element at least");
+
+    using Storage = detail::Small_vector_storage<T, N>;
+    using Base = Vector<T, Small_buffer_allocator<T, N, Alloc>>;
+    using Base::data_impl;
+    using Base::get_alloc_ref;
+    using Base::deallocate;
+
+public:
+    using value_type     = T;
+    using allocator_type = typename Base::allocator_type;
+    using size_type      = typename Base::size_type;
+
+    static constexpr size_type inline_capacity = N;
+
+    // construct
+    Small_vector()
+        : Storage(), Base(allocator_type(this_storage()))
+    {
+        claim_buffer();
+    }
+
+    explicit Small_vector(const Alloc& alloc)
+        : Storage(), Base(allocator_type(this_storage(), alloc))
+    {
+        claim_buffer();
+    }
+
+    Small_vector(size_type count, const value_type& value, const Alloc& alloc = Alloc())
+        : Storage(), Base(count, value, allocator_type(this_storage(), alloc))
+    {
+        claim_buffer();
+    }
+
+    explicit Small_vector(size_type count, const Alloc& alloc = Alloc())
+        : Storage(), Base(count, allocator_type(this_storage(), alloc))
+    {
+        claim_buffer();
+    }
+
+    Small_vector(std::initializer_list<value_type> l, const Alloc& alloc = Alloc())
+        : Storage(), Base(l, allocator_type(this_storage(), alloc))
+    {
+        claim_buffer();
+    }
+
+    template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
+    Small_vector(InputIterator first, InputIterator last, const Alloc& alloc = Alloc())
+        : Storage(), Base(first, last, allocator_type(this_storage(), alloc))
+    {
+        claim_buffer();
+    }
+
+    Small_vector(const Small_vector& other)
+        : Storage(),
+          Base(other, allocator_type(this_storage(), cyy::Allocator_traits<Alloc>::
+                                     select_on_container_copy_construction(other.get_alloc_ref().underlying())))
+    {
+        claim_buffer();
+    }
+
+    Small_vector(Small_vector&& other)
+        noexcept(std::is_nothrow_move_constructible_v<T> && cyy::Allocator_traits<Alloc>::is_always_equal::value)
+        : Storage(), Base(allocator_type(this_storage(), other.get_alloc_ref().underlying()))
+    {
+        claim_buffer();
+        move_from(other);
+    }
+
+    // assignment
+    Small_vector& operator=(const Small_vector& rhs)
+    {
+        Base::operator=(rhs);
+        return *this;
+    }
+
+    Small_vector& operator=(Small_vector&& rhs)
+    {
+        if (&rhs != this)
+        {
+            this->clear();
+            move_from(rhs);
+        }
+        return *this;
+    }
+
+    Small_vector& operator=(std::initializer_list<value_type> ilist)
+    {
+        Base::operator=(ilist);
+        return *this;
+    }
+
+    // whether the elements are in the inline buffer
+    bool is_inline() const noexcept
+    {
+        return get_alloc_ref().is_inline(data_impl.start);
+    }
+
+    // inline storage is never given back
+    void shrink_to_fit()
+    {
+        if (!is_inline())
+        {
+            Base::shrink_to_fit();
+        }
+    }
+
+    // exchange contents, the elements are moved unless both are on the heap
+    void swap(Small_vector& other)
+    {
+        if (&other == this)
+        {
+            return;
+        }
+        if (!is_inline() && !other.is_inline() && get_alloc_ref().underlying() == other.get_alloc_ref().underlying())
+        {
+            data_impl.swap(other.data_impl);
+        }
+        else
+        {
+            Small_vector tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+    }
+
+private:
+    Storage* this_storage() noexcept
+    {
+        return static_cast<Storage*>(this);
+    }
+
+    // the inline buffer is all ours: an empty Small_vector starts in it, and
+    // elements in it have room for N
+    void claim_buffer() noexcept
+    {
+        if (data_impl.start == nullptr)
+        {
+            this->in_use = true;
+            data_impl.start = data_impl.finish = this->buffer();
+        }
+        if (is_inline())
+        {
+            data_impl.end_of_storage = this->buffer() + N;
+        }
+    }
+
+    // this is empty, take the heap storage of other or move its elements
+    void move_from(Small_vector& other)
+    {
+        if (other.data_impl.start != nullptr && !other.is_inline()
+            && get_alloc_ref().underlying() == other.get_alloc_ref().underlying())
+        {
+            deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
+            data_impl.start = data_impl.finish = data_impl.end_of_storage = nullptr;
+            data_impl.swap(other.data_impl);
+            other.claim_buffer();
+        }
+        else
+        {
+            this->assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+            other.clear();
+        }
+    }
+}; // class Small_vector
+
+// swap Small_vector
+template<typename T, std::size_t N, typename Alloc>
+inline void swap(Small_vector<T, N, Alloc>& x, Small_vector<T, N, Alloc>& y)
+{
+    x.swap(y);
+}
+
+} // namespace cyy
+
+#endif // SMALL_VECTOR_H
@@ -9,6 +9,7 @@
 #include <system_error>
 #include <exception>
 #include <pthread.h>
+#include <sched.h>
 #include <time.h>
 
 #include "integer_sequence.h"
@@ -189,7 +190,7 @@ inline Thread::id get_id() noexcept
 
 inline void yield()
 {
-    ::pthread_yield();
+    ::sched_yield();
 }
 
 template<typename Rep, typename Period>
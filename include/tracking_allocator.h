@@ -0,0 +1,357 @@
+#ifndef TRACKING_ALLOCATOR_H
+#define TRACKING_ALLOCATOR_H
+
+#include <atomic>
+#include <string>
+#include <ostream>
+#include <cstddef>
+#include <typeinfo>
+#include <type_traits>
+#include "allocator_traits.h"
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+namespace cyy
+{
+// counters of an Allocation_stats read at one moment
+struct Allocation_snapshot
+{
+    enum { NBUCKETS = 32 };
+
+    std::size_t allocations;
+    std::size_t deallocations;
+    std::size_t bytes_in_use;
+    std::size_t peak_bytes;
+    std::size_t total_bytes;
+    // histogram[i] counts the allocations of (2^(i-1), 2^i] bytes,
+    // the last bucket counts all the larger ones
+    std::size_t histogram[NBUCKETS];
+};
+
+// Counters updated by Tracking_allocator. They are atomic so that
+// allocators of several threads can share them, and relaxed because
+// no other memory is published through them.
+class Allocation_stats
+{
+public:
+    enum { NBUCKETS = Allocation_snapshot::NBUCKETS };
+
+    Allocation_stats() noexcept
+    {
+        reset();
+    }
+
+    Allocation_stats(const Allocation_stats&) = delete;
+
+    Allocation_stats& operator=(const Allocation_stats&) = delete;
+
+    void record_allocate(std::size_t bytes) noexcept
+    {
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        total_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        histogram_[bucket(bytes)].fetch_add(1, std::memory_order_relaxed);
+        std::size_t in_use = bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        std::size_t peak = peak_bytes_.load(std::memory_order_relaxed);
+        while (in_use > peak && !peak_bytes_.compare_exchange_weak(peak, in_use, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void record_deallocate(std::size_t bytes) noexcept
+    {
+        deallocations_.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    Allocation_snapshot snapshot() const noexcept
+    {
+        Allocation_snapshot s;
+        s.allocations = allocations_.load(std::memory_order_relaxed);
+        s.deallocations = deallocations_.load(std::memory_order_relaxed);
+        s.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+        s.peak_bytes = peak_bytes_.load(std::memory_order_relaxed);
+        s.total_bytes = total_bytes_.load(std::memory_order_relaxed);
+        for (int i = 0; i < NBUCKETS; ++i)
+        {
+            s.histogram[i] = histogram_[i].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+    // start counting again, the peak restarts from the bytes in use
+    void reset() noexcept
+    {
+        allocations_.store(0, std::memory_order_relaxed);
+        deallocations_.store(0, std::memory_order_relaxed);
+        total_bytes_.store(0, std::memory_order_relaxed);
+        peak_bytes_.store(bytes_in_use_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        for (int i = 0; i < NBUCKETS; ++i)
+        {
+            histogram_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // upper bound of the bytes counted by the bucket i
+    static std::size_t bucket_limit(int i) noexcept
+    {
+        return std::size_t(1) << i;
+    }
+
+    static int bucket(std::size_t bytes) noexcept
+    {
+        int i = 0;
+        while (i < NBUCKETS - 1 && bucket_limit(i) < bytes)
+        {
+            ++i;
+        }
+        return i;
+    }
+
+private:
+    std::atomic<std::size_t> allocations_;
+    std::atomic<std::size_t> deallocations_;
+    std::atomic<std::size_t> bytes_in_use_{0};
+    std::atomic<std::size_t> peak_bytes_;
+    std::atomic<std::size_t> total_bytes_;
+    std::atomic<std::size_t> histogram_[NBUCKETS];
+};
+
+namespace detail
+{
+// Allocation_stats of a type, linked in a list so that all of them can be
+// walked. Entries are never removed.
+struct Allocation_stats_entry
+{
+    std::string name;
+    Allocation_stats stats;
+    Allocation_stats_entry* next;
+};
+
+inline std::atomic<Allocation_stats_entry*>& allocation_stats_list() noexcept
+{
+    static std::atomic<Allocation_stats_entry*> head{nullptr};
+    return head;
+}
+
+inline std::string type_name(const std::type_info& type)
+{
+#if defined(__GNUG__)
+    int status = 0;
+    char* name = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && name != nullptr)
+    {
+        std::string s(name);
+        std::free(name);
+        return s;
+    }
+#endif
+    return type.name();
+}
+
+// Tag::name() if present, otherwise the name of Tag
+template<typename Tag>
+auto stats_name(int) -> decltype(std::string(Tag::name()))
+{
+    return std::string(Tag::name());
+}
+
+template<typename Tag>
+std::string stats_name(...)
+{
+    return type_name(typeid(Tag));
+}
+
+template<typename Tag>
+Allocation_stats_entry& allocation_stats_entry()
+{
+    static Allocation_stats_entry* entry = [] {
+        auto e = new Allocation_stats_entry{stats_name<Tag>(0), {}, nullptr};
+        auto& head = allocation_stats_list();
+        e->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        return e;
+    }();
+    return *entry;
+}
+
+inline void write_json_string(std::ostream& os, const std::string& s)
+{
+    os << '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            os << '\\';
+        }
+        os << c;
+    }
+    os << '"';
+}
+} // namespace detail
+
+// the counters of the allocations made for Tag
+template<typename Tag>
+Allocation_stats& allocation_stats()
+{
+    return detail::allocation_stats_entry<Tag>().stats;
+}
+
+// call f(name, snapshot) for every type allocated through a Tracking_allocator
+template<typename Function>
+void for_each_allocation_stats(Function f)
+{
+    auto e = detail::allocation_stats_list().load(std::memory_order_acquire);
+    for (; e != nullptr; e = e->next)
+    {
+        f(e->name, e->stats.snapshot());
+    }
+}
+
+inline void reset_allocation_stats() noexcept
+{
+    auto e = detail::allocation_stats_list().load(std::memory_order_acquire);
+    for (; e != nullptr; e = e->next)
+    {
+        e->stats.reset();
+    }
+}
+
+// write every counter as a JSON array, empty histogram buckets are left out
+inline void dump_allocation_stats(std::ostream& os)
+{
+    bool first = true;
+    os << '[';
+    for_each_allocation_stats([&os, &first] (const std::string& name, const Allocation_snapshot& s) {
+        os << (first ? "\n" : ",\n") << "  {\"type\": ";
+        detail::write_json_string(os, name);
+        os << ", \"allocations\": " << s.allocations
+           << ", \"deallocations\": " << s.deallocations
+           << ", \"bytes_in_use\": " << s.bytes_in_use
+           << ", \"peak_bytes\": " << s.peak_bytes
+           << ", \"total_bytes\": " << s.total_bytes
+           << ", \"histogram\": {";
+        bool first_bucket = true;
+        for (int i = 0; i < Allocation_snapshot::NBUCKETS; ++i)
+        {
+            if (s.histogram[i] != 0)
+            {
+                os << (first_bucket ? "" : ", ") << '"' << Allocation_stats::bucket_limit(i) << "\": " << s.histogram[i];
+                first_bucket = false;
+            }
+        }
+        os << "}}";
+        first = false;
+    });
+    os << (first ? "]" : "\n]") << '\n';
+}
+
+// Allocator recording every allocation of Alloc in allocation_stats<Tag>().
+// With the default Tag the counters go to the type allocated, which tells
+// the containers apart: Vector<int> allocates int, List<int> allocates
+// List_node<int>. An explicit Tag is kept when the allocator is rebound.
+template<typename Alloc, typename Tag = void>
+class Tracking_allocator
+{
+    using Alloc_traits = cyy::Allocator_traits<Alloc>;
+
+public:
+    using value_type      = typename Alloc_traits::value_type;
+    using pointer         = typename Alloc_traits::pointer;
+    using const_pointer   = typename Alloc_traits::const_pointer;
+    using size_type       = typename Alloc_traits::size_type;
+    using difference_type = typename Alloc_traits::difference_type;
+    using propagate_on_container_copy_assignment = typename Alloc_traits::propagate_on_container_copy_assignment;
+    using propagate_on_container_move_assignment = typename Alloc_traits::propagate_on_container_move_assignment;
+    using propagate_on_container_swap = typename Alloc_traits::propagate_on_container_swap;
+    using is_always_equal = typename Alloc_traits::is_always_equal;
+    using is_deallocate_noop = typename Alloc_traits::is_deallocate_noop;
+    using stats_tag = std::conditional_t<std::is_void<Tag>::value, value_type, Tag>;
+
+    // constructors
+    Tracking_allocator() = default;
+
+    Tracking_allocator(const Alloc& alloc) noexcept
+        : alloc_(alloc)
+    {
+    }
+
+    template<typename A>
+    Tracking_allocator(const Tracking_allocator<A, Tag>& other) noexcept
+        : alloc_(other.underlying())
+    {
+    }
+
+    template<typename T1>
+    struct rebind
+    {
+        using other = Tracking_allocator<typename Alloc_traits::template rebind_alloc<T1>, Tag>;
+    };
+
+    pointer allocate(size_type n)
+    {
+        pointer p = Alloc_traits::allocate(alloc_, n);
+        stats().record_allocate(n * sizeof(value_type));
+        return p;
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        stats().record_deallocate(n * sizeof(value_type));
+        Alloc_traits::deallocate(alloc_, p, n);
+    }
+
+    size_type max_size() const noexcept
+    {
+        return Alloc_traits::max_size(alloc_);
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        Alloc_traits::construct(alloc_, p, std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    void destroy(U* p)
+    {
+        Alloc_traits::destroy(alloc_, p);
+    }
+
+    Tracking_allocator select_on_container_copy_construction() const
+    {
+        return Tracking_allocator(Alloc_traits::select_on_container_copy_construction(alloc_));
+    }
+
+    // the counters of this allocator
+    static Allocation_stats& stats()
+    {
+        return allocation_stats<stats_tag>();
+    }
+
+    const Alloc& underlying() const noexcept
+    {
+        return alloc_;
+    }
+
+private:
+    Alloc alloc_;
+};
+
+template<typename A1, typename A2, typename Tag>
+inline bool operator==(const Tracking_allocator<A1, Tag>& lhs, const Tracking_allocator<A2, Tag>& rhs) noexcept
+{
+    return lhs.underlying() == rhs.underlying();
+}
+
+template<typename A1, typename A2, typename Tag>
+inline bool operator!=(const Tracking_allocator<A1, Tag>& lhs, const Tracking_allocator<A2, Tag>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+} // namespace cyy
+
+#endif // TRACKING_ALLOCATOR_H
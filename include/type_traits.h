@@ -25,6 +25,19 @@ struct decay_and_strip
     using type = typename strip_reference_wrapper<typename std::decay<T>::type>::type;
 };
 
+// Whether an object can be moved to new storage, and the old one ended, by
+// copying its bytes without calling any constructor or destructor.
+// True for trivially copyable types, specialize it for the others where it
+// holds, e.g. types owning a heap pointer but no pointer into themselves.
+template<typename T>
+struct is_trivially_relocatable
+    : std::is_trivially_copyable<T>
+{
+};
+
+template<typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
 } // namespace cyy
 
 #endif // TYPE_TRAITS
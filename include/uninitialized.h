@@ -3,9 +3,216 @@
 
 #include "allocator_traits.h"
 #include "construct.h"
+#include "type_traits.h"
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
 
 namespace cyy
 {
+namespace detail
+{
+// [first, last) can be copied into target by memmove: both are pointers to the
+// same type, whose copy (or move) constructor only copies bytes
+template<typename InputIterator, typename ForwardIterator, bool Move>
+struct is_memmove_constructible
+{
+    static constexpr bool value = false;
+};
+
+template<typename T1, typename T2, bool Move>
+struct is_memmove_constructible<T1*, T2*, Move>
+{
+    static constexpr bool value = std::is_same_v<std::remove_const_t<T1>, T2>
+        && std::is_trivially_copyable_v<T2>
+        && (Move ? std::is_trivially_move_constructible_v<T2> : std::is_trivially_copy_constructible_v<T2>);
+};
+
+template<typename T>
+T* memmove_construct(const T* first, const T* last, T* target) noexcept
+{
+    std::size_t n = last - first;
+    if (n != 0)
+    {
+        std::memmove(static_cast<void*>(target), static_cast<const void*>(first), n * sizeof(T));
+    }
+    return target + n;
+}
+} // namespace detail
+
+// Constructs without an allocator, trivial types are handled by memmove,
+// memset or std::fill_n instead of one constructor call per element.
+
+// value-initialize n elements starting with first
+template<typename ForwardIterator, typename Size>
+ForwardIterator uninitialized_default_n(ForwardIterator first, Size n)
+{
+    using Value_type = typename std::iterator_traits<ForwardIterator>::value_type;
+    if constexpr (std::is_pointer_v<ForwardIterator> && std::is_trivial_v<Value_type>)
+    {
+        if (n <= 0)
+        {
+            return first;
+        }
+        // all bits zero is the zero of integers, floating points and pointers
+        if constexpr (std::is_arithmetic_v<Value_type> || std::is_pointer_v<Value_type>)
+        {
+            std::memset(static_cast<void*>(first), 0, n * sizeof(Value_type));
+            return first + n;
+        }
+        else
+        {
+            return std::fill_n(first, n, Value_type());
+        }
+    }
+    else
+    {
+        ForwardIterator cur = first;
+        try
+        {
+            for (; n > 0; --n, ++cur)
+            {
+                Construct(std::addressof(*cur));
+            }
+            return cur;
+        }
+        catch (...)
+        {
+            cyy::Destroy(first, cur);
+            throw;
+        }
+    }
+}
+
+// default-initialize n elements starting with first, trivial types are left
+// with whatever the memory holds
+template<typename ForwardIterator, typename Size>
+ForwardIterator uninitialized_default_init_n(ForwardIterator first, Size n)
+{
+    using Value_type = typename std::iterator_traits<ForwardIterator>::value_type;
+    if constexpr (std::is_trivially_default_constructible_v<Value_type>)
+    {
+        std::advance(first, n > 0 ? n : 0);
+        return first;
+    }
+    else
+    {
+        ForwardIterator cur = first;
+        try
+        {
+            for (; n > 0; --n, ++cur)
+            {
+                ::new(static_cast<void*>(std::addressof(*cur))) Value_type;
+            }
+            return cur;
+        }
+        catch (...)
+        {
+            cyy::Destroy(first, cur);
+            throw;
+        }
+    }
+}
+
+// copy-construct n elements starting with first from value
+template<typename ForwardIterator, typename Size, typename Value>
+ForwardIterator uninitialized_fill_n(ForwardIterator first, Size n, const Value& value)
+{
+    using Value_type = typename std::iterator_traits<ForwardIterator>::value_type;
+    if constexpr (std::is_pointer_v<ForwardIterator> && std::is_trivial_v<Value_type>
+                  && std::is_same_v<Value, Value_type>)
+    {
+        if (n <= 0)
+        {
+            return first;
+        }
+        if constexpr (sizeof(Value_type) == 1)
+        {
+            unsigned char byte;
+            std::memcpy(&byte, &value, 1);
+            std::memset(static_cast<void*>(first), byte, n);
+            return first + n;
+        }
+        else
+        {
+            // a plain store loop, which the compiler vectorizes
+            return std::fill_n(first, n, value);
+        }
+    }
+    else
+    {
+        ForwardIterator cur = first;
+        try
+        {
+            for (; n > 0; --n, ++cur)
+            {
+                Construct(std::addressof(*cur), value);
+            }
+            return cur;
+        }
+        catch (...)
+        {
+            cyy::Destroy(first, cur);
+            throw;
+        }
+    }
+}
+
+// copy-construct [first, last) into target
+template<typename InputIterator, typename ForwardIterator>
+ForwardIterator uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator target)
+{
+    if constexpr (detail::is_memmove_constructible<InputIterator, ForwardIterator, false>::value)
+    {
+        return detail::memmove_construct(first, last, target);
+    }
+    else
+    {
+        ForwardIterator cur = target;
+        try
+        {
+            for (; first != last; ++first, ++cur)
+            {
+                Construct(std::addressof(*cur), *first);
+            }
+            return cur;
+        }
+        catch (...)
+        {
+            cyy::Destroy(target, cur);
+            throw;
+        }
+    }
+}
+
+// move-construct [first, last) into target
+template<typename InputIterator, typename ForwardIterator>
+ForwardIterator uninitialized_move(InputIterator first, InputIterator last, ForwardIterator target)
+{
+    if constexpr (detail::is_memmove_constructible<InputIterator, ForwardIterator, true>::value)
+    {
+        return detail::memmove_construct(first, last, target);
+    }
+    else
+    {
+        ForwardIterator cur = target;
+        try
+        {
+            for (; first != last; ++first, ++cur)
+            {
+                Construct(std::addressof(*cur), std::move(*first));
+            }
+            return cur;
+        }
+        catch (...)
+        {
+            cyy::Destroy(target, cur);
+            throw;
+        }
+    }
+}
+
 // construct n elements starting with first allocated by alloc
 template<typename ForwardIterator, typename Size, typename Allocator>
 ForwardIterator uninitialized_default_n_a(ForwardIterator first, Size n, Allocator& alloc)
@@ -46,6 +253,35 @@ ForwardIterator uninitialized_fill_n_a(ForwardIterator first, Size n, const Valu
     }
 }
 
+// Allocator<T> constructs by placement new, the algorithms without allocator
+// apply
+template<typename ForwardIterator, typename Size, typename T>
+ForwardIterator uninitialized_default_n_a(ForwardIterator first, Size n, Allocator<T>&)
+{
+    return cyy::uninitialized_default_n(first, n);
+}
+
+template<typename ForwardIterator, typename Size, typename Value, typename T>
+ForwardIterator uninitialized_fill_n_a(ForwardIterator first, Size n, const Value& value, Allocator<T>&)
+{
+    return cyy::uninitialized_fill_n(first, n, value);
+}
+
+// Default-initialize n elements starting with first allocated by alloc.
+// Construction belongs to alloc, so they are built by alloc.construct(p),
+// which value-initializes unless alloc says otherwise (Default_init_allocator).
+template<typename ForwardIterator, typename Size, typename Allocator>
+ForwardIterator uninitialized_default_init_n_a(ForwardIterator first, Size n, Allocator& alloc)
+{
+    return cyy::uninitialized_default_n_a(first, n, alloc);
+}
+
+template<typename ForwardIterator, typename Size, typename T>
+ForwardIterator uninitialized_default_init_n_a(ForwardIterator first, Size n, Allocator<T>&)
+{
+    return cyy::uninitialized_default_init_n(first, n);
+}
+
 // construct value from first to last via Allocator
 template<typename ForwardIterator, typename Value, typename Allocator>
 void uninitialized_fill_a(ForwardIterator first, ForwardIterator last, const Value& value, Allocator& alloc)
@@ -86,6 +322,13 @@ ForwardIterator uninitialized_copy_a(InputIterator first, InputIterator last,
     }
 }
 
+template<typename InputIterator, typename ForwardIterator, typename T>
+ForwardIterator uninitialized_copy_a(InputIterator first, InputIterator last,
+                                     ForwardIterator target, Allocator<T>&)
+{
+    return cyy::uninitialized_copy(first, last, target);
+}
+
 template<typename InputIterator, typename ForwardIterator, typename Allocator>
 ForwardIterator uninitialized_move_a(InputIterator first, InputIterator last,
                                      ForwardIterator target, Allocator& alloc)
@@ -107,6 +350,13 @@ ForwardIterator uninitialized_move_a(InputIterator first, InputIterator last,
     }
 }
 
+template<typename InputIterator, typename ForwardIterator, typename T>
+ForwardIterator uninitialized_move_a(InputIterator first, InputIterator last,
+                                     ForwardIterator target, Allocator<T>&)
+{
+    return cyy::uninitialized_move(first, last, target);
+}
+
 template<typename InputIterator, typename ForwardIterator, typename Allocator>
 ForwardIterator uninitialized_move_if_noexcept_a(InputIterator first, InputIterator last,
                                      ForwardIterator target, Allocator& alloc)
@@ -128,5 +378,54 @@ ForwardIterator uninitialized_move_if_noexcept_a(InputIterator first, InputItera
     }
 }
 
+template<typename InputIterator, typename ForwardIterator, typename T>
+ForwardIterator uninitialized_move_if_noexcept_a(InputIterator first, InputIterator last,
+                                     ForwardIterator target, Allocator<T>&)
+{
+    using Value_type = typename std::iterator_traits<InputIterator>::value_type;
+    if constexpr (std::is_nothrow_move_constructible_v<Value_type> || !std::is_copy_constructible_v<Value_type>)
+    {
+        return cyy::uninitialized_move(first, last, target);
+    }
+    else
+    {
+        return cyy::uninitialized_copy(first, last, target);
+    }
+}
+
+// First half of a relocation: move [first, last) into uninitialized target.
+// The originals must then be ended by Destroy_relocated(first, last, alloc).
+// Trivially relocatable elements are copied by one memcpy, neither their
+// move constructor nor alloc.construct is called.
+template<typename T, typename Allocator>
+T* uninitialized_relocate_a(T* first, T* last, T* target, Allocator& alloc)
+{
+    if constexpr (is_trivially_relocatable<T>::value)
+    {
+        std::size_t n = last - first;
+        if (n != 0)
+        {
+            std::memcpy(static_cast<void*>(target), static_cast<const void*>(first), n * sizeof(T));
+        }
+        return target + n;
+    }
+    else
+    {
+        return cyy::uninitialized_move_if_noexcept_a(first, last, target, alloc);
+    }
+}
+
+// Second half of a relocation: end the elements moved out by
+// uninitialized_relocate_a, their bytes now live elsewhere if they are
+// trivially relocatable, so nothing is destroyed then.
+template<typename T, typename Allocator>
+void Destroy_relocated(T* first, T* last, Allocator& alloc)
+{
+    if constexpr (!is_trivially_relocatable<T>::value)
+    {
+        cyy::Destroy(first, last, alloc);
+    }
+}
+
 }
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define UNIQUE_PTR
 
 #include <type_traits>
+#include "type_traits.h"
 
 namespace cyy
 {
@@ -687,6 +688,13 @@ bool operator>=(std::nullptr_t, const Unique_ptr<T, D>& x)
 {
     return !(nullptr < x);
 }
+
+// a Unique_ptr is a pointer and a deleter
+template<typename T, typename D>
+struct is_trivially_relocatable<Unique_ptr<T, D>>
+    : is_trivially_relocatable<D>
+{
+};
 } // namespce cyy
 
 #endif // UNIQUE_PTR
@@ -0,0 +1,1257 @@
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include <limits>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <initializer_list>
+#include "allocator.h"
+#include "allocator_traits.h"
+#include "polymorphic_allocator.h"
+#include "construct.h"
+#include "vector.h"
+
+namespace cyy
+{
+template<typename T, std::size_t B, typename Alloc>
+class Unrolled_list;
+
+namespace detail
+{
+// elements in a node of about 512 bytes, 8 at least
+constexpr std::size_t default_unrolled_node_size(std::size_t elem_size)
+{
+    std::size_t n = (512 - 4 * sizeof(void*)) / elem_size;
+    return n < 8 ? 8 : n;
+}
+
+// Links of an Unrolled_list node and its occupied slots: the elements are
+// in the slots first up to last, free slots may be left on either side.
+// The head of the list is a node base with no slot.
+struct Unrolled_list_node_base
+{
+    std::size_t size() const noexcept
+    {
+        return last - first;
+    }
+
+    Unrolled_list_node_base* prev;
+    Unrolled_list_node_base* next;
+    std::size_t first;
+    std::size_t last;
+};
+
+template<typename T, std::size_t B>
+struct Unrolled_list_node : Unrolled_list_node_base
+{
+    T* slots() noexcept
+    {
+        return static_cast<T*>(static_cast<void*>(&storage));
+    }
+
+    typename std::aligned_storage<sizeof(T) * B, alignof(T)>::type storage;
+};
+
+// Iterator of Unrolled_list: a node and a slot in it, the end iterator is
+// the head at slot 0.
+template<typename T, typename Ref, typename Ptr, std::size_t B>
+class Unrolled_list_iterator
+{
+    template<typename U, typename R, typename P, std::size_t N>
+    friend class Unrolled_list_iterator;
+
+    template<typename U, std::size_t N, typename A>
+    friend class cyy::Unrolled_list;
+
+    using node_base = Unrolled_list_node_base;
+    using node_type = Unrolled_list_node<T, B>;
+
+public:
+    using self = Unrolled_list_iterator;
+
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using pointer = Ptr;
+    using reference = Ref;
+
+    Unrolled_list_iterator() noexcept
+        : node(nullptr), slot(0)
+    {
+    }
+
+    Unrolled_list_iterator(node_base* node, std::size_t slot) noexcept
+        : node(node), slot(slot)
+    {
+    }
+
+    // iterator to const_iterator
+    template<typename R, typename P, typename = std::enable_if_t<std::is_convertible_v<P, Ptr>>>
+    Unrolled_list_iterator(const Unrolled_list_iterator<T, R, P, B>& other) noexcept
+        : node(other.node), slot(other.slot)
+    {
+    }
+
+    reference operator*() const
+    {
+        return static_cast<node_type*>(node)->slots()[slot];
+    }
+
+    pointer operator->() const
+    {
+        return std::addressof(**this);
+    }
+
+    self& operator++() noexcept
+    {
+        if (++slot == node->last)
+        {
+            node = node->next;
+            slot = node->first;
+        }
+        return *this;
+    }
+
+    self operator++(int) noexcept
+    {
+        auto tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    self& operator--() noexcept
+    {
+        if (slot == node->first)
+        {
+            node = node->prev;
+            slot = node->last;
+        }
+        --slot;
+        return *this;
+    }
+
+    self operator--(int) noexcept
+    {
+        auto tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    template<typename R, typename P>
+    bool operator==(const Unrolled_list_iterator<T, R, P, B>& other) const noexcept
+    {
+        return node == other.node && slot == other.slot;
+    }
+
+    template<typename R, typename P>
+    bool operator!=(const Unrolled_list_iterator<T, R, P, B>& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+private:
+    node_base* node;
+    std::size_t slot;
+};
+} // namespace detail
+
+// Doubly linked list of nodes holding up to B elements each, with the
+// interface of List. A traversal reaches a new node only every B elements
+// and reads the elements of a node in a row, so it runs several times
+// faster than over one node per element. Insert and erase shift the
+// elements of one node to make room or close the gap, O(B) at a known
+// position. An insert into a full node splits it in two, an erase leaving
+// a node and a neighbour together within half a node merges them, which
+// keeps the nodes a quarter full at worst on average.
+// Elements move between slots and nodes: insert, erase and splice
+// invalidate the iterators and references to the elements of the nodes
+// they change, the others stay valid. Moving an element must not throw
+// for the exception guarantees of List to hold, and splice, which may
+// split a node, can throw std::bad_alloc.
+template<typename T, std::size_t B = detail::default_unrolled_node_size(sizeof(T)),
+         typename Alloc = cyy::Allocator<T>>
+class Unrolled_list
+{
+    static_assert(std::is_same<typename Alloc::value_type, T>::value,
+                  "Allocator::value_type and T must be the same type.");
+    static_assert(B >= 2, "a node must hold 2 elements at least");
+
+    using Alloc_traits = cyy::Allocator_traits<Alloc>;
+    using node_base = detail::Unrolled_list_node_base;
+    using node_type = detail::Unrolled_list_node<T, B>;
+    using Node_alloc = typename Alloc_traits::template rebind_alloc<node_type>;
+    using Node_alloc_traits = typename Alloc_traits::template rebind_traits<node_type>;
+
+public:
+    using value_type             = T;
+    using allocator_type         = Alloc;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = value_type&;
+    using const_reference        = const value_type&;
+    using pointer                = T*;
+    using const_pointer          = const T*;
+    using iterator               = detail::Unrolled_list_iterator<T, T&, T*, B>;
+    using const_iterator         = detail::Unrolled_list_iterator<T, const T&, const T*, B>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    constexpr static size_type node_capacity = B;
+
+    // construct
+    Unrolled_list()
+        : alloc_(), size_(0)
+    {
+        init();
+    }
+
+    explicit Unrolled_list(const allocator_type& alloc)
+        : alloc_(alloc), size_(0)
+    {
+        init();
+    }
+
+    Unrolled_list(size_type count, const value_type& value, const allocator_type& alloc = Alloc())
+        : Unrolled_list(alloc)
+    {
+        for (; count > 0; --count)
+        {
+            emplace_back(value);
+        }
+    }
+
+    explicit Unrolled_list(size_type count, const allocator_type& alloc = Alloc())
+        : Unrolled_list(alloc)
+    {
+        for (; count > 0; --count)
+        {
+            emplace_back();
+        }
+    }
+
+    template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
+    Unrolled_list(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : Unrolled_list(alloc)
+    {
+        for (; first != last; ++first)
+        {
+            emplace_back(*first);
+        }
+    }
+
+    Unrolled_list(std::initializer_list<value_type> l, const allocator_type& alloc = allocator_type())
+        : Unrolled_list(l.begin(), l.end(), alloc)
+    {
+    }
+
+    Unrolled_list(const Unrolled_list& other)
+        : Unrolled_list(other.begin(), other.end(),
+                        Alloc_traits::select_on_container_copy_construction(other.alloc_))
+    {
+    }
+
+    Unrolled_list(const Unrolled_list& other, const allocator_type& alloc)
+        : Unrolled_list(other.begin(), other.end(), alloc)
+    {
+    }
+
+    Unrolled_list(Unrolled_list&& other) noexcept
+        : alloc_(std::move(other.alloc_)), size_(0)
+    {
+        init();
+        take_nodes(other);
+    }
+
+    Unrolled_list(Unrolled_list&& other, const allocator_type& alloc)
+        : Unrolled_list(alloc)
+    {
+        // the nodes of other can only be taken if alloc can deallocate them
+        if (Alloc_traits::is_always_equal::value || alloc_ == other.alloc_)
+        {
+            take_nodes(other);
+        }
+        else
+        {
+            for (auto& x : other)
+            {
+                emplace_back(std::move(x));
+            }
+        }
+    }
+
+    // destruct
+    ~Unrolled_list()
+    {
+        clear();
+    }
+
+    // assignment
+    Unrolled_list& operator=(const Unrolled_list& rhs)
+    {
+        if (&rhs == this)
+        {
+            return *this;
+        }
+        if constexpr (Alloc_traits::propagate_on_container_copy_assignment::value)
+        {
+            // the old nodes must go back to the allocator they came from
+            if (!Alloc_traits::is_always_equal::value && alloc_ != rhs.alloc_)
+            {
+                clear();
+            }
+            alloc_ = rhs.alloc_;
+        }
+        assign(rhs.begin(), rhs.end());
+        return *this;
+    }
+
+    Unrolled_list& operator=(Unrolled_list&& rhs)
+    {
+        if (&rhs == this)
+        {
+            return *this;
+        }
+        if (Alloc_traits::propagate_on_container_move_assignment::value
+            || Alloc_traits::is_always_equal::value || alloc_ == rhs.alloc_)
+        {
+            clear();
+            if constexpr (Alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                alloc_ = std::move(rhs.alloc_);
+            }
+            take_nodes(rhs);
+        }
+        else
+        {
+            // the nodes of rhs can't be taken, move the elements one by one
+            assign(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+        }
+        return *this;
+    }
+
+    Unrolled_list& operator=(std::initializer_list<value_type> ilist)
+    {
+        assign(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    // replace the contents, assigning over the elements there are
+    void assign(size_type count, const value_type& value)
+    {
+        auto it = begin();
+        for (; it != end() && count > 0; ++it, --count)
+        {
+            *it = value;
+        }
+        if (count == 0)
+        {
+            erase(it, end());
+        }
+        for (; count > 0; --count)
+        {
+            emplace_back(value);
+        }
+    }
+
+    template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
+    void assign(InputIterator first, InputIterator last)
+    {
+        auto it = begin();
+        for (; it != end() && first != last; ++it, ++first)
+        {
+            *it = *first;
+        }
+        if (first == last)
+        {
+            erase(it, end());
+        }
+        for (; first != last; ++first)
+        {
+            emplace_back(*first);
+        }
+    }
+
+    void assign(std::initializer_list<value_type> ilist)
+    {
+        assign(ilist.begin(), ilist.end());
+    }
+
+    // returns the associated allocator
+    allocator_type get_allocator() const noexcept
+    {
+        return alloc_;
+    }
+
+    // access the first element
+    reference front()
+    {
+        return *begin();
+    }
+
+    const_reference front() const
+    {
+        return *begin();
+    }
+
+    // access the last element
+    reference back()
+    {
+        return *--end();
+    }
+
+    const_reference back() const
+    {
+        return *--end();
+    }
+
+    // iterators
+    iterator begin() noexcept
+    {
+        return iterator(head_.next, head_.next->first);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(head_.next, head_.next->first);
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(&head_, 0);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(const_cast<node_base*>(&head_), 0);
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept
+    {
+        return rbegin();
+    }
+
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept
+    {
+        return rend();
+    }
+
+    // capacity
+    bool empty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    size_type size() const noexcept
+    {
+        return size_;
+    }
+
+    size_type max_size() const noexcept
+    {
+        return std::numeric_limits<difference_type>::max() / sizeof(T);
+    }
+
+    // modifiers
+    void clear() noexcept
+    {
+        for (node_base* n = head_.next; n != &head_; )
+        {
+            node_base* next = n->next;
+            destroy_node(n);
+            n = next;
+        }
+        init();
+        size_ = 0;
+    }
+
+    iterator insert(const_iterator pos, const value_type& value)
+    {
+        return emplace(pos, value);
+    }
+
+    iterator insert(const_iterator pos, value_type&& value)
+    {
+        return emplace(pos, std::move(value));
+    }
+
+    // the new elements are built in nodes of their own, then linked in
+    iterator insert(const_iterator pos, size_type count, const value_type& value)
+    {
+        return insert_list(pos, Unrolled_list(count, value, alloc_));
+    }
+
+    template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
+    iterator insert(const_iterator pos, InputIterator first, InputIterator last)
+    {
+        return insert_list(pos, Unrolled_list(first, last, alloc_));
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<value_type> ilist)
+    {
+        return insert(pos, ilist.begin(), ilist.end());
+    }
+
+    // construct an element in-place before pos
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        // a full node is split first, which moves elements the arguments
+        // may refer to: the element is built before
+        if (pos.node != &head_ && pos.node->size() == B)
+        {
+            return emplace_at(pos.node, pos.slot, T(std::forward<Args>(args)...));
+        }
+        return emplace_at(pos.node, pos.slot, std::forward<Args>(args)...);
+    }
+
+    // erase elements
+    iterator erase(const_iterator pos)
+    {
+        return erase_gap(pos.node, pos.slot, pos.slot + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        if (first == last)
+        {
+            return iterator(last.node, last.slot);
+        }
+        if (first.node == last.node)
+        {
+            return erase_gap(first.node, first.slot, last.slot);
+        }
+
+        // the end of the first node, the nodes in between, the start of the last
+        node_base* n1 = first.node;
+        node_base* n2 = last.node;
+        size_ -= n1->last - first.slot;
+        cyy::Destroy(slots(n1) + first.slot, slots(n1) + n1->last, alloc_);
+        n1->last = first.slot;
+        for (node_base* n = n1->next; n != n2; )
+        {
+            node_base* next = n->next;
+            size_ -= n->size();
+            destroy_node(n);
+            n = next;
+        }
+        n1->next = n2;
+        n2->prev = n1;
+        if (n2 != &head_)
+        {
+            size_ -= last.slot - n2->first;
+            cyy::Destroy(slots(n2) + n2->first, slots(n2) + last.slot, alloc_);
+            n2->first = last.slot;
+        }
+        if (n1->size() == 0)
+        {
+            unlink(n1);
+            free_node(n1);
+        }
+        node_base* prev = n2->prev;
+        if (mergeable(prev))
+        {
+            std::size_t k = prev->size();
+            absorb_next(prev);
+            return at(prev, k);
+        }
+        return iterator(n2, n2->first);
+    }
+
+    // add an element to the end
+    void push_back(const value_type& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(value_type&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    // construct an element in-place at the end
+    template<typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        emplace(cend(), std::forward<Args>(args)...);
+    }
+
+    // remove the last element
+    void pop_back()
+    {
+        erase(--cend());
+    }
+
+    // insert an element to the beginning
+    void push_front(const value_type& value)
+    {
+        emplace_front(value);
+    }
+
+    void push_front(value_type&& value)
+    {
+        emplace_front(std::move(value));
+    }
+
+    // construct an element in-place at the beginning
+    template<typename... Args>
+    void emplace_front(Args&&... args)
+    {
+        emplace(cbegin(), std::forward<Args>(args)...);
+    }
+
+    // remove the first element
+    void pop_front()
+    {
+        erase(cbegin());
+    }
+
+    // change the number of elements stored
+    void resize(size_type count)
+    {
+        while (size() > count)
+        {
+            pop_back();
+        }
+        while (size() < count)
+        {
+            emplace_back();
+        }
+    }
+
+    void resize(size_type count, const value_type& value)
+    {
+        while (size() > count)
+        {
+            pop_back();
+        }
+        while (size() < count)
+        {
+            emplace_back(value);
+        }
+    }
+
+    // swap the contents
+    void swap(Unrolled_list& other) noexcept
+    {
+        if constexpr (Alloc_traits::propagate_on_container_swap::value)
+        {
+            using std::swap;
+            swap(alloc_, other.alloc_);
+        }
+        std::swap(head_.next, other.head_.next);
+        std::swap(head_.prev, other.head_.prev);
+        std::swap(size_, other.size_);
+        relink_head(other);
+        other.relink_head(*this);
+    }
+
+    // merge two sorted lists, stable
+    void merge(Unrolled_list& other)
+    {
+        merge(other, std::less<value_type>());
+    }
+
+    void merge(Unrolled_list&& other)
+    {
+        merge(other, std::less<value_type>());
+    }
+
+    template<typename Compare>
+    void merge(Unrolled_list& other, Compare comp)
+    {
+        if (&other == this || other.empty())
+        {
+            return;
+        }
+        size_type n = size();
+        splice(cend(), other);
+        std::inplace_merge(begin(), std::next(begin(), n), end(), comp);
+    }
+
+    template<typename Compare>
+    void merge(Unrolled_list&& other, Compare comp)
+    {
+        merge(other, comp);
+    }
+
+    // Move elements from another list, whose allocator must compare equal.
+    // Whole nodes are relinked, only the nodes holding pos, first and last
+    // are split.
+    void splice(const_iterator pos, Unrolled_list& other)
+    {
+        if (&other != this && !other.empty())
+        {
+            insert_list(pos, std::move(other));
+        }
+    }
+
+    void splice(const_iterator pos, Unrolled_list&& other)
+    {
+        splice(pos, other);
+    }
+
+    void splice(const_iterator pos, Unrolled_list& other, const_iterator it)
+    {
+        splice(pos, other, it, std::next(it));
+    }
+
+    void splice(const_iterator pos, Unrolled_list&& other, const_iterator it)
+    {
+        splice(pos, other, it);
+    }
+
+    void splice(const_iterator pos, Unrolled_list& other, const_iterator first, const_iterator last)
+    {
+        if (first == last)
+        {
+            return;
+        }
+        if (&other != this && first == other.cbegin() && last == other.cend())
+        {
+            splice(pos, other);
+            return;
+        }
+
+        // split the later slot of a node first, so that the earlier stays valid
+        struct cut
+        {
+            node_base* node;
+            std::size_t slot;
+            node_base* begin;
+        };
+        cut cuts[3] = {{pos.node, pos.slot, nullptr}, {first.node, first.slot, nullptr}, {last.node, last.slot, nullptr}};
+        cut* order[3] = {&cuts[0], &cuts[1], &cuts[2]};
+        std::sort(order, order + 3, [] (const cut* a, const cut* b) {
+            return std::less<node_base*>()(a->node, b->node) || (a->node == b->node && a->slot > b->slot);
+        });
+        for (cut* c : order)
+        {
+            c->begin = split_before(c->node, c->slot);
+        }
+        node_base* p = cuts[0].begin;
+        node_base* f = cuts[1].begin;
+        node_base* l = cuts[2].begin;
+        if (p == f || p == l)
+        {
+            return;
+        }
+
+        node_base* chain_last = l->prev;
+        if (&other != this)
+        {
+            size_type count = 0;
+            for (node_base* n = f; n != l; n = n->next)
+            {
+                count += n->size();
+            }
+            other.size_ -= count;
+            size_ += count;
+        }
+        node_base* prev = f->prev;
+        prev->next = l;
+        l->prev = prev;
+        if (other.mergeable(prev))
+        {
+            other.absorb_next(prev);
+        }
+        link_chain(p, f, chain_last);
+    }
+
+    void splice(const_iterator pos, Unrolled_list&& other, const_iterator first, const_iterator last)
+    {
+        splice(pos, other, first, last);
+    }
+
+    // remove elements satisfying specific criteria, in one pass
+    void remove(const T& value)
+    {
+        remove_if([&] (const T& v) {
+            return value == v;
+        });
+    }
+
+    template<typename UnaryPredicate>
+    void remove_if(UnaryPredicate p)
+    {
+        erase(std::remove_if(begin(), end(), p), end());
+    }
+
+    // reverse the order of the elements
+    void reverse()
+    {
+        std::reverse(begin(), end());
+    }
+
+    // remove consecutive duplicate elements
+    void unique()
+    {
+        unique([] (const T& x, const T& y) {
+            return x == y;
+        });
+    }
+
+    template<typename BinaryPredicate>
+    void unique(BinaryPredicate p)
+    {
+        erase(std::unique(begin(), end(), p), end());
+    }
+
+    // Stable sort: the elements are moved to a Vector, sorted there and
+    // moved back in place, the nodes stay as they are.
+    void sort()
+    {
+        sort(std::less<value_type>());
+    }
+
+    template<typename Compare>
+    void sort(Compare comp)
+    {
+        if (size() < 2)
+        {
+            return;
+        }
+        Vector<T> buffer(std::make_move_iterator(begin()), std::make_move_iterator(end()));
+        std::stable_sort(buffer.begin(), buffer.end(), comp);
+        std::move(buffer.begin(), buffer.end(), begin());
+    }
+
+private:
+    static T* slots(node_base* n) noexcept
+    {
+        return static_cast<node_type*>(n)->slots();
+    }
+
+    void init() noexcept
+    {
+        head_.prev = &head_;
+        head_.next = &head_;
+        head_.first = 0;
+        head_.last = 0;
+    }
+
+    // point the first and last nodes back at the head after the links of
+    // the head were swapped with other's
+    void relink_head(Unrolled_list& other) noexcept
+    {
+        if (head_.next == &other.head_)
+        {
+            init();
+        }
+        else
+        {
+            head_.next->prev = &head_;
+            head_.prev->next = &head_;
+        }
+    }
+
+    // this is empty
+    void take_nodes(Unrolled_list& other) noexcept
+    {
+        if (other.empty())
+        {
+            return;
+        }
+        head_.next = other.head_.next;
+        head_.prev = other.head_.prev;
+        head_.next->prev = &head_;
+        head_.prev->next = &head_;
+        size_ = other.size_;
+        other.init();
+        other.size_ = 0;
+    }
+
+    // a new empty node after prev, elements go in from slot on
+    node_base* create_node_after(node_base* prev, std::size_t slot)
+    {
+        Node_alloc alloc(alloc_);
+        node_type* p = Node_alloc_traits::allocate(alloc, 1);
+        // default-initialized, the slots are left as they are
+        node_base* n = ::new (static_cast<void*>(p)) node_type;
+        n->first = slot;
+        n->last = slot;
+        n->prev = prev;
+        n->next = prev->next;
+        prev->next->prev = n;
+        prev->next = n;
+        return n;
+    }
+
+    void free_node(node_base* n) noexcept
+    {
+        Node_alloc alloc(alloc_);
+        Node_alloc_traits::deallocate(alloc, static_cast<node_type*>(n), 1);
+    }
+
+    void destroy_node(node_base* n) noexcept
+    {
+        cyy::Destroy(slots(n) + n->first, slots(n) + n->last, alloc_);
+        free_node(n);
+    }
+
+    static void unlink(node_base* n) noexcept
+    {
+        n->prev->next = n->next;
+        n->next->prev = n->prev;
+    }
+
+    // iterator to the element k from the start of n, or the one after n
+    iterator at(node_base* n, std::size_t k) noexcept
+    {
+        if (k == n->size())
+        {
+            return iterator(n->next, n->next->first);
+        }
+        return iterator(n, n->first + k);
+    }
+
+    // n and the node after it fit together in half a node
+    bool mergeable(const node_base* n) const noexcept
+    {
+        return n != &head_ && n->next != &head_ && n->size() + n->next->size() <= B / 2;
+    }
+
+    // move the elements of the slots first up to last of one node to
+    // free slots of another from slot at on
+    void transfer(node_base* from, std::size_t first, std::size_t last, node_base* to, std::size_t at)
+    {
+        T* src = slots(from);
+        T* dst = slots(to);
+        for (std::size_t i = first; i < last; ++i, ++at)
+        {
+            Alloc_traits::construct(alloc_, dst + at, std::move(src[i]));
+        }
+        cyy::Destroy(src + first, src + last, alloc_);
+    }
+
+    // move the elements of n to the slots from 0 on
+    void shift_to_front(node_base* n)
+    {
+        T* p = slots(n);
+        std::size_t count = n->size();
+        std::size_t first = n->first;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (i < first)
+            {
+                Alloc_traits::construct(alloc_, p + i, std::move(p[first + i]));
+            }
+            else
+            {
+                p[i] = std::move(p[first + i]);
+            }
+        }
+        cyy::Destroy(p + std::max(first, count), p + n->last, alloc_);
+        n->first = 0;
+        n->last = count;
+    }
+
+    // move the elements of the node after n to the end of n, then free it
+    void absorb_next(node_base* n)
+    {
+        node_base* m = n->next;
+        if (B - n->last < m->size())
+        {
+            shift_to_front(n);
+        }
+        transfer(m, m->first, m->last, n, n->last);
+        n->last += m->size();
+        unlink(m);
+        free_node(m);
+    }
+
+    // Make the element at slot of n the first of its node, moving it and
+    // those after it to a new node if it is not, and return that node. The
+    // head stands for the end.
+    node_base* split_before(node_base* n, std::size_t slot)
+    {
+        if (slot == n->first)
+        {
+            return n;
+        }
+        if (slot == n->last)
+        {
+            return n->next;
+        }
+        node_base* m = create_node_after(n, 0);
+        transfer(n, slot, n->last, m, 0);
+        m->last = n->last - slot;
+        n->last = slot;
+        return m;
+    }
+
+    // Construct an element before the one at slot of n and return an
+    // iterator to it.
+    template<typename... Args>
+    iterator emplace_at(node_base* n, std::size_t slot, Args&&... args)
+    {
+        auto [m, k] = make_room(n, slot);
+        try
+        {
+            k = place(m, k, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            // a node created for the element must not stay empty
+            if (m->size() == 0)
+            {
+                unlink(m);
+                free_node(m);
+            }
+            throw;
+        }
+        ++size_;
+        return iterator(m, k);
+    }
+
+    // A node and a slot of it with room for an element inserted before the
+    // element at slot of n. Inserting at either end of the list starts a
+    // new node when there is no free slot on that side, so that push_back
+    // and push_front never shift elements.
+    std::pair<node_base*, std::size_t> make_room(node_base* n, std::size_t slot)
+    {
+        if (n == &head_)
+        {
+            node_base* tail = head_.prev;
+            if (tail != &head_ && tail->last < B)
+            {
+                return {tail, tail->last};
+            }
+            return {create_node_after(tail, 0), 0};
+        }
+        if (slot == n->first && n->first == 0)
+        {
+            node_base* prev = n->prev;
+            if (prev != &head_ && prev->last < B)
+            {
+                return {prev, prev->last};
+            }
+            if (prev == &head_ || n->size() == B)
+            {
+                return {create_node_after(prev, B), B};
+            }
+        }
+        if (n->size() == B)
+        {
+            node_base* m = split_before(n, n->first + B / 2);
+            if (slot > n->last)
+            {
+                return {m, slot - n->last};
+            }
+        }
+        return {n, slot};
+    }
+
+    // Construct an element before the one at slot of n, which has a free
+    // slot, shifting the fewer elements on one side of it, and return the
+    // slot of the new element.
+    template<typename... Args>
+    std::size_t place(node_base* n, std::size_t slot, Args&&... args)
+    {
+        T* p = slots(n);
+        if (n->last < B && (n->first == 0 || slot - n->first >= n->last - slot))
+        {
+            if (slot == n->last)
+            {
+                Alloc_traits::construct(alloc_, p + slot, std::forward<Args>(args)...);
+            }
+            else
+            {
+                T tmp(std::forward<Args>(args)...);
+                Alloc_traits::construct(alloc_, p + n->last, std::move(p[n->last - 1]));
+                std::move_backward(p + slot, p + n->last - 1, p + n->last);
+                p[slot] = std::move(tmp);
+            }
+            ++n->last;
+            return slot;
+        }
+        if (slot == n->first)
+        {
+            Alloc_traits::construct(alloc_, p + slot - 1, std::forward<Args>(args)...);
+        }
+        else
+        {
+            T tmp(std::forward<Args>(args)...);
+            Alloc_traits::construct(alloc_, p + n->first - 1, std::move(p[n->first]));
+            std::move(p + n->first + 1, p + slot, p + n->first);
+            p[slot - 1] = std::move(tmp);
+        }
+        --n->first;
+        return slot - 1;
+    }
+
+    // Erase the slots first up to last of n, closing the gap from the
+    // shorter side, and return an iterator to the element after them.
+    iterator erase_gap(node_base* n, std::size_t first, std::size_t last)
+    {
+        T* p = slots(n);
+        std::size_t count = last - first;
+        std::size_t k;
+        if (first - n->first < n->last - last)
+        {
+            std::move_backward(p + n->first, p + first, p + last);
+            cyy::Destroy(p + n->first, p + n->first + count, alloc_);
+            n->first += count;
+            k = last - n->first;
+        }
+        else
+        {
+            std::move(p + last, p + n->last, p + first);
+            cyy::Destroy(p + n->last - count, p + n->last, alloc_);
+            n->last -= count;
+            k = first - n->first;
+        }
+        size_ -= count;
+
+        if (n->size() == 0)
+        {
+            node_base* next = n->next;
+            unlink(n);
+            free_node(n);
+            return iterator(next, next->first);
+        }
+        if (mergeable(n))
+        {
+            absorb_next(n);
+        }
+        else if (mergeable(n->prev))
+        {
+            k += n->prev->size();
+            n = n->prev;
+            absorb_next(n);
+        }
+        return at(n, k);
+    }
+
+    // Link the nodes first up to last before p, merging small nodes at the
+    // seams, and return an iterator to the first element linked.
+    iterator link_chain(node_base* p, node_base* first, node_base* last)
+    {
+        node_base* prev = p->prev;
+        prev->next = first;
+        first->prev = prev;
+        last->next = p;
+        p->prev = last;
+
+        node_base* n = first;
+        std::size_t k = 0;
+        if (mergeable(prev))
+        {
+            k = prev->size();
+            if (last == first)
+            {
+                last = prev;
+            }
+            n = prev;
+            absorb_next(prev);
+        }
+        if (mergeable(last))
+        {
+            absorb_next(last);
+        }
+        return at(n, k);
+    }
+
+    // move all the nodes of other before pos
+    iterator insert_list(const_iterator pos, Unrolled_list&& other)
+    {
+        if (other.empty())
+        {
+            return iterator(pos.node, pos.slot);
+        }
+        node_base* p = split_before(pos.node, pos.slot);
+        node_base* first = other.head_.next;
+        node_base* last = other.head_.prev;
+        size_ += other.size_;
+        other.init();
+        other.size_ = 0;
+        return link_chain(p, first, last);
+    }
+
+    Alloc alloc_;
+    node_base head_;
+    size_type size_;
+};
+
+template<typename T, std::size_t B, typename Alloc>
+bool operator==(const Unrolled_list<T, B, Alloc>& lhs, const Unrolled_list<T, B, Alloc>& rhs)
+{
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template<typename T, std::size_t B, typename Alloc>
+bool operator!=(const Unrolled_list<T, B, Alloc>& lhs, const Unrolled_list<T, B, Alloc>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename T, std::size_t B, typename Alloc>
+bool operator<(const Unrolled_list<T, B, Alloc>& lhs, const Unrolled_list<T, B, Alloc>& rhs)
+{
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template<typename T, std::size_t B, typename Alloc>
+bool operator>(const Unrolled_list<T, B, Alloc>& lhs, const Unrolled_list<T, B, Alloc>& rhs)
+{
+    return rhs < lhs;
+}
+
+template<typename T, std::size_t B, typename Alloc>
+bool operator<=(const Unrolled_list<T, B, Alloc>& lhs, const Unrolled_list<T, B, Alloc>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template<typename T, std::size_t B, typename Alloc>
+bool operator>=(const Unrolled_list<T, B, Alloc>& lhs, const Unrolled_list<T, B, Alloc>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template<typename T, std::size_t B, typename Alloc>
+void swap(Unrolled_list<T, B, Alloc>& lhs, Unrolled_list<T, B, Alloc>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+namespace pmr
+{
+template<typename T, std::size_t B = cyy::detail::default_unrolled_node_size(sizeof(T))>
+using Unrolled_list = cyy::Unrolled_list<T, B, polymorphic_allocator<T>>;
+} // namespace pmr
+} // namespace cyy
+
+#endif // UNROLLED_LIST_H
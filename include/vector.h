@@ -2,18 +2,239 @@
 #define VECTOR_H
 
 #include <limits>
+#include <cstdio>
+#include <memory>
+#include <cstdlib>
+#include <iterator>
 #include <algorithm>
 #include <type_traits>
 #include "allocator.h"
 #include "uninitialized.h"
 #include "allocator_traits.h"
 #include "construct.h"
+#include "polymorphic_allocator.h"
+#include "type_traits.h"
+
+// Checks done by Vector, chosen at compile time:
+//   0  none, the default
+//   1  bounds and preconditions: operator[], pop_back, the positions given
+//      to insert and erase, emplace_back_unchecked
+//   2  also iterator invalidation: iterators carry the generation of the
+//      Vector, which changes whenever it reallocates, swaps or moves, and
+//      are dereferenced only inside the current elements
+// A failed check calls CYY_VECTOR_CHECK_FAILED(message), which prints the
+// message and aborts unless defined otherwise before including vector.h.
+#ifndef CYY_VECTOR_CHECK_LEVEL
+#define CYY_VECTOR_CHECK_LEVEL 0
+#endif
+
+#ifndef CYY_VECTOR_CHECK_FAILED
+#define CYY_VECTOR_CHECK_FAILED(message) ::cyy::detail::vector_check_failed(message)
+#endif
+
+#define CYY_VECTOR_CHECK(level, condition, message)     \
+    do                                                  \
+    {                                                   \
+        if constexpr (CYY_VECTOR_CHECK_LEVEL >= level)  \
+        {                                               \
+            if (!(condition))                           \
+                CYY_VECTOR_CHECK_FAILED(message);       \
+        }                                               \
+    } while (0)
 
 namespace cyy
 {
+// Defined in execution.h, which also gives cyy::par: only the users of the
+// Parallel_policy overloads pay for the thread pool.
+struct Parallel_policy;
 
 namespace detail
 {
+inline std::size_t chunk_count(const Parallel_policy& policy, std::size_t n) noexcept;
+inline std::size_t chunk_begin(std::size_t i, std::size_t chunks, std::size_t n, std::size_t elem_size,
+                               const void* base) noexcept;
+template<typename Function>
+void run_chunks(std::size_t chunks, std::size_t n, std::size_t elem_size, const void* base, Function f);
+
+[[noreturn]] inline void vector_check_failed(const char* message) noexcept
+{
+    std::fprintf(stderr, "cyy::Vector check failed: %s\n", message);
+    std::abort();
+}
+
+// Iterator of a Vector at check level 2: the pointer, the storage of the
+// Vector and its generation when the iterator was made. Dereferencing
+// checks that the generation is unchanged and the element is in range.
+// Changes in place, like pop_back or an insert within the capacity, keep
+// the generation: an iterator stays usable while it points to an element.
+// Moving or swapping a Vector invalidates its iterators here, which is
+// stricter than the standard.
+template<typename Ptr, typename Data>
+class Vector_checked_iterator
+{
+    template<typename P, typename D>
+    friend class Vector_checked_iterator;
+
+public:
+    using self = Vector_checked_iterator;
+
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename std::iterator_traits<Ptr>::value_type;
+    using pointer = Ptr;
+    using reference = typename std::iterator_traits<Ptr>::reference;
+
+    Vector_checked_iterator() noexcept
+        : ptr(), data(nullptr), generation(0)
+    {
+    }
+
+    Vector_checked_iterator(Ptr ptr, const Data* data) noexcept
+        : ptr(ptr), data(data), generation(data->generation)
+    {
+    }
+
+    // iterator to const_iterator
+    template<typename P, typename = std::enable_if_t<std::is_convertible_v<P, Ptr>>>
+    Vector_checked_iterator(const Vector_checked_iterator<P, Data>& other) noexcept
+        : ptr(other.ptr), data(other.data), generation(other.generation)
+    {
+    }
+
+    reference operator*() const
+    {
+        CYY_VECTOR_CHECK(2, data != nullptr && generation == data->generation, "iterator invalidated");
+        CYY_VECTOR_CHECK(2, data->start <= ptr && ptr < data->finish, "iterator out of range");
+        return *ptr;
+    }
+
+    pointer operator->() const
+    {
+        return std::addressof(**this);
+    }
+
+    reference operator[](difference_type n) const
+    {
+        return *(*this + n);
+    }
+
+    self& operator++() noexcept
+    {
+        ++ptr;
+        return *this;
+    }
+
+    self operator++(int) noexcept
+    {
+        auto tmp = *this;
+        ++ptr;
+        return tmp;
+    }
+
+    self& operator--() noexcept
+    {
+        --ptr;
+        return *this;
+    }
+
+    self operator--(int) noexcept
+    {
+        auto tmp = *this;
+        --ptr;
+        return tmp;
+    }
+
+    self& operator+=(difference_type n) noexcept
+    {
+        ptr += n;
+        return *this;
+    }
+
+    self& operator-=(difference_type n) noexcept
+    {
+        ptr -= n;
+        return *this;
+    }
+
+    friend self operator+(self it, difference_type n) noexcept
+    {
+        return it += n;
+    }
+
+    friend self operator+(difference_type n, self it) noexcept
+    {
+        return it += n;
+    }
+
+    friend self operator-(self it, difference_type n) noexcept
+    {
+        return it -= n;
+    }
+
+    template<typename P>
+    difference_type operator-(const Vector_checked_iterator<P, Data>& other) const
+    {
+        check_same(other);
+        return ptr - other.ptr;
+    }
+
+    template<typename P>
+    bool operator==(const Vector_checked_iterator<P, Data>& other) const
+    {
+        check_same(other);
+        return ptr == other.ptr;
+    }
+
+    template<typename P>
+    bool operator!=(const Vector_checked_iterator<P, Data>& other) const
+    {
+        return !(*this == other);
+    }
+
+    template<typename P>
+    bool operator<(const Vector_checked_iterator<P, Data>& other) const
+    {
+        check_same(other);
+        return ptr < other.ptr;
+    }
+
+    template<typename P>
+    bool operator>(const Vector_checked_iterator<P, Data>& other) const
+    {
+        return other < *this;
+    }
+
+    template<typename P>
+    bool operator<=(const Vector_checked_iterator<P, Data>& other) const
+    {
+        return !(other < *this);
+    }
+
+    template<typename P>
+    bool operator>=(const Vector_checked_iterator<P, Data>& other) const
+    {
+        return !(*this < other);
+    }
+
+    // the pointer, for the Vector the iterator belongs to
+    Ptr base(const Data* owner) const
+    {
+        CYY_VECTOR_CHECK(2, data == owner && generation == owner->generation, "iterator invalidated");
+        return ptr;
+    }
+
+private:
+    template<typename P>
+    void check_same(const Vector_checked_iterator<P, Data>& other) const
+    {
+        CYY_VECTOR_CHECK(2, data == other.data, "iterators of different vectors");
+    }
+
+    Ptr ptr;
+    const Data* data;
+    unsigned long generation;
+};
+
 // Base class for Vector, used for allocating
 template<typename T, typename Alloc>
 class Vector_base
@@ -51,11 +272,25 @@ protected:
             std::swap(start, other.start);
             std::swap(finish, other.finish);
             std::swap(end_of_storage, other.end_of_storage);
+            invalidate_iterators();
+            other.invalidate_iterators();
+        }
+
+        // called wherever the storage changes: the elements move to other
+        // memory, or the Vector takes other storage
+        void invalidate_iterators() noexcept
+        {
+#if CYY_VECTOR_CHECK_LEVEL >= 2
+            ++generation;
+#endif
         }
 
         pointer start;
         pointer finish;
         pointer end_of_storage;
+#if CYY_VECTOR_CHECK_LEVEL >= 2
+        unsigned long generation = 0;
+#endif
     };
 
     Vector_base()
@@ -81,15 +316,24 @@ protected:
     }
 
     Vector_base(Vector_base&& other) noexcept
-        : data_impl()
+        : data_impl(std::move(other.get_alloc_ref()))
     {
         data_impl.swap(other.data_impl);
     }
 
+    // the storage of other can only be taken if alloc can deallocate it,
+    // otherwise storage of the same size is allocated
     Vector_base(Vector_base&& other, const Alloc_type& alloc)
         : data_impl(alloc)
     {
-        data_impl.swap(other.data_impl);
+        if (Alloc_traits::is_always_equal::value || get_alloc_ref() == other.get_alloc_ref())
+        {
+            data_impl.swap(other.data_impl);
+        }
+        else
+        {
+            create_storage(other.data_impl.finish - other.data_impl.start);
+        }
     }
 
     ~Vector_base()
@@ -102,6 +346,15 @@ protected:
         return n != 0 ? Alloc_traits::allocate(static_cast<Alloc_type&>(data_impl), n) : pointer();
     }
 
+    // storage for n elements at least, count tells how many really fit
+    Allocation_result<pointer, std::size_t> allocate_at_least(std::size_t n)
+    {
+        if (n == 0)
+            return {pointer(), 0};
+        auto result = Alloc_traits::allocate_at_least(static_cast<Alloc_type&>(data_impl), n);
+        return {result.ptr, result.count};
+    }
+
     void deallocate(pointer p, std::size_t n)
     {
         if (p)
@@ -120,12 +373,11 @@ protected:
 
     Alloc_type get_allocator() const noexcept
     {
-        return Alloc_type();
+        return get_alloc_ref();
     }
 
     Vector_data data_impl;
 
-private:
     void create_storage(std::size_t count)
     {
         data_impl.start = allocate(count);
@@ -136,12 +388,75 @@ private:
 }; // class Vector_base
 } // namespace detail
 
-template<typename T, typename Alloc = cyy::Allocator<T>>
+// Growth policies of Vector: next_capacity(size, n, elem_size) gives the
+// capacity of a Vector of size elements of elem_size bytes which needs room
+// for n more, never less than size + n. Overflow is checked by Vector.
+
+// capacity doubles, the default
+struct Double_growth
+{
+    static std::size_t next_capacity(std::size_t size, std::size_t n, std::size_t) noexcept
+    {
+        return size + std::max(size, n);
+    }
+};
+
+// capacity grows by half: less slack, and the blocks given back earlier
+// add up to the next request after a few steps, so they can be reused
+struct Half_growth
+{
+    static std::size_t next_capacity(std::size_t size, std::size_t n, std::size_t) noexcept
+    {
+        return size + std::max(size / 2, n);
+    }
+};
+
+// capacity is a power of 2, which size class allocators serve without waste
+struct Power_of_two_growth
+{
+    static std::size_t next_capacity(std::size_t size, std::size_t n, std::size_t) noexcept
+    {
+        std::size_t need = size + n;
+        std::size_t cap = 1;
+        while (cap < need && cap != 0)
+        {
+            cap <<= 1;
+        }
+        return cap != 0 ? cap : need;
+    }
+};
+
+// Growth, with storage of a page or more rounded up to whole pages: large
+// allocations are mapped by pages anyway, the rest of the last one would
+// be lost otherwise
+template<typename Growth = Double_growth, std::size_t PageSize = 4096>
+struct Page_growth
+{
+    static std::size_t next_capacity(std::size_t size, std::size_t n, std::size_t elem_size) noexcept
+    {
+        std::size_t cap = Growth::next_capacity(size, n, elem_size);
+        if (cap > std::size_t(-1) / elem_size)
+        {
+            return cap;
+        }
+        std::size_t bytes = cap * elem_size;
+        if (bytes < PageSize)
+        {
+            return cap;
+        }
+        std::size_t rounded = (bytes + PageSize - 1) / PageSize * PageSize;
+        return rounded >= bytes ? rounded / elem_size : cap;
+    }
+};
+
+template<typename T, typename Alloc = cyy::Allocator<T>, typename Growth = Double_growth>
 class Vector
     : public detail::Vector_base<T, Alloc>
 {
+protected:
     using Base = detail::Vector_base<T, Alloc>;
     using Base::allocate;
+    using Base::allocate_at_least;
     using Base::deallocate;
     using Base::data_impl;
     using Base::get_alloc_ref;
@@ -156,8 +471,13 @@ public:
     using const_reference        = const value_type&;
     using pointer                = typename Alloc_traits::pointer;
     using const_pointer          = typename Alloc_traits::const_pointer;
+#if CYY_VECTOR_CHECK_LEVEL >= 2
+    using iterator               = detail::Vector_checked_iterator<pointer, typename Base::Vector_data>;
+    using const_iterator         = detail::Vector_checked_iterator<const_pointer, typename Base::Vector_data>;
+#else
     using iterator               = typename Alloc_traits::pointer;
     using const_iterator         = typename Alloc_traits::const_pointer;
+#endif
     using reverse_iterator       = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
@@ -184,8 +504,48 @@ public:
         default_initialize(count);
     }
 
+    // The constructors taking a Parallel_policy build the elements by chunks
+    // on several threads. Each thread first touches the pages it fills, so
+    // with a first-touch NUMA policy they land on the node using them.
+    Vector(const Parallel_policy& policy, size_type count, const value_type& value,
+           const allocator_type& alloc = Alloc())
+        : Base(count, alloc)
+    {
+        parallel_initialize(policy, count, [this, &value] (pointer first, size_type, size_type n) {
+            cyy::uninitialized_fill_n_a(first, n, value, get_alloc_ref());
+        });
+    }
+
+    Vector(const Parallel_policy& policy, size_type count, const allocator_type& alloc = Alloc())
+        : Base(count, alloc)
+    {
+        parallel_initialize(policy, count, [this] (pointer first, size_type, size_type n) {
+            cyy::uninitialized_default_n_a(first, n, get_alloc_ref());
+        });
+    }
+
+    // only random access ranges are split, others are copied on this thread
+    template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
+    Vector(const Parallel_policy& policy, InputIterator first, InputIterator last,
+           const allocator_type& alloc = allocator_type())
+        : Base(alloc)
+    {
+        using Iterator_category = typename std::iterator_traits<InputIterator>::iterator_category;
+        if constexpr (std::is_base_of_v<std::random_access_iterator_tag, Iterator_category>)
+        {
+            this->create_storage(last - first);
+            parallel_initialize(policy, last - first, [this, first] (pointer p, size_type offset, size_type n) {
+                cyy::uninitialized_copy_a(first + offset, first + (offset + n), p, get_alloc_ref());
+            });
+        }
+        else
+        {
+            range_initialize(first, last, Iterator_category());
+        }
+    }
+
     Vector(const Vector& other)
-        : Base(other.size(), other.get_allocator())
+        : Base(other.size(), Alloc_traits::select_on_container_copy_construction(other.get_alloc_ref()))
     {
         copy_initialize(other);
     }
@@ -204,7 +564,7 @@ public:
     Vector(Vector&& other, const allocator_type& alloc)
         : Base(std::move(other), alloc)
     {
-        if (alloc != other.get_allocator())
+        if (!other.empty())
         {
             move_initialize(std::move(other));
             other.clear();
@@ -212,14 +572,14 @@ public:
     }
 
     Vector(std::initializer_list<value_type> l, const allocator_type& alloc = allocator_type())
-        : Base(l.size() ,alloc)
+        : Base(alloc)
     {
         range_initialize(l.begin(), l.end(), std::forward_iterator_tag());
     }
 
     template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
     Vector(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
-        : Base(std::distance(first, last), alloc)
+        : Base(alloc)
     {
         using Iterator_category =  typename std::iterator_traits<InputIterator>::iterator_category;
         range_initialize(first, last, Iterator_category());
@@ -234,35 +594,40 @@ public:
     // assignment
     Vector& operator=(const Vector& rhs)
     {
-        // TODO: handle exception and optimize time
-        // size_type size = rhs.size();
-        if (Alloc_traits::propagate_on_container_copy_assignment::value)
+        if (&rhs == this)
         {
+            return *this;
+        }
+        if constexpr (Alloc_traits::propagate_on_container_copy_assignment::value)
+        {
+            // the old storage must go back to the allocator it came from
+            if (!Alloc_traits::is_always_equal::value && get_alloc_ref() != rhs.get_alloc_ref())
+            {
+                release_storage();
+            }
             get_alloc_ref() = rhs.get_alloc_ref();
         }
-
-        // destruct and deallocate *this
-        Vector tmp(rhs);
-        data_impl.swap(tmp.data_impl);
+        assign(rhs.begin(), rhs.end());
         return *this;
     }
 
     Vector& operator=(Vector&& rhs)
     {
-        if (Alloc_traits::propagate_on_container_copy_assignment::value)
+        if (Alloc_traits::propagate_on_container_move_assignment::value
+            || Alloc_traits::is_always_equal::value || get_alloc_ref() == rhs.get_alloc_ref())
         {
-            get_alloc_ref() = std::move(rhs.get_alloc_ref());
+            release_storage();
+            if constexpr (Alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                get_alloc_ref() = std::move(rhs.get_alloc_ref());
+            }
+            data_impl.swap(rhs.data_impl);
         }
-        else if (get_alloc_ref() != rhs.get_alloc_ref())
+        else
         {
-            assign(rhs.begin(), rhs.end());
-            return *this;
+            // the storage of rhs can't be taken, move the elements one by one
+            assign(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
         }
-
-        Vector tmp{allocator_type()};
-        data_impl.swap(tmp.data_impl);
-        data_impl.swap(rhs.data_impl);
-
         return *this;
     }
 
@@ -277,13 +642,13 @@ public:
     {
         if (count > capacity())
         {
-            Vector tmp(count, value);
+            Vector tmp(count, value, get_alloc_ref());
             data_impl.swap(tmp.data_impl);
         }
         else if (count > size())
         {
             std::fill(data_impl.start, data_impl.finish, value);
-            data_impl.finish = cyy::uninitialized_fill_n_a(end(), count-size(), value, get_alloc_ref());
+            data_impl.finish = cyy::uninitialized_fill_n_a(data_impl.finish, count-size(), value, get_alloc_ref());
         }
         else
         {
@@ -303,14 +668,38 @@ public:
         range_assign(ilist.begin(), ilist.end(), std::forward_iterator_tag());
     }
 
+    // replace the contents, built in parallel into new storage
+    void assign(const Parallel_policy& policy, size_type count, const value_type& value)
+    {
+        Vector tmp(policy, count, value, get_alloc_ref());
+        release_storage();
+        data_impl.swap(tmp.data_impl);
+    }
+
+    template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
+    void assign(const Parallel_policy& policy, InputIterator first, InputIterator last)
+    {
+        Vector tmp(policy, first, last, get_alloc_ref());
+        release_storage();
+        data_impl.swap(tmp.data_impl);
+    }
+
+    // returns the associated allocator
+    allocator_type get_allocator() const noexcept
+    {
+        return get_alloc_ref();
+    }
+
     // access specified element
     reference& operator[](size_type index)
     {
+        CYY_VECTOR_CHECK(1, index < size(), "operator[] index out of range");
         return *(data_impl.start + index);
     }
 
     const_reference operator[](size_type index) const
     {
+        CYY_VECTOR_CHECK(1, index < size(), "operator[] index out of range");
         return *(data_impl.start + index);
     }
 
@@ -368,73 +757,73 @@ public:
     // direct access to the underlying array 
     T* data() noexcept
     {
-        return data_ptr(data_impl.first);
+        return data_impl.start;
     }
 
     const T* data() const noexcept
     {
-        return data_ptr(data_impl.first);
+        return data_impl.start;
     }
 
     // get iterators
     iterator begin() noexcept
     {
-        return iterator(data_impl.start);
+        return make_iterator(data_impl.start);
     }
 
     const_iterator begin() const noexcept
     {
-        return const_iterator(data_impl.start);
+        return make_iterator(data_impl.start);
     }
 
     const_iterator cbegin() const noexcept
     {
-        return const_iterator(data_impl.start);
+        return begin();
     }
 
     iterator end() noexcept
     {
-        return iterator(data_impl.finish);
+        return make_iterator(data_impl.finish);
     }
 
     const_iterator end() const noexcept
     {
-        return const_iterator(data_impl.finish);
+        return make_iterator(data_impl.finish);
     }
 
     const_iterator cend() const noexcept
     {
-        return const_iterator(data_impl.finish);
+        return end();
     }
 
     reverse_iterator rbegin() noexcept
     {
-        return reverse_iterator(data_impl.finish-1);
+        return reverse_iterator(end());
     }
 
     const_reverse_iterator rbegin() const noexcept
     {
-        return const_reverse_iterator(data_impl.finish-1);
+        return const_reverse_iterator(end());
     }
 
     const_reverse_iterator crbegin() const noexcept
     {
-        return const_reverse_iterator(data_impl.finish-1);
+        return rbegin();
     }
 
     reverse_iterator rend() noexcept
     {
-        return reverse_iterator(data_impl.start-1);
+        return reverse_iterator(begin());
     }
 
     const_reverse_iterator rend() const noexcept
     {
-        return const_reverse_iterator(data_impl.start-1);
+        return const_reverse_iterator(begin());
     }
 
     const_reverse_iterator crend() const noexcept
     {
-        return const_reverse_iterator(data_impl.start-1);
+        return rend();
     }
 
     // checks whether the container is empty
@@ -470,9 +859,27 @@ public:
         if (new_cap <= capacity())
             return;
 
-        Vector tmp(new_cap);
-        tmp.move_initialize(std::move(*this));
-        data_impl.swap(tmp.data_impl);
+        reallocate_storage(new_cap);
+    }
+
+    // make the capacity new_cap, or size() if larger, growing or shrinking
+    // the storage without any growth slack. The allocator may still round
+    // the block up, that room is counted in capacity().
+    void reserve_exact(size_type new_cap)
+    {
+        if (new_cap > max_size())
+            throw std::length_error("too large");
+
+        new_cap = std::max(new_cap, size());
+        if (new_cap == capacity())
+            return;
+
+        if (new_cap == 0)
+        {
+            release_storage();
+            return;
+        }
+        reallocate_storage(new_cap);
     }
 
     // reduces memory usage by freeing unused memory
@@ -480,9 +887,7 @@ public:
     {
         if (capacity() > 2 * size())
         {
-            Vector tmp(size());
-            tmp.move_initialize(std::move(*this));
-            data_impl.swap(tmp.data_impl);
+            reallocate_storage(size());
         }
     }
 
@@ -508,7 +913,7 @@ public:
     // inserts count copies of the value before pos
     iterator insert(const_iterator pos, size_type count, const value_type& value)
     {
-        size_type dist = pos - data_impl.start;
+        size_type dist = to_pointer(pos) - data_impl.start;
         fill_insert(data_impl.start + dist, count, value);
         return begin() + dist;
     }
@@ -517,7 +922,7 @@ public:
     template<typename InputIterator, typename = std::enable_if_t<!std::is_integral_v<InputIterator>>>
     iterator insert(const_iterator pos, InputIterator first, InputIterator last)
     {
-        size_type dist = pos - data_impl.start;
+        size_type dist = to_pointer(pos) - data_impl.start;
         using Iterator_category = typename std::iterator_traits<InputIterator>::iterator_category;
         range_insert(data_impl.start + dist, first, last, Iterator_category());
         return begin() + dist;
@@ -538,23 +943,59 @@ public:
 
     // constructs an element in-place at the end
     template<typename... Args>
-    void emplace_back(Args&&... args)
+    reference emplace_back(Args&&... args)
+    {
+        return *insert_at_pos(cend(), std::forward<Args>(args)...);
+    }
+
+    // constructs an element in-place at the end, there must be room for it:
+    // size() < capacity(), e.g. after reserve()
+    template<typename... Args>
+    reference emplace_back_unchecked(Args&&... args)
+    {
+        CYY_VECTOR_CHECK(1, data_impl.finish != data_impl.end_of_storage, "emplace_back_unchecked without room");
+        Alloc_traits::construct(get_alloc_ref(), data_impl.finish, std::forward<Args>(args)...);
+        return *data_impl.finish++;
+    }
+
+    // appends the elements of range, which has begin() and end(). Ranges
+    // that can be walked twice are appended with one reallocation at most.
+    template<typename Range>
+    void append_range(Range&& range)
+    {
+        using std::begin;
+        using std::end;
+        insert(cend(), begin(range), end(range));
+    }
+
+    // appends count elements made by gen(), called in order
+    template<typename Generator>
+    void append(size_type count, Generator gen)
     {
-        insert_at_pos(cend(), std::forward<Args>(args)...);
+        if (count > capacity() - size())
+        {
+            reallocate_storage(check_length(count, "Vector::append"));
+        }
+        for (; count > 0; --count)
+        {
+            emplace_back_unchecked(gen());
+        }
     }
 
     // removes the element at pos
     iterator erase(const_iterator pos)
     {
-        pointer p = pos - cbegin() + data_impl.start;
+        pointer p = to_pointer(pos);
+        CYY_VECTOR_CHECK(1, p < data_impl.finish, "erase position out of range");
         return range_erase(p, p+1);
     }
 
     // removes the elements in the range [first, last)
     iterator erase(const_iterator first, iterator last)
     {
-        pointer first_p = first - cbegin() + data_impl.start;
-        pointer last_p  = last - first + first_p;
+        pointer first_p = to_pointer(first);
+        pointer last_p  = to_pointer(last);
+        CYY_VECTOR_CHECK(1, first_p <= last_p && last_p <= data_impl.finish, "erase range out of range");
         return range_erase(first_p, last_p);
     }
 
@@ -583,7 +1024,8 @@ public:
     // removes the last element
     void pop_back()
     {
-        Alloc_traits::destroy(get_alloc_ref(), data_impl.finish--);
+        CYY_VECTOR_CHECK(1, !empty(), "pop_back on empty vector");
+        Alloc_traits::destroy(get_alloc_ref(), --data_impl.finish);
     }
 
     // changes the number of elements stored
@@ -591,19 +1033,32 @@ public:
     {
         if (count > capacity())
         {
-            size_type orignal_size = size();
-            pointer start = allocate_and_copy(count, begin(), end());
-            erase_at_end(data_impl.start);
-            deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
-            data_impl.start = start;
-            data_impl.finish = start + orignal_size;
-            data_impl.end_of_storage = start + count;
-            cyy::uninitialized_default_n_a(data_impl.finish, count - orignal_size, get_alloc_ref());
+            reallocate_storage(count);
         }
-        else if (count > size())
+        if (count > size())
+        {
+            size_type append_size = count - size();
+            data_impl.finish = cyy::uninitialized_default_n_a(data_impl.finish, append_size, get_alloc_ref());
+        }
+        else
+        {
+            erase_at_end(data_impl.start + count);
+        }
+    }
+
+    // resize() leaving new elements default-initialized: trivial ones are not
+    // zeroed, e.g. a buffer filled by read() right after. Only Allocator and
+    // allocators whose construct(p) default-initializes skip the zeroing.
+    void resize_default_init(size_type count)
+    {
+        if (count > capacity())
+        {
+            reallocate_storage(count);
+        }
+        if (count > size())
         {
             size_type append_size = count - size();
-            cyy::uninitialized_default_n_a(data_impl.finish, append_size, get_alloc_ref());
+            data_impl.finish = cyy::uninitialized_default_init_n_a(data_impl.finish, append_size, get_alloc_ref());
         }
         else
         {
@@ -611,23 +1066,31 @@ public:
         }
     }
 
+    // append count default-initialized elements, return the first of them
+    iterator append_uninitialized(size_type count)
+    {
+        size_type orignal_size = size();
+        if (count > capacity() - orignal_size)
+        {
+            reallocate_storage(check_length(count, "Vector::append_uninitialized"));
+        }
+        data_impl.finish = cyy::uninitialized_default_init_n_a(data_impl.finish, count, get_alloc_ref());
+        return begin() + orignal_size;
+    }
+
     void resize(size_type count, const value_type& value)
     {
         if (count > capacity())
         {
-            size_type orignal_size = size();
-            pointer start = allocate_and_copy(count, begin(), end());
-            erase_at_end(data_impl.start);
-            deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
-            data_impl.start = start;
-            data_impl.finish = start + orignal_size;
-            data_impl.end_of_storage = start + count;
-            cyy::uninitialized_fill_n_a(data_impl.finish, count - orignal_size, value, get_alloc_ref());
+            // value may be an element, which the reallocation moves
+            value_type copy(value);
+            reallocate_storage(count);
+            data_impl.finish = cyy::uninitialized_fill_n_a(data_impl.finish, count - size(), copy, get_alloc_ref());
         }
         else if (count > size())
         {
             size_type append_size = count - size();
-            cyy::uninitialized_fill_n_a(data_impl.finish, append_size, value, get_alloc_ref());
+            data_impl.finish = cyy::uninitialized_fill_n_a(data_impl.finish, append_size, value, get_alloc_ref());
         }
         else
         {
@@ -638,12 +1101,42 @@ public:
     // exchange contents
     void swap(Vector& other)
     {
-        if (Alloc_traits::propagate_on_container_swap::value)
+        if constexpr (Alloc_traits::propagate_on_container_swap::value)
             std::swap(get_alloc_ref(), other.get_alloc_ref());
         data_impl.swap(other.data_impl);
     }
 
 private:
+    iterator make_iterator(pointer p) noexcept
+    {
+#if CYY_VECTOR_CHECK_LEVEL >= 2
+        return iterator(p, &data_impl);
+#else
+        return iterator(p);
+#endif
+    }
+
+    const_iterator make_iterator(pointer p) const noexcept
+    {
+#if CYY_VECTOR_CHECK_LEVEL >= 2
+        return const_iterator(p, &data_impl);
+#else
+        return const_iterator(p);
+#endif
+    }
+
+    // the element pos points to, checked to be in [begin(), end()]
+    pointer to_pointer(const_iterator pos) const
+    {
+#if CYY_VECTOR_CHECK_LEVEL >= 2
+        pointer p = data_impl.start + (pos.base(&data_impl) - data_impl.start);
+#else
+        pointer p = data_impl.start + (pos - data_impl.start);
+#endif
+        CYY_VECTOR_CHECK(1, data_impl.start <= p && p <= data_impl.finish, "position out of range");
+        return p;
+    }
+
     void default_initialize(size_type count)
     {
         data_impl.finish = cyy::uninitialized_default_n_a(data_impl.start, count, get_alloc_ref());
@@ -654,29 +1147,62 @@ private:
         data_impl.finish = cyy::uninitialized_fill_n_a(data_impl.start, count, value, get_alloc_ref());
     }
 
+    // Construct count elements at start by chunks on the default Thread_pool,
+    // construct(p, offset, n) builds the n elements from p = start + offset.
+    // If one chunk throws, the ones already built are destroyed. Only used
+    // by callers that include execution.h.
+    template<typename Construct>
+    void parallel_initialize(const Parallel_policy& policy, size_type count, Construct construct)
+    {
+        std::size_t chunks = detail::chunk_count(policy, count);
+        std::unique_ptr<bool[]> done(new bool[chunks]());
+        const void* base = count != 0 ? std::addressof(*data_impl.start) : nullptr;
+        auto chunk_begin = [chunks, count, base] (std::size_t i) {
+            return detail::chunk_begin(i, chunks, count, sizeof(T), base);
+        };
+        try
+        {
+            detail::run_chunks(chunks, count, sizeof(T), base, [&] (std::size_t i, size_type begin, size_type end) {
+                construct(data_impl.start + begin, begin, end - begin);
+                done[i] = true;
+            });
+        }
+        catch (...)
+        {
+            for (std::size_t i = 0; i < chunks; ++i)
+            {
+                if (done[i])
+                {
+                    cyy::Destroy(data_impl.start + chunk_begin(i), data_impl.start + chunk_begin(i + 1), get_alloc_ref());
+                }
+            }
+            throw;
+        }
+        data_impl.finish = data_impl.start + count;
+    }
+
     void copy_initialize(const Vector& other)
     {
-        data_impl.finish = cyy::uninitialized_copy_a(other.begin(), other.end(),
+        data_impl.finish = cyy::uninitialized_copy_a(other.data_impl.start, other.data_impl.finish,
                                                 data_impl.start, get_alloc_ref());
     }
 
     void move_initialize(Vector&& other)
     {
-        data_impl.finish = cyy::uninitialized_move_a(other.begin(), other.end(), data_impl.start, get_alloc_ref());
+        data_impl.finish = cyy::uninitialized_move_a(other.data_impl.start, other.data_impl.finish,
+                                                data_impl.start, get_alloc_ref());
     }
 
     template<typename InputIterator>
     void range_initialize(InputIterator first, InputIterator last, std::input_iterator_tag)
     {
-        for (; first != last;)
-        {
-            emplace_back(*first);
-        }
+        append_input(first, last);
     }
 
     template<typename ForwardIt>
     void range_initialize(ForwardIt first, ForwardIt last, std::forward_iterator_tag)
     {
+        this->create_storage(std::distance(first, last));
         data_impl.finish = cyy::uninitialized_copy_a(first, last, data_impl.start, get_alloc_ref());
     }
 
@@ -700,8 +1226,8 @@ private:
         if (max_size() - size() < n)
             throw std::length_error(s);
 
-        const size_type len = size() + std::max(size(), n);
-        return (len < size() || len > max_size()) ? max_size() : len;
+        const size_type len = Growth::next_capacity(size(), n, sizeof(T));
+        return (len < size() + n || len > max_size()) ? max_size() : len;
     }
 
     // allocate memory and copy elements into it
@@ -758,11 +1284,12 @@ private:
             deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
             data_impl.start = start;
             data_impl.finish = data_impl.end_of_storage = start + n;
+            data_impl.invalidate_iterators();
         }
         else if (n > size())
         {
             ForwardIterator mid = first;
-            std::advance(mid, n);
+            std::advance(mid, size());
             std::copy(first, mid, data_impl.start);
             data_impl.finish = cyy::uninitialized_copy_a(mid, last, data_impl.finish, get_alloc_ref());
         }
@@ -774,32 +1301,107 @@ private:
 
     iterator range_erase(pointer first, pointer last)
     {
-        pointer finish = std::move(last, data_impl.finish, first);
-        erase_at_end(finish);
-        return iterator(first);
+        // an empty range would move every element after it onto itself
+        if (first != last)
+        {
+            erase_at_end(std::move(last, data_impl.finish, first));
+        }
+        return make_iterator(first);
     }
 
     void expand()
     {
-        size_type n = capacity();
-        size_type alloc_n = check_length(1, "Vector::expand");
-        pointer start = allocate(alloc_n);
+        reallocate_storage(check_length(1, "Vector::expand"));
+    }
+
+    // make the storage hold n elements, n >= size(). The block is grown
+    // where it is if the allocator can, and trivially copyable elements are
+    // moved by the allocator's reallocate() if it has one. Otherwise the
+    // elements are moved into new storage, which may hold more than n.
+    void reallocate_storage(size_type n)
+    {
+        data_impl.invalidate_iterators();
+        size_type orignal_size = size();
+        size_type cap = capacity();
+        if (data_impl.start != pointer() && n != 0)
+        {
+            if (n > cap && Alloc_traits::try_expand(get_alloc_ref(), data_impl.start, cap, n))
+            {
+                data_impl.end_of_storage = data_impl.start + n;
+                return;
+            }
+            if constexpr (Alloc_traits::can_reallocate::value && std::is_trivially_copyable<T>::value)
+            {
+                data_impl.start = Alloc_traits::reallocate(get_alloc_ref(), data_impl.start, cap, n);
+                data_impl.finish = data_impl.start + orignal_size;
+                data_impl.end_of_storage = data_impl.start + n;
+                return;
+            }
+        }
+
+        auto result = allocate_at_least(n);
+        pointer start = result.ptr;
 
         try
         {
-            cyy::uninitialized_move_if_noexcept_a(begin(), end(), start, get_alloc_ref());
+            cyy::uninitialized_relocate_a(data_impl.start, data_impl.finish, start, get_alloc_ref());
         }
         catch (...)
         {
-            deallocate(start, alloc_n);
+            deallocate(start, result.count);
             throw;
         }
 
-        cyy::Destroy(data_impl.start, data_impl.finish);
-        deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
+        drop_relocated();
+        data_impl.start = start;
+        data_impl.finish = start + orignal_size;
+        data_impl.end_of_storage = start + result.count;
+    }
+
+    // Relocate the elements into start, of alloc_size elements, around the
+    // count ones already built from start + offset, and take it as the new
+    // storage. If a relocation throws, the new elements are destroyed and
+    // the Vector is unchanged.
+    void relocate_around(pointer start, size_type alloc_size, size_type offset, size_type count)
+    {
+        size_type orignal_size = size();
+        pointer pos = data_impl.start + offset;
+        pointer built = start + offset;
+        try
+        {
+            cyy::uninitialized_relocate_a(data_impl.start, pos, start, get_alloc_ref());
+            built = start;
+            cyy::uninitialized_relocate_a(pos, data_impl.finish, start + offset + count, get_alloc_ref());
+        }
+        catch (...)
+        {
+            // a relocation only throws when it copies, the originals are intact
+            cyy::Destroy(built, start + offset + count, get_alloc_ref());
+            deallocate(start, alloc_size);
+            throw;
+        }
+        drop_relocated();
         data_impl.start = start;
-        data_impl.finish = start+n;
-        data_impl.end_of_storage = start + alloc_n;
+        data_impl.finish = start + orignal_size + count;
+        data_impl.end_of_storage = start + alloc_size;
+        data_impl.invalidate_iterators();
+    }
+
+    // end the elements relocated by uninitialized_relocate_a and give the storage back
+    void drop_relocated() noexcept
+    {
+        cyy::Destroy_relocated(data_impl.start, data_impl.finish, get_alloc_ref());
+        data_impl.finish = data_impl.start;
+        deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
+    }
+
+    // destroy the elements and give the storage back
+    void release_storage() noexcept
+    {
+        erase_at_end(data_impl.start);
+        deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
+        data_impl.start = data_impl.finish = data_impl.end_of_storage = pointer();
+        data_impl.invalidate_iterators();
     }
 
     template<typename... Args>
@@ -808,36 +1410,36 @@ private:
         // equal to size() == capacity()
         if (data_impl.end_of_storage == data_impl.finish)
         {
-            size_type dist = std::distance(cbegin(), pos);
-            size_type orignal_size = size();
+            size_type dist = to_pointer(pos) - data_impl.start;
             size_type alloc_size = check_length(1, "Vector::insert_at_pos");
             pointer start = allocate(alloc_size);
+            // the new element first: args may refer to an element
             try
             {
-                cyy::uninitialized_move_a(data_impl.start, data_impl.start + dist, start, get_alloc_ref());
                 Alloc_traits::construct(get_alloc_ref(), start+dist, std::forward<Args>(args)...);
-                cyy::uninitialized_move_a(data_impl.start+dist, data_impl.finish, start+dist+1, get_alloc_ref());
             }
             catch (...)
             {
                 deallocate(start, alloc_size);
                 throw;
             }
-            erase_at_end(data_impl.start);
-            deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
-            data_impl.start = start;
-            data_impl.finish = start + orignal_size + 1;
-            data_impl.end_of_storage = start + alloc_size;
-            return start + dist;
+            relocate_around(start, alloc_size, dist, 1);
+            return make_iterator(start + dist);
+        }
+        else if (pos == cend())
+        {
+            return make_iterator(&emplace_back_unchecked(std::forward<Args>(args)...));
         }
         else
         {
+            // args may refer to an element which is about to move
+            value_type value(std::forward<Args>(args)...);
+            pointer target = to_pointer(pos);
             Alloc_traits::construct(get_alloc_ref(), data_impl.finish, std::move(*(data_impl.finish-1)));
             ++data_impl.finish;
-            pointer target = data_impl.start + (pos - cbegin());
-            std::move_backward(target, data_impl.finish-1, data_impl.finish);
-            *target = value_type(std::forward<Args>(args)...);
-            return iterator(target);
+            std::move_backward(target, data_impl.finish-2, data_impl.finish-1);
+            *target = std::move(value);
+            return make_iterator(target);
         }
     }
 
@@ -847,44 +1449,37 @@ private:
 
         if (count > data_impl.end_of_storage - data_impl.finish)
         {
-            size_type alloc_size;
-            pointer cur, start;
-
-            alloc_size = check_length(count, "Vector::fill_insert");
-
-            start = allocate(alloc_size);
+            size_type offset = pos - data_impl.start;
+            size_type alloc_size = check_length(count, "Vector::fill_insert");
+            pointer start = allocate(alloc_size);
+            // the new elements first: value may be an element
             try
             {
-                cur = cyy::uninitialized_move_a(data_impl.start, pos, start, get_alloc_ref());
-                cur = cyy::uninitialized_fill_n_a(cur, count, value, get_alloc_ref());
-                cyy::uninitialized_move_a(pos, data_impl.finish, cur, get_alloc_ref());
+                cyy::uninitialized_fill_n_a(start + offset, count, value, get_alloc_ref());
             }
             catch (...)
             {
                 deallocate(start, alloc_size);
                 throw;
             }
-
-            erase_at_end(data_impl.start);
-            deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
-            data_impl.start = start;
-            data_impl.finish = cur;
-            data_impl.end_of_storage = cur;
+            relocate_around(start, alloc_size, offset, count);
         }
-        else
+        else if (count != 0)
         {
+            // value may be an element which is about to move
+            value_type copy(value);
             if (insert_end > data_impl.finish)
             {
                 cyy::uninitialized_move_a(pos, data_impl.finish, insert_end, get_alloc_ref());
-                std::fill_n(pos, data_impl.finish - pos, value);
-                cyy::uninitialized_fill_a(data_impl.finish, insert_end, value, get_alloc_ref());
+                std::fill_n(pos, data_impl.finish - pos, copy);
+                cyy::uninitialized_fill_a(data_impl.finish, insert_end, copy, get_alloc_ref());
             }
             else
             {
                 cyy::uninitialized_move_a(data_impl.finish-count, data_impl.finish,
                                           data_impl.finish, get_alloc_ref());
-                std::move(pos, data_impl.finish - count, insert_end);
-                std::fill_n(pos, count, value);
+                std::move_backward(pos, data_impl.finish - count, data_impl.finish);
+                std::fill_n(pos, count, copy);
             }
             data_impl.finish = data_impl.finish + count;
         }
@@ -893,10 +1488,37 @@ private:
     template<typename InputIterator>
     void range_insert(pointer pos, InputIterator first, InputIterator last, std::input_iterator_tag)
     {
-        for (; first != last; ++first)
+        // the length is not known: append, then rotate the new elements in place
+        size_type offset = pos - data_impl.start;
+        size_type orignal_size = size();
+        try
+        {
+            append_input(first, last);
+        }
+        catch (...)
+        {
+            erase_at_end(data_impl.start + orignal_size);
+            throw;
+        }
+        std::rotate(data_impl.start + offset, data_impl.start + orignal_size, data_impl.finish);
+    }
+
+    // Append an input range: its elements are built in the free block at the
+    // end, which grows as Vector does once full. Inside a block nothing but
+    // the end of the block is checked.
+    template<typename InputIterator>
+    void append_input(InputIterator first, InputIterator last)
+    {
+        while (first != last)
         {
-            insert_at_pos(pos, *first);
-            pos += 2;
+            if (data_impl.finish == data_impl.end_of_storage)
+            {
+                expand();
+            }
+            for (pointer block_end = data_impl.end_of_storage; first != last && data_impl.finish != block_end; ++first)
+            {
+                emplace_back_unchecked(*first);
+            }
         }
     }
 
@@ -908,25 +1530,20 @@ private:
         // need to reallocate
         if (count > data_impl.end_of_storage - data_impl.finish)
         {
-            pointer start, cur;
+            size_type offset = pos - data_impl.start;
             size_type alloc_size = check_length(count, "Vector::range_insert");
-            start = allocate(alloc_size);
+            pointer start = allocate(alloc_size);
+            // the new elements first: the range may be in this Vector
             try
             {
-                cur = cyy::uninitialized_move_a(data_impl.start, pos, start, get_alloc_ref());
-                cur = cyy::uninitialized_copy_a(first, last, cur, get_alloc_ref());
-                cur = cyy::uninitialized_move_a(pos, data_impl.finish, cur, get_alloc_ref());
+                cyy::uninitialized_copy_a(first, last, start + offset, get_alloc_ref());
             }
             catch (...)
             {
                 deallocate(start, alloc_size);
+                throw;
             }
-
-            erase_at_end(data_impl.start);
-            deallocate(data_impl.start, data_impl.end_of_storage - data_impl.start);
-            data_impl.start = start;
-            data_impl.finish = cur;
-            data_impl.end_of_storage = cur;
+            relocate_around(start, alloc_size, offset, count);
         }
         else
         {
@@ -941,7 +1558,7 @@ private:
             else
             {
                 cyy::uninitialized_move_a(data_impl.finish-count, data_impl.finish, data_impl.finish, get_alloc_ref());
-                std::move(pos, data_impl.finish-count, insert_end);
+                std::move_backward(pos, data_impl.finish - count, data_impl.finish);
                 std::copy(first, last, pos);
             }
             data_impl.finish = data_impl.finish + count;
@@ -949,55 +1566,68 @@ private:
     }
 }; // class Vector
 
+// a Vector is three pointers and its allocator
+template<typename T, typename Alloc, typename Growth>
+struct is_trivially_relocatable<Vector<T, Alloc, Growth>>
+    : is_trivially_relocatable<Alloc>
+{
+};
+
 // lexicographically compares the values in the vector 
 /// return true if all elements are equal, false otherwise
-template<typename T, typename Allocator>
-inline bool operator==(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs)
+template<typename T, typename Allocator, typename Growth>
+inline bool operator==(const Vector<T, Allocator, Growth>& lhs, const Vector<T, Allocator, Growth>& rhs)
 {
     return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
 /// base on operator==
-template<typename T, typename Allocator>
-inline bool operator!=(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs)
+template<typename T, typename Allocator, typename Growth>
+inline bool operator!=(const Vector<T, Allocator, Growth>& lhs, const Vector<T, Allocator, Growth>& rhs)
 {
     return !(lhs == rhs);
 }
 
 /// return true if all eleemnts of the lhs are lexicographically less than those of rhs, false otherwise
-template<typename T, typename Allocator>
-inline bool operator<(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs)
+template<typename T, typename Allocator, typename Growth>
+inline bool operator<(const Vector<T, Allocator, Growth>& lhs, const Vector<T, Allocator, Growth>& rhs)
 {
     return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
 }
 
 /// base on operator<
-template<typename T, typename Allocator>
-inline bool operator>(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs)
+template<typename T, typename Allocator, typename Growth>
+inline bool operator>(const Vector<T, Allocator, Growth>& lhs, const Vector<T, Allocator, Growth>& rhs)
 {
     return rhs < lhs;
 }
 
 /// base on operator<
-template<typename T, typename Allocator>
-inline bool operator<=(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs)
+template<typename T, typename Allocator, typename Growth>
+inline bool operator<=(const Vector<T, Allocator, Growth>& lhs, const Vector<T, Allocator, Growth>& rhs)
 {
     return !(rhs < lhs);
 }
 
 /// base on operator<
-template<typename T, typename Allocator>
-inline bool operator>=(const Vector<T, Allocator>& lhs, const Vector<T, Allocator>& rhs)
+template<typename T, typename Allocator, typename Growth>
+inline bool operator>=(const Vector<T, Allocator, Growth>& lhs, const Vector<T, Allocator, Growth>& rhs)
 {
     return !(lhs < rhs);
 }
 
 // swap Vector
-template<typename T, typename Allocator>
-inline void swap(Vector<T, Allocator>& x, Vector<T, Allocator>& y)
+template<typename T, typename Allocator, typename Growth>
+inline void swap(Vector<T, Allocator, Growth>& x, Vector<T, Allocator, Growth>& y)
 {
     x.swap(y);
 }
 
+namespace pmr
+{
+template<typename T>
+using Vector = cyy::Vector<T, polymorphic_allocator<T>>;
+} // namespace pmr
+
 } // namespace cyy
 #endif // !VECTOR_H
@@ -0,0 +1,209 @@
+#include "SGI_alloc.h"
+#include "thread.h"
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cassert>
+
+int main()
+{
+    std::cout << "Test for single_client_alloc:\n";
+    {
+        using Alloc = cyy::single_client_alloc;
+        void* p1 = Alloc::allocate(24);
+        void* p2 = Alloc::allocate(24);
+        assert(p1 != p2);
+        Alloc::deallocate(p1, 24);
+        // the block just freed is reused first
+        void* p3 = Alloc::allocate(20);
+        std::cout << (p3 == p1) << '\n';
+        Alloc::deallocate(p2, 24);
+        Alloc::deallocate(p3, 20);
+
+        // larger than 128 bytes goes to malloc_alloc
+        void* big = Alloc::allocate(1000);
+        big = Alloc::reallocate(big, 1000, 2000);
+        Alloc::deallocate(big, 2000);
+    }
+
+    std::cout << "\nTest for simple_alloc:\n";
+    {
+        using Int_alloc = cyy::simple_alloc<int, cyy::single_client_alloc>;
+        int* p = Int_alloc::allocate(4);
+        for (int i = 0; i < 4; ++i)
+            p[i] = i * i;
+        std::cout << p[0] << ' ' << p[1] << ' ' << p[2] << ' ' << p[3] << '\n';
+        Int_alloc::deallocate(p, 4);
+    }
+
+    std::cout << "\nTest for alloc in threads:\n";
+    {
+        using Alloc = cyy::alloc;
+        constexpr int nthreads = 8;
+        constexpr int nblocks = 10000;
+
+        // every thread frees the blocks allocated by the next one, so that
+        // blocks travel between the threads through the depot
+        std::vector<std::vector<void*>> blocks(nthreads);
+        for (int i = 0; i < nthreads; ++i)
+        {
+            for (int j = 0; j < nblocks; ++j)
+            {
+                std::size_t n = 8 + (j % 16) * 8;
+                void* p = Alloc::allocate(n);
+                *static_cast<int*>(p) = i;
+                blocks[i].push_back(p);
+            }
+        }
+
+        std::vector<cyy::Thread> workers;
+        for (int i = 0; i < nthreads; ++i)
+        {
+            workers.emplace_back([&blocks, i] () {
+                auto& own = blocks[(i + 1) % nthreads];
+                for (int j = 0; j < nblocks; ++j)
+                {
+                    std::size_t n = 8 + (j % 16) * 8;
+                    assert(*static_cast<int*>(own[j]) == (i + 1) % nthreads);
+                    Alloc::deallocate(own[j], n);
+                }
+                // churn on the blocks of this thread
+                for (int round = 0; round < 100; ++round)
+                {
+                    void* local[64];
+                    for (int j = 0; j < 64; ++j)
+                    {
+                        local[j] = Alloc::allocate(32);
+                        *static_cast<int*>(local[j]) = j;
+                    }
+                    for (int j = 0; j < 64; ++j)
+                    {
+                        assert(*static_cast<int*>(local[j]) == j);
+                        Alloc::deallocate(local[j], 32);
+                    }
+                }
+            });
+        }
+        for (auto& t : workers)
+        {
+            t.join();
+        }
+
+        // blocks given back by the exited threads can be used again
+        void* p = Alloc::allocate(32);
+        Alloc::deallocate(p, 32);
+        std::cout << "done\n";
+    }
+
+    std::cout << "\nTest for size classes:\n";
+    {
+        using Geometric = cyy::__geometric_size_class<>;
+        std::cout << Geometric::nclasses << " classes up to " << Geometric::max_bytes << '\n';
+        for (std::size_t i = 0; i < 16; ++i)
+        {
+            std::cout << Geometric::size(i) << ' ';
+        }
+        std::cout << '\n';
+
+        using Alloc = cyy::__default_alloc_template<false, 2, Geometric>;
+        // nodes with big payloads are pooled too
+        std::cout << Alloc::block_size(200) << ' ' << Alloc::block_size(1000) << ' '
+                  << Alloc::block_size(4000) << ' ' << Alloc::block_size(5000) << '\n';
+        std::vector<void*> blocks;
+        for (int i = 0; i < 1000; ++i)
+        {
+            std::size_t n = 8 + (i * 37) % 4000;
+            void* p = Alloc::allocate(n);
+            std::memset(p, 0xab, Alloc::block_size(n));
+            blocks.push_back(p);
+        }
+        for (int i = 0; i < 1000; ++i)
+        {
+            Alloc::deallocate(blocks[i], 8 + (i * 37) % 4000);
+        }
+
+        using Table = cyy::__size_class_table<16, 16, 32, 48, 96, 256>;
+        using Table_alloc = cyy::__default_alloc_template<false, 2, Table>;
+        std::cout << Table_alloc::block_size(1) << ' ' << Table_alloc::block_size(49) << ' '
+                  << Table_alloc::block_size(100) << ' ' << Table_alloc::block_size(300) << '\n';
+        void* p = Table_alloc::allocate(100);
+        Table_alloc::deallocate(p, 100);
+
+        // internal fragmentation for every request size from 1 to 4096 bytes
+        using Fine = cyy::__uniform_size_class<8, 4096>;
+        using Coarse = cyy::__uniform_size_class<64, 4096>;
+        double waste[3] = {0, 0, 0};
+        for (std::size_t n = 1; n <= 4096; ++n)
+        {
+            waste[0] += double(Fine::size(Fine::index(n)) - n) / n;
+            waste[1] += double(Coarse::size(Coarse::index(n)) - n) / n;
+            waste[2] += double(Geometric::size(Geometric::index(n)) - n) / n;
+        }
+        std::cout << "average waste: uniform<8> " << waste[0] / 4096 * 100 << "% in " << Fine::nclasses
+                  << " lists, uniform<64> " << waste[1] / 4096 * 100 << "% in " << Coarse::nclasses
+                  << " lists, geometric " << waste[2] / 4096 * 100 << "% in " << Geometric::nclasses << " lists\n";
+    }
+
+    std::cout << "\nTest for trim():\n";
+    {
+        using Alloc = cyy::__default_alloc_template<false, 1>;
+        std::vector<void*> blocks;
+        for (int i = 0; i < 100000; ++i)
+        {
+            blocks.push_back(Alloc::allocate(48));
+        }
+        void* kept = Alloc::allocate(16);
+        // nothing can be released while the blocks are in use
+        std::cout << (Alloc::trim() == 0) << '\n';
+        for (void* p : blocks)
+        {
+            Alloc::deallocate(p, 48);
+        }
+        std::size_t released = Alloc::trim();
+        std::cout << (released >= 100000 * 48) << '\n';
+        // the chunk holding kept is still there
+        std::cout << (Alloc::trim() == 0) << '\n';
+        Alloc::deallocate(kept, 16);
+
+        // the pool still works after trim
+        for (int i = 0; i < 1000; ++i)
+        {
+            blocks[i] = Alloc::allocate(48);
+        }
+        for (int i = 0; i < 1000; ++i)
+        {
+            Alloc::deallocate(blocks[i], 48);
+        }
+    }
+
+    std::cout << "\nTest for trim() in threads:\n";
+    {
+        using Alloc = cyy::__default_alloc_template<true, 1>;
+        constexpr int nthreads = 4;
+        std::vector<cyy::Thread> workers;
+        for (int i = 0; i < nthreads; ++i)
+        {
+            workers.emplace_back([] () {
+                std::vector<void*> blocks;
+                for (int j = 0; j < 50000; ++j)
+                {
+                    blocks.push_back(Alloc::allocate(64));
+                }
+                for (void* p : blocks)
+                {
+                    Alloc::deallocate(p, 64);
+                }
+            });
+        }
+        for (auto& t : workers)
+        {
+            t.join();
+        }
+        // the exited threads left all their blocks in the depot, so every
+        // chunk goes at once
+        std::size_t released = Alloc::trim();
+        std::cout << (released >= 50000 * 64) << '\n';
+        std::cout << (Alloc::trim() == 0) << '\n';
+    }
+}
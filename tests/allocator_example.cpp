@@ -1,7 +1,14 @@
 #include <memory>
 #include <string>
 #include <iostream>
+#include <cstdint>
 #include "allocator.h"
+#include "vector.h"
+
+struct alignas(64) Cache_line
+{
+    int value;
+};
  
 int main()
 {
@@ -30,4 +37,28 @@ int main()
     a2.destroy(s);
     a2.destroy(s + 1);
     a2.deallocate(s, 2);
+
+    // 超对齐类型使用对齐的 operator new
+    cyy::Allocator<Cache_line> a3;
+    Cache_line* c = a3.allocate(3);
+    std::cout << (reinterpret_cast<std::uintptr_t>(c) % 64 == 0) << '\n';
+    a3.deallocate(c, 3);
+
+    cyy::Vector<Cache_line> v;
+    for (int i = 0; i < 10; ++i)
+        v.push_back(Cache_line{i});
+    std::cout << (reinterpret_cast<std::uintptr_t>(&v[0]) % 64 == 0) << ' ' << v[9].value << '\n';
+
+    // 对齐到 AVX-512 宽度的 float 缓冲区
+    using Float_alloc = cyy::Aligned_allocator<float, 64>;
+    std::cout << Float_alloc::alignment << ' '
+              << cyy::Aligned_allocator<Cache_line, 16>::alignment << '\n';
+    cyy::Vector<float, Float_alloc> f;
+    bool aligned = true;
+    for (int i = 0; i < 1000; ++i)
+    {
+        f.push_back(i);
+        aligned = aligned && reinterpret_cast<std::uintptr_t>(&f[0]) % 64 == 0;
+    }
+    std::cout << aligned << ' ' << f[999] << '\n';
 }
@@ -0,0 +1,179 @@
+#include "arena.h"
+#include "list.h"
+#include "forward_list.h"
+#include "vector.h"
+#include "allocator_traits.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+
+struct Counted
+{
+    static int alive;
+
+    Counted(int v) : value(v) { ++alive; }
+    Counted(const Counted& other) : value(other.value) { ++alive; }
+    ~Counted() { --alive; }
+
+    int value;
+};
+
+int Counted::alive = 0;
+
+int main()
+{
+    std::cout << "Test for Arena:\n";
+    {
+        cyy::Arena arena(1024);
+        void* p1 = arena.allocate(100, 8);
+        void* p2 = arena.allocate(1, 64);
+        assert(reinterpret_cast<std::uintptr_t>(p2) % 64 == 0);
+        assert(p1 != p2);
+        // bigger than a block
+        void* big = arena.allocate(10000);
+        assert(big != nullptr);
+        std::size_t cap = arena.capacity();
+        std::cout << (cap >= 10000) << '\n';
+
+        // the largest block is kept
+        arena.reset();
+        std::cout << (arena.capacity() < cap) << ' ' << (arena.capacity() >= 10000) << '\n';
+        arena.release();
+        std::cout << arena.capacity() << '\n';
+
+        // aligning the free memory steps past the end of the block
+        cyy::Arena small(4112);
+        small.allocate(4096 - 8, 1);
+        std::size_t before = small.capacity();
+        char* q = static_cast<char*>(small.allocate(32, 64));
+        std::memset(q, 0, 32);
+        std::cout << (reinterpret_cast<std::uintptr_t>(q) % 64) << ' ' << (small.capacity() > before) << '\n';
+    }
+
+    std::cout << "\nTest for Arena_allocator traits:\n";
+    {
+        using Traits = cyy::Allocator_traits<cyy::Arena_allocator<int>>;
+        std::cout << Traits::is_deallocate_noop::value << ' '
+                  << Traits::is_always_equal::value << ' '
+                  << cyy::Allocator_traits<cyy::Allocator<int>>::is_deallocate_noop::value << '\n';
+
+        cyy::Arena a1, a2;
+        cyy::Arena_allocator<int> x(a1);
+        cyy::Arena_allocator<double> y(x);
+        cyy::Arena_allocator<int> z(a2);
+        std::cout << (x == y) << ' ' << (x == z) << '\n';
+    }
+
+    std::cout << "\nTest for List with Arena_allocator:\n";
+    {
+        cyy::Arena arena;
+        cyy::Arena_allocator<int> alloc(arena);
+        cyy::List<int, cyy::Arena_allocator<int>> l(alloc);
+        for (int i = 0; i < 10; ++i)
+        {
+            l.push_back(i);
+        }
+        l.pop_front();
+        for (auto i : l)
+            std::cout << i << ' ';
+        std::cout << '\n';
+        // the nodes are dropped, not freed one by one
+        l.clear();
+        std::cout << l.size() << ' ' << l.empty() << '\n';
+        l.push_back(42);
+        std::cout << l.front() << '\n';
+
+        cyy::List<int, cyy::Arena_allocator<int>> m(alloc);
+        m = std::move(l);
+        std::cout << m.size() << ' ' << l.size() << '\n';
+        m.swap(l);
+        std::cout << m.size() << ' ' << l.size() << '\n';
+
+        // elements with a destructor are still destroyed
+        cyy::Arena_allocator<Counted> calloc(arena);
+        {
+            cyy::List<Counted, cyy::Arena_allocator<Counted>> cl(calloc);
+            for (int i = 0; i < 5; ++i)
+            {
+                cl.push_back(Counted(i));
+            }
+            std::cout << Counted::alive << '\n';
+        }
+        std::cout << Counted::alive << '\n';
+    }
+
+    std::cout << "\nTest for Forward_list with Arena_allocator:\n";
+    {
+        cyy::Arena arena;
+        cyy::Arena_allocator<std::string> alloc(arena);
+        cyy::Forward_list<std::string, cyy::Arena_allocator<std::string>> fl(alloc);
+        fl.push_front("world");
+        fl.push_front("hello");
+        for (auto& s : fl)
+            std::cout << s << ' ';
+        std::cout << '\n';
+        fl.clear();
+        std::cout << fl.empty() << '\n';
+
+        cyy::Arena_allocator<int> ialloc(arena);
+        cyy::Forward_list<int, cyy::Arena_allocator<int>> il(ialloc);
+        for (int i = 0; i < 5; ++i)
+            il.push_front(i);
+        il.clear();
+        std::cout << il.empty() << '\n';
+    }
+
+    std::cout << "\nTest for Vector with Arena_allocator:\n";
+    {
+        cyy::Arena arena;
+        cyy::Arena_allocator<int> alloc(arena);
+        cyy::Vector<int, cyy::Arena_allocator<int>> v(alloc);
+        for (int i = 0; i < 100; ++i)
+        {
+            v.push_back(i);
+        }
+        v.reserve(1000);
+        std::cout << v.size() << ' ' << v.capacity() << ' ' << v[99] << '\n';
+        v.shrink_to_fit();
+        std::cout << v.size() << ' ' << v.capacity() << '\n';
+
+        auto copy = v;
+        std::cout << (copy.get_allocator() == alloc) << ' ' << (copy == v) << '\n';
+
+        cyy::Arena other;
+        cyy::Vector<int, cyy::Arena_allocator<int>> w(std::move(v), cyy::Arena_allocator<int>(other));
+        std::cout << w.size() << ' ' << v.size() << ' ' << w[50] << '\n';
+        v = std::move(w);
+        std::cout << v.size() << ' ' << (v.get_allocator().arena() == &other) << '\n';
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr int n = 1000000;
+        auto t0 = std::chrono::steady_clock::now();
+        {
+            cyy::List<int> l;
+            for (int i = 0; i < n; ++i)
+                l.push_back(i);
+            l.clear();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        {
+            cyy::Arena arena;
+            cyy::List<int, cyy::Arena_allocator<int>> l{cyy::Arena_allocator<int>(arena)};
+            for (int i = 0; i < n; ++i)
+                l.push_back(i);
+            l.clear();
+            arena.reset();
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        using ms = std::chrono::duration<double, std::milli>;
+        std::cerr << "List<int>: " << ms(t1 - t0).count() << "ms with Allocator, "
+                  << ms(t2 - t1).count() << "ms with Arena_allocator\n";
+        std::cout << "done\n";
+    }
+}
@@ -0,0 +1,110 @@
+#include "default_init_allocator.h"
+#include "vector.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cassert>
+
+// stands in for read(): fills n bytes of buf
+std::size_t fake_read(char* buf, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        buf[i] = 'a' + i % 26;
+    }
+    return n;
+}
+
+template<typename Function>
+double time_ms(Function f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main()
+{
+    std::cout << "Test for resize_default_init:\n";
+    {
+        cyy::Vector<char> buf;
+        buf.resize_default_init(10);
+        std::size_t got = fake_read(buf.data(), buf.size());
+        std::cout << buf.size() << ' ' << got << ' ' << std::string(buf.begin(), buf.end()) << '\n';
+        buf.resize_default_init(3);
+        std::cout << std::string(buf.begin(), buf.end()) << '\n';
+
+        // class types are still constructed
+        cyy::Vector<std::string> strings{"a"};
+        strings.resize_default_init(3);
+        std::cout << strings.size() << ' ' << strings[0] << ' ' << strings[2].empty() << '\n';
+    }
+
+    std::cout << "\nTest for append_uninitialized:\n";
+    {
+        cyy::Vector<char> buf;
+        const char* chunks[] = {"hello ", "small ", "world"};
+        for (auto chunk : chunks)
+        {
+            std::size_t n = std::strlen(chunk);
+            auto out = buf.append_uninitialized(n);
+            std::memcpy(&*out, chunk, n);
+        }
+        std::cout << buf.size() << ' ' << std::string(buf.begin(), buf.end()) << '\n';
+
+        cyy::Vector<float> samples(2, 1.0f);
+        auto p = samples.append_uninitialized(1000);
+        assert(p == samples.begin() + 2);
+        for (int i = 0; i < 1000; ++i)
+        {
+            p[i] = i;
+        }
+        std::cout << samples.size() << ' ' << samples[1] << ' ' << samples[1001] << '\n';
+    }
+
+    std::cout << "\nTest for Default_init_allocator:\n";
+    {
+        using Alloc = cyy::Default_init_allocator<cyy::Allocator<int>>;
+        cyy::Vector<int, Alloc> v(5, 7);
+        v.resize(100);
+        std::fill(v.begin() + 5, v.end(), 1);
+        std::cout << v.size() << ' ' << v[4] << ' ' << v[99] << '\n';
+
+        cyy::Vector<int, Alloc> w(v);
+        w.push_back(8);
+        std::cout << w.size() << ' ' << w[0] << ' ' << w.back() << ' ' << (v.get_allocator() == w.get_allocator()) << '\n';
+
+        using String_alloc = cyy::Default_init_allocator<cyy::Allocator<std::string>>;
+        cyy::Vector<std::string, String_alloc> s;
+        s.resize(2);
+        s.push_back("x");
+        std::cout << s.size() << ' ' << s[0].empty() << ' ' << s[2] << '\n';
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr std::size_t n = 64 * 1024 * 1024;
+        std::size_t total = 0;
+        double zeroed = time_ms([&total] {
+            for (int i = 0; i < 4; ++i)
+            {
+                cyy::Vector<char> buf;
+                buf.resize(n);
+                total += fake_read(buf.data(), 4096);
+            }
+        });
+        double raw = time_ms([&total] {
+            for (int i = 0; i < 4; ++i)
+            {
+                cyy::Vector<char> buf;
+                buf.resize_default_init(n);
+                total += fake_read(buf.data(), 4096);
+            }
+        });
+        std::cerr << "4 buffers of 64 MB: resize " << zeroed << "ms, resize_default_init " << raw << "ms\n";
+        std::cout << total << '\n';
+    }
+}
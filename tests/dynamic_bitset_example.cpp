@@ -0,0 +1,130 @@
+#include "dynamic_bitset.h"
+#include "vector.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <stdexcept>
+
+template<typename Function>
+double time_ms(Function f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main()
+{
+    using Bits = cyy::Dynamic_bitset<>;
+    std::cout << "Test for ctors:\n";
+    {
+        Bits b1;
+        Bits b2(10);
+        Bits b3(70, true);
+        Bits b4(std::string("110010"));
+        Bits b5(std::string("aBaaBBaB"), 'a', 'B');
+        std::cout << b1.size() << ' ' << b2 << '\n' << b3 << '\n' << b4 << ' ' << b5 << '\n';
+        std::cout << b3.num_words() << ' ' << b3.count() << ' ' << b3.all() << '\n';
+        try
+        {
+            Bits bad(std::string("10x"));
+        }
+        catch (std::invalid_argument& e)
+        {
+            std::cout << e.what() << '\n';
+        }
+    }
+
+    std::cout << "\nTest for operator[]:\n";
+    {
+        Bits b(std::string("101010"));
+        b[0] = true;
+        b[2].flip();
+        b[5] = b[1];
+        std::cout << b << ' ' << b[3] << ' ' << ~b[3] << ' ' << b.test(0) << '\n';
+        try
+        {
+            b.test(6);
+        }
+        catch (std::out_of_range& e)
+        {
+            std::cout << e.what() << '\n';
+        }
+    }
+
+    std::cout << "\nTest for count, find_first and find_next:\n";
+    {
+        Bits b(200);
+        std::cout << b.none() << ' ' << (b.find_first() == Bits::npos) << '\n';
+        b.set(3).set(63).set(64).set(130).set(199);
+        std::cout << b.count() << ' ' << b.any() << ':';
+        for (std::size_t i = b.find_first(); i != Bits::npos; i = b.find_next(i))
+            std::cout << ' ' << i;
+        std::cout << '\n';
+        b.reset(64).flip(65);
+        std::cout << b.find_next(63) << ' ' << b.count() << '\n';
+        b.flip();
+        std::cout << b.count() << ' ' << b.find_first() << '\n';
+    }
+
+    std::cout << "\nTest for resize, push_back and pop_back:\n";
+    {
+        Bits b;
+        for (int i = 0; i < 70; ++i)
+            b.push_back(i % 3 == 0);
+        std::cout << b.size() << ' ' << b.count() << ' ' << b.num_words() << '\n';
+        b.resize(130, true);
+        std::cout << b.size() << ' ' << b.count() << '\n';
+        b.resize(66);
+        std::cout << b.size() << ' ' << b.count() << ' ' << b.num_words() << '\n';
+        b.pop_back();
+        b.pop_back();
+        std::cout << b.size() << ' ' << b.count() << ' ' << b.num_words() << '\n';
+        b.set();
+        std::cout << b.count() << ' ' << b.all() << '\n';
+    }
+
+    std::cout << "\nTest for binary operations:\n";
+    {
+        Bits a(std::string("1100110011"));
+        Bits b(std::string("1010101010"));
+        std::cout << (a & b) << '\n' << (a | b) << '\n' << (a ^ b) << '\n' << ~a << '\n';
+        Bits c(a);
+        c.subtract(b);
+        std::cout << c << ' ' << (c == a) << ' ' << (c != a) << '\n';
+        c ^= c;
+        std::cout << c << '\n';
+        try
+        {
+            a &= Bits(3);
+        }
+        catch (std::invalid_argument& e)
+        {
+            std::cout << e.what() << '\n';
+        }
+    }
+
+    std::cout << "\nTest for memory and performance:\n";
+    {
+        constexpr std::size_t n = 100000000;
+        Bits mask(n);
+        Bits filter(n);
+        for (std::size_t i = 0; i < n; i += 3)
+            mask.set(i);
+        for (std::size_t i = 0; i < n; i += 5)
+            filter.set(i);
+        cyy::Vector<bool> bytes(n, false);
+        std::cout << bytes.size() * sizeof(bool) << " bytes as Vector<bool>, "
+                  << mask.num_words() * sizeof(Bits::word_type) << " bytes as Dynamic_bitset\n";
+
+        std::size_t count = 0;
+        double ms = time_ms([&] {
+            mask &= filter;
+            count = mask.count();
+        });
+        std::cerr << "AND and count of " << n << " bits: " << ms << "ms\n";
+        std::cout << count << '\n';
+    }
+}
@@ -0,0 +1,170 @@
+#include "execution.h"
+#include "vector.h"
+#include "list.h"
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <cassert>
+#include <cstdint>
+
+// throws when copied from a value of -1, counts the live objects
+struct Fragile
+{
+    static std::atomic<int> alive;
+
+    Fragile(int v = 0)
+        : value(v)
+    {
+        ++alive;
+    }
+
+    Fragile(const Fragile& other)
+        : value(other.value)
+    {
+        if (other.value == -1)
+        {
+            throw std::runtime_error("fragile");
+        }
+        ++alive;
+    }
+
+    ~Fragile()
+    {
+        --alive;
+    }
+
+    int value;
+};
+
+std::atomic<int> Fragile::alive{0};
+
+template<typename Function>
+double time_ms(Function f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main()
+{
+    std::cout << "Test for Thread_pool:\n";
+    {
+        cyy::Thread_pool pool(3);
+        std::cout << pool.concurrency() << '\n';
+        std::atomic<long> sum{0};
+        for (int round = 0; round < 100; ++round)
+        {
+            pool.run(10, [&sum] (std::size_t i) {
+                sum += i;
+            });
+        }
+        std::cout << sum << '\n';
+
+        // a job started by a task runs on its thread
+        std::atomic<int> inner{0};
+        pool.run(4, [&pool, &inner] (std::size_t) {
+            pool.run(3, [&inner] (std::size_t) {
+                ++inner;
+            });
+        });
+        std::cout << inner << '\n';
+
+        try
+        {
+            pool.run(8, [] (std::size_t i) {
+                if (i == 5)
+                {
+                    throw std::runtime_error("task 5");
+                }
+            });
+        }
+        catch (std::runtime_error& e)
+        {
+            std::cout << e.what() << '\n';
+        }
+    }
+
+    std::cout << "\nTest for parallel_for:\n";
+    {
+        constexpr std::size_t n = 1000003;
+        cyy::Vector<int> v(n, 0);
+        cyy::parallel_for(cyy::Parallel_policy(4, 1000), n, [&v] (std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                v[i] += 1;
+            }
+        }, sizeof(int), v.data());
+        long sum = 0;
+        for (int x : v)
+            sum += x;
+        std::cout << sum << '\n';
+
+        // every chunk starts with the first element starting in its page,
+        // also for elements that don't divide a page
+        std::size_t chunks = cyy::detail::chunk_count(cyy::Parallel_policy(4, 1000), n);
+        for (std::size_t size : {sizeof(int), std::size_t(24)})
+        {
+            std::size_t covered = 0;
+            auto base = reinterpret_cast<std::uintptr_t>(v.data());
+            for (std::size_t i = 0; i < chunks; ++i)
+            {
+                std::size_t begin = cyy::detail::chunk_begin(i, chunks, n / (size / sizeof(int)), size, v.data());
+                assert(begin == 0 || (base + (begin - 1) * size) / 4096 != (base + begin * size) / 4096);
+                covered += cyy::detail::chunk_begin(i + 1, chunks, n / (size / sizeof(int)), size, v.data()) - begin;
+            }
+            std::cout << covered << ' ';
+        }
+        std::cout << cyy::detail::chunk_count(cyy::par, 10) << '\n';
+    }
+
+    std::cout << "\nTest for parallel Vector construction:\n";
+    {
+        constexpr std::size_t n = 1 << 20;
+        cyy::Vector<long> a(cyy::par, n, 7);
+        cyy::Vector<long> b(cyy::Parallel_policy(3, 1), n);
+        cyy::Vector<long> c(cyy::par, a.begin(), a.end());
+        std::cout << a.size() << ' ' << a[0] << ' ' << a[n - 1] << ' ' << b[n / 2] << ' ' << (a == c) << '\n';
+
+        c.assign(cyy::par, 100, 3);
+        std::cout << c.size() << ' ' << c[99] << '\n';
+        c.assign(cyy::par, a.begin(), a.begin() + 5);
+        std::cout << c.size() << ' ' << c[4] << '\n';
+
+        cyy::List<int> l{1, 2, 3};
+        cyy::Vector<int> from_list(cyy::par, l.begin(), l.end());
+        std::cout << from_list.size() << ' ' << from_list[2] << '\n';
+
+        // a chunk throws, the others are destroyed
+        cyy::Vector<Fragile> source(100000, Fragile(1));
+        source[77777].value = -1;
+        try
+        {
+            cyy::Vector<Fragile> copy(cyy::Parallel_policy(4, 1), source.begin(), source.end());
+        }
+        catch (std::runtime_error& e)
+        {
+            std::cout << e.what() << ' ' << Fragile::alive << '\n';
+        }
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr std::size_t n = 64 * 1024 * 1024;
+        double sum = 0;
+        double serial = time_ms([&sum] {
+            cyy::Vector<double> v(n, 1.5);
+            sum += v[n - 1];
+        });
+        double parallel = time_ms([&sum] {
+            cyy::Vector<double> v(cyy::par, n, 1.5);
+            sum += v[n - 1];
+        });
+        std::cerr << "Vector of 64M doubles: " << serial << "ms serial, " << parallel << "ms with par on "
+                  << cyy::default_thread_pool().concurrency() << " threads\n";
+        std::cout << sum << '\n';
+    }
+}
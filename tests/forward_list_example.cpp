@@ -4,6 +4,8 @@
  
 #include "vector.h"
 #include "forward_list.h"
+#include "tracking_allocator.h"
+#include "arena.h"
 
 template<typename T>
 std::ostream& operator<<(std::ostream& s, const cyy::Forward_list<T>& v) {
@@ -326,4 +328,49 @@ int main()
         // descending:  9 8 7 6 5 4 3 2 1 0
 
     }
+
+    std::cout << "\nTest for reserve_nodes()\n";
+    {
+        struct Node_tag { };
+        using Alloc = cyy::Tracking_allocator<cyy::Allocator<int>, Node_tag>;
+        auto& stats = cyy::allocation_stats<Node_tag>();
+
+        cyy::Forward_list<int, Alloc> l;
+        l.reserve_nodes(1000);
+        std::cout << l.node_capacity() << ' ' << stats.snapshot().allocations << '\n';
+        // output 1000 1000
+
+        // the nodes go back and forth between the list and the spare chain
+        stats.reset();
+        for (int round = 0; round < 100; ++round)
+        {
+            l.assign(std::size_t(1000), round);
+            l.resize(500);
+            l.clear();
+            l.insert_after(l.before_begin(), {1, 2, 3});
+            l.erase_after(l.begin());
+            l.resize(1000, 7);
+        }
+        std::cout << l.node_capacity() << ' ' << stats.snapshot().allocations << '\n';
+        // output 1000 0
+
+        // without a reserve, no node is kept
+        l.release_nodes();
+        l.clear();
+        std::cout << l.node_capacity() << ' ' << stats.snapshot().bytes_in_use / sizeof(cyy::detail::Fwd_list_node<int>) << '\n';
+        // output 0 0
+
+        // the memory of an arena may be reset under the list, no node is kept
+        cyy::Arena arena;
+        cyy::Forward_list<int, cyy::Arena_allocator<int>> a{cyy::Arena_allocator<int>(arena)};
+        a.reserve_nodes(100);
+        a.assign({1, 2, 3});
+        a.clear();
+        std::cout << a.node_capacity() << '\n';
+        // output 0
+        arena.reset();
+        a.assign({4, 5});
+        std::cout << a.node_capacity() << '\n';
+        // output 2
+    }
 }
\ No newline at end of file
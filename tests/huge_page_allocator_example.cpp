@@ -0,0 +1,103 @@
+#include "huge_page_allocator.h"
+#include "vector.h"
+#include "list.h"
+#include "pool_allocator.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <cassert>
+
+template<typename Alloc>
+double random_reads(std::size_t n)
+{
+    cyy::Vector<float, Alloc> table(n, 1.0f);
+    auto t0 = std::chrono::steady_clock::now();
+    std::uint64_t x = 88172645463325252ull;
+    float sum = 0;
+    for (int i = 0; i < 4000000; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        sum += table[x % n];
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    assert(sum == 4000000.0f || sum > 0);
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main()
+{
+    std::cout << "Test for map_huge_pages:\n";
+    {
+        void* p = cyy::detail::map_huge_pages(3 * 1024 * 1024);
+        assert(p != nullptr);
+        std::cout << (reinterpret_cast<std::uintptr_t>(p) % cyy::detail::HUGE_PAGE_SIZE == 0) << '\n';
+        static_cast<char*>(p)[4 * 1024 * 1024 - 1] = 1;
+        cyy::detail::unmap_huge_pages(p, 3 * 1024 * 1024);
+        std::cout << cyy::detail::huge_page_round(1) << ' ' << cyy::detail::huge_page_round(2 * 1024 * 1024 + 1) << '\n';
+    }
+
+    std::cout << "\nTest for Huge_page_allocator:\n";
+    {
+        cyy::Huge_page_allocator<double> alloc;
+        // small allocations come from operator new
+        double* small = alloc.allocate(10);
+        small[9] = 1;
+        alloc.deallocate(small, 10);
+
+        double* big = alloc.allocate(1 << 20);
+        std::cout << (reinterpret_cast<std::uintptr_t>(big) % cyy::detail::HUGE_PAGE_SIZE == 0) << '\n';
+        big[(1 << 20) - 1] = 2;
+        alloc.deallocate(big, 1 << 20);
+
+        cyy::Vector<float, cyy::Huge_page_allocator<float>> v;
+        for (int i = 0; i < 1000000; ++i)
+        {
+            v.push_back(i);
+        }
+        std::cout << v.size() << ' ' << v[999999] << ' '
+                  << (reinterpret_cast<std::uintptr_t>(&v[0]) % cyy::detail::HUGE_PAGE_SIZE == 0) << '\n';
+        v.shrink_to_fit();
+        std::cout << v.capacity() << '\n';
+    }
+
+    std::cout << "\nTest for Numa_allocator:\n";
+    {
+        // node 0 exists on every machine, binding may still be refused
+        cyy::Numa_allocator<int> alloc(0);
+        cyy::Vector<int, cyy::Numa_allocator<int>> v(alloc);
+        v.resize(1 << 20);
+        v[12345] = 7;
+        std::cout << v.get_allocator().node() << ' ' << v[12345] << '\n';
+
+        cyy::Vector<int, cyy::Numa_allocator<int>> w;
+        w = v;
+        std::cout << w.get_allocator().node() << ' ' << w[12345] << '\n';
+    }
+
+    std::cout << "\nTest for huge_page_alloc:\n";
+    {
+        using List = cyy::List<int, cyy::Pool_allocator<int, cyy::huge_page_alloc>>;
+        {
+            List l;
+            for (int i = 0; i < 100000; ++i)
+            {
+                l.push_back(i);
+            }
+            std::cout << l.size() << ' ' << l.back() << '\n';
+        }
+        std::cout << (cyy::huge_page_alloc::trim() > 0) << '\n';
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr std::size_t n = 64 * 1024 * 1024;
+        double plain = random_reads<cyy::Allocator<float>>(n);
+        double huge = random_reads<cyy::Huge_page_allocator<float>>(n);
+        std::cerr << "random reads in 256 MB: " << plain << "ms with Allocator, "
+                  << huge << "ms with Huge_page_allocator\n";
+        std::cout << "done\n";
+    }
+}
@@ -0,0 +1,191 @@
+#include "intrusive_list.h"
+#include "list.h"
+#include "vector.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+// every allocation of the program is counted
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t n)
+{
+    ++allocations;
+    if (void* p = std::malloc(n))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// on an LRU list and a wait list at once, and on a timer list
+struct Connection
+{
+    explicit Connection(int id = 0)
+        : id(id)
+    {
+    }
+
+    int id;
+    cyy::List_hook lru_hook;
+    cyy::List_hook wait_hook;
+    cyy::Forward_list_hook timer_hook;
+};
+
+using Lru_list = cyy::Intrusive_list<Connection, &Connection::lru_hook>;
+using Wait_list = cyy::Intrusive_list<Connection, &Connection::wait_hook>;
+using Timer_list = cyy::Intrusive_forward_list<Connection, &Connection::timer_hook>;
+
+template<typename List>
+void print(const List& l)
+{
+    for (const Connection& c : l)
+        std::cout << c.id << ' ';
+    std::cout << '\n';
+}
+
+template<typename Function>
+double time_ms(Function f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main()
+{
+    std::cout << "Test for Intrusive_list:\n";
+    {
+        cyy::Vector<Connection> conns;
+        conns.reserve(8);
+        for (int i = 0; i < 8; ++i)
+            conns.emplace_back(i);
+
+        std::size_t before = allocations;
+        Lru_list lru;
+        Wait_list waiting;
+        for (auto& c : conns)
+        {
+            lru.push_back(c);
+            if (c.id % 3 == 0)
+                waiting.push_front(c);
+        }
+        print(lru);
+        print(waiting);
+        std::cout << lru.size() << ' ' << waiting.size() << ' ' << lru.front().id << ' ' << lru.back().id << '\n';
+
+        // touch: move to the front of the LRU list, the wait list is untouched
+        lru.splice(lru.begin(), lru, Lru_list::iterator_to(conns[5]));
+        lru.splice(lru.begin(), lru, Lru_list::iterator_to(conns[3]));
+        print(lru);
+        print(waiting);
+
+        // evict the least recently used
+        Connection& victim = lru.back();
+        lru.pop_back();
+        std::cout << victim.id << ' ' << victim.lru_hook.is_linked() << ' ' << lru.size() << '\n';
+
+        waiting.erase(Wait_list::iterator_to(conns[3]));
+        std::cout << conns[3].wait_hook.is_linked() << ' ' << conns[3].lru_hook.is_linked() << '\n';
+        print(waiting);
+
+        // a copy starts unlinked
+        Connection copy = conns[0];
+        std::cout << copy.id << ' ' << copy.lru_hook.is_linked() << ' ' << conns[0].lru_hook.is_linked() << '\n';
+
+        Lru_list other;
+        other.splice(other.end(), lru, std::next(lru.begin()), std::next(lru.begin(), 4));
+        print(lru);
+        print(other);
+        lru.swap(other);
+        std::cout << lru.size() << ' ' << other.size() << '\n';
+        lru.splice(lru.end(), other);
+        lru.reverse();
+        print(lru);
+        lru.remove_if([] (const Connection& c) { return c.id % 2 == 1; });
+        print(lru);
+        std::cout << conns[1].lru_hook.is_linked() << '\n';
+
+        Lru_list moved(std::move(lru));
+        std::cout << lru.empty() << ' ' << moved.size() << ' ';
+        print(moved);
+        moved.clear();
+        std::cout << moved.empty() << ' ' << conns[0].lru_hook.is_linked() << '\n';
+        std::cout << "allocations: " << allocations - before << '\n';
+    }
+
+    std::cout << "\nTest for Intrusive_forward_list:\n";
+    {
+        Connection conns[6] = {Connection(0), Connection(1), Connection(2), Connection(3), Connection(4), Connection(5)};
+        std::size_t before = allocations;
+        Timer_list timers;
+        for (auto& c : conns)
+            timers.push_front(c);
+        print(timers);
+        timers.reverse();
+        print(timers);
+        timers.erase_after(Timer_list::iterator_to(conns[1]));
+        print(timers);
+        timers.insert_after(Timer_list::iterator_to(conns[1]), conns[2]);
+        print(timers);
+
+        Timer_list expired;
+        expired.splice_after(expired.before_begin(), timers, timers.before_begin(), Timer_list::iterator_to(conns[3]));
+        print(timers);
+        print(expired);
+        expired.splice_after(expired.before_begin(), timers, timers.before_begin());
+        print(timers);
+        print(expired);
+        timers.splice_after(timers.before_begin(), expired);
+        print(timers);
+        std::cout << expired.empty() << '\n';
+        timers.remove_if([] (const Connection& c) { return c.id > 3; });
+        print(timers);
+        timers.pop_front();
+        std::cout << timers.front().id << '\n';
+        std::cout << "allocations: " << allocations - before << '\n';
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr int n = 1000000;
+        cyy::Vector<Connection> conns;
+        conns.reserve(n);
+        for (int i = 0; i < n; ++i)
+            conns.emplace_back(i);
+
+        long s1 = 0, s2 = 0;
+        std::size_t before = allocations;
+        double t_list = time_ms([&] {
+            cyy::List<Connection*> l;
+            for (auto& c : conns)
+                l.push_back(&c);
+            for (Connection* c : l)
+                s1 += c->id;
+        });
+        std::size_t list_allocations = allocations - before;
+        before = allocations;
+        double t_intrusive = time_ms([&] {
+            Lru_list l;
+            for (auto& c : conns)
+                l.push_back(c);
+            for (const Connection& c : l)
+                s2 += c.id;
+        });
+        std::cerr << "link and walk 1M objects: List<Connection*> " << t_list << "ms, Intrusive_list "
+                  << t_intrusive << "ms\n";
+        std::cout << (s1 == s2) << ' ' << list_allocations << ' ' << allocations - before << '\n';
+    }
+}
@@ -1,4 +1,6 @@
 #include "list.h"
+#include "tracking_allocator.h"
+#include "arena.h"
 
 #include <string>
 #include <iostream>
@@ -349,4 +351,45 @@ int main()
         std::cout << "descending: " << list << "\n";
     }
 
+    std::cout << "\nTest for reserve_nodes()\n";
+    {
+        struct Node_tag { };
+        using Alloc = Tracking_allocator<Allocator<int>, Node_tag>;
+        auto& stats = allocation_stats<Node_tag>();
+
+        List<int, Alloc> l;
+        l.reserve_nodes(1000);
+        std::cout << l.node_capacity() << ' ' << stats.snapshot().allocations << '\n';
+
+        // the nodes go back and forth between the list and the spare chain
+        stats.reset();
+        for (int round = 0; round < 100; ++round)
+        {
+            l.assign(1000, round);
+            l.resize(500);
+            l.clear();
+            l.insert(l.end(), {1, 2, 3});
+            l.erase(l.begin());
+            l.resize(1000, 7);
+        }
+        assert(l.size() == 1000 && l.back() == 7);
+        std::cout << l.node_capacity() << ' ' << stats.snapshot().allocations << '\n';
+
+        // without a reserve, no node is kept
+        l.release_nodes();
+        l.clear();
+        std::cout << l.node_capacity() << ' ' << stats.snapshot().bytes_in_use / sizeof(detail::List_node<int>) << '\n';
+
+        // the memory of an arena may be reset under the list, no node is kept
+        Arena arena;
+        List<int, Arena_allocator<int>> a{Arena_allocator<int>(arena)};
+        a.reserve_nodes(100);
+        a.assign({1, 2, 3});
+        a.clear();
+        std::cout << a.node_capacity() << '\n';
+        arena.reset();
+        a.assign({4, 5});
+        std::cout << a.node_capacity() << '\n';
+    }
+
 }
\ No newline at end of file
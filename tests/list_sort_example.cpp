@@ -0,0 +1,209 @@
+#include "list.h"
+#include "forward_list.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <iterator>
+#include <utility>
+#include <cstdint>
+#include <algorithm>
+
+// pseudo random numbers, the same on every run
+struct Lcg
+{
+    std::uint32_t operator()()
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return state >> 33;
+    }
+
+    std::uint64_t state = 42;
+};
+
+template<typename Function>
+double time_ms(Function f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+// the sorts List and Forward_list had before: walk to the middle, split,
+// sort both halves recursively and merge them
+template<typename T>
+void top_down_sort(cyy::List<T>& l)
+{
+    if (l.size() < 2)
+        return;
+    cyy::List<T> right;
+    right.splice(right.begin(), l, std::next(l.begin(), l.size() / 2), l.end());
+    top_down_sort(l);
+    top_down_sort(right);
+    l.merge(right);
+}
+
+template<typename T>
+void top_down_sort(cyy::Forward_list<T>& l)
+{
+    if (l.empty() || std::next(l.begin()) == l.end())
+        return;
+    auto slow = l.begin(), fast = std::next(l.begin());
+    while (fast != l.end() && std::next(fast) != l.end())
+    {
+        ++slow;
+        std::advance(fast, 2);
+    }
+    cyy::Forward_list<T> right;
+    right.splice_after(right.before_begin(), l, slow, l.end());
+    top_down_sort(l);
+    top_down_sort(right);
+    l.merge(right);
+}
+
+template<typename List>
+bool is_sorted(const List& l)
+{
+    return std::is_sorted(l.begin(), l.end());
+}
+
+int main()
+{
+    std::cout << "Test for List::sort:\n";
+    {
+        cyy::List<int> empty;
+        empty.sort();
+        cyy::List<int> one{1};
+        one.sort();
+        cyy::List<int> l{5, 9, 0, 1, 3, 8, 7, 2, 6, 4, 5};
+        l.sort();
+        for (int x : l)
+            std::cout << x << ' ';
+        std::cout << '\n' << empty.size() << ' ' << one.front() << ' ' << l.size() << ' ' << l.back() << '\n';
+        l.sort(std::greater<int>());
+        for (auto it = std::prev(l.end()); it != l.begin(); --it)
+            std::cout << *it << ' ';
+        std::cout << *l.begin() << '\n';
+
+        // equal keys keep their order, so the pairs end up sorted
+        cyy::List<std::pair<int, int>> pairs;
+        Lcg rand;
+        for (int i = 0; i < 1000; ++i)
+            pairs.push_back({static_cast<int>(rand() % 10), i});
+        pairs.sort([] (const auto& a, const auto& b) { return a.first < b.first; });
+        std::cout << is_sorted(pairs) << '\n';
+    }
+
+    std::cout << "\nTest for List::sort by index:\n";
+    {
+        cyy::List<int> l{5, 9, 0, 1, 3, 8, 7, 2, 6, 4, 5};
+        const int* five = &l.front();
+        l.sort(cyy::Sort_mode::index);
+        for (int x : l)
+            std::cout << x << ' ';
+        // the nodes are relinked, the elements stay where they are
+        std::cout << '\n' << (five == &*std::next(l.begin(), 5)) << ' '
+                  << *std::prev(l.end()) << ' ' << *std::next(l.rbegin(), 10) << '\n';
+
+        // values copied beside the nodes, and values compared in the nodes
+        cyy::List<std::pair<int, int>> pairs;
+        cyy::List<std::string> strings;
+        Lcg rand;
+        for (int i = 0; i < 20000; ++i)
+        {
+            pairs.push_back({static_cast<int>(rand() % 10), i});
+            strings.push_back(std::to_string(rand() % 1000));
+        }
+        pairs.sort([] (const auto& a, const auto& b) { return a.first < b.first; });
+        strings.sort(cyy::Sort_mode::index);
+        std::cout << is_sorted(pairs) << ' ' << is_sorted(strings) << ' ' << strings.size() << '\n';
+
+        // elements that cannot be assigned, only the nodes move
+        struct Key { const int k; };
+        auto by_key = [] (const Key& a, const Key& b) { return a.k < b.k; };
+        cyy::List<Key> keys;
+        cyy::Forward_list<Key> fwd_keys;
+        for (int i = 0; i < 10; ++i)
+        {
+            keys.push_back({static_cast<int>(rand() % 100)});
+            fwd_keys.push_front({static_cast<int>(rand() % 100)});
+        }
+        keys.sort(by_key, cyy::Sort_mode::index);
+        fwd_keys.sort(by_key, cyy::Sort_mode::index);
+        keys.sort(by_key);
+        std::cout << std::is_sorted(keys.begin(), keys.end(), by_key) << ' '
+                  << std::is_sorted(fwd_keys.begin(), fwd_keys.end(), by_key) << '\n';
+    }
+
+    std::cout << "\nTest for Forward_list::sort:\n";
+    {
+        cyy::Forward_list<int> empty;
+        empty.sort();
+        cyy::Forward_list<int> l{5, 9, 0, 1, 3, 8, 7, 2, 6, 4, 5};
+        l.sort();
+        for (int x : l)
+            std::cout << x << ' ';
+        std::cout << '\n' << empty.empty() << '\n';
+
+        cyy::Forward_list<std::pair<int, int>> pairs;
+        Lcg rand;
+        for (int i = 0; i < 1000; ++i)
+            pairs.push_front({static_cast<int>(rand() % 10), -i});
+        pairs.sort([] (const auto& a, const auto& b) { return a.first < b.first; });
+        std::cout << is_sorted(pairs) << '\n';
+
+        cyy::Forward_list<std::string> strings{"b", "c", "a", "b"};
+        strings.sort(std::greater<std::string>(), cyy::Sort_mode::index);
+        for (const auto& x : strings)
+            std::cout << x << ' ';
+        std::cout << '\n';
+
+        // long enough to be sorted by index in automatic mode
+        pairs.clear();
+        for (int i = 0; i < 20000; ++i)
+            pairs.push_front({static_cast<int>(rand() % 10), -i});
+        pairs.sort([] (const auto& a, const auto& b) { return a.first < b.first; });
+        std::cout << is_sorted(pairs) << '\n';
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr int n = 10000000;
+        Lcg rand;
+        cyy::List<std::uint32_t> a, b;
+        cyy::Forward_list<std::uint32_t> c, d;
+        for (int i = 0; i < n; ++i)
+        {
+            std::uint32_t x = rand();
+            a.push_back(x);
+            b.push_back(x);
+            c.push_front(x);
+            d.push_front(x);
+        }
+        double list_merge = time_ms([&a] { a.sort(cyy::Sort_mode::merge); });
+        double list_top_down = time_ms([&b] { top_down_sort(b); });
+        double forward_merge = time_ms([&c] { c.sort(cyy::Sort_mode::merge); });
+        double forward_top_down = time_ms([&d] { top_down_sort(d); });
+        std::cout << is_sorted(a) << ' ' << (a == b) << ' ' << is_sorted(c) << ' ' << (c == d) << '\n';
+
+        // the same lists again, sorted by index
+        a.clear();
+        c.clear();
+        rand = Lcg();
+        for (int i = 0; i < n; ++i)
+        {
+            std::uint32_t x = rand();
+            a.push_back(x);
+            c.push_front(x);
+        }
+        double list_index = time_ms([&a] { a.sort(cyy::Sort_mode::index); });
+        double forward_index = time_ms([&c] { c.sort(cyy::Sort_mode::index); });
+        std::cout << (a == b) << ' ' << (c == d) << '\n';
+
+        std::cerr << "List of " << n << ": bottom-up sort " << list_merge << "ms, top-down "
+                  << list_top_down << "ms, by index " << list_index << "ms\n";
+        std::cerr << "Forward_list of " << n << ": bottom-up sort " << forward_merge << "ms, top-down "
+                  << forward_top_down << "ms, by index " << forward_index << "ms\n";
+    }
+}
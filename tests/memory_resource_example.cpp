@@ -0,0 +1,215 @@
+#include "memory_resource.h"
+#include "vector.h"
+#include "list.h"
+#include "forward_list.h"
+#include "thread.h"
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <cassert>
+
+// resource counting the bytes in use, on top of another one
+class Counting_resource
+    : public cyy::pmr::memory_resource
+{
+public:
+    explicit Counting_resource(cyy::pmr::memory_resource* upstream = cyy::pmr::new_delete_resource())
+        : upstream(upstream), in_use(0), allocations(0)
+    {
+    }
+
+    cyy::pmr::memory_resource* upstream;
+    std::size_t in_use;
+    std::size_t allocations;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        in_use += bytes;
+        ++allocations;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        in_use -= bytes;
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const cyy::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// the memory strategy is picked at runtime, the code using the containers
+// is compiled once
+long sum_of_squares(cyy::pmr::memory_resource* resource, int n)
+{
+    cyy::pmr::Vector<long> v(resource);
+    cyy::pmr::List<long> l(resource);
+    cyy::pmr::Forward_list<long> fl(resource);
+    for (int i = 0; i < n; ++i)
+    {
+        v.push_back(i);
+        l.push_back(i);
+        fl.push_front(i);
+    }
+    long sum = 0;
+    for (auto i : v)
+        sum += i * i;
+    for (auto i : l)
+        sum -= i * i;
+    for (auto i : fl)
+        sum += i * i;
+    return sum;
+}
+
+int main()
+{
+    std::cout << "Test for memory_resource:\n";
+    {
+        auto r = cyy::pmr::new_delete_resource();
+        void* p = r->allocate(100);
+        void* q = r->allocate(100, 256);
+        assert(reinterpret_cast<std::uintptr_t>(q) % 256 == 0);
+        r->deallocate(p, 100);
+        r->deallocate(q, 100, 256);
+        std::cout << (*r == *cyy::pmr::new_delete_resource()) << ' '
+                  << (*r == *cyy::pmr::null_memory_resource()) << '\n';
+        try
+        {
+            cyy::pmr::null_memory_resource()->allocate(1);
+        }
+        catch (std::bad_alloc&)
+        {
+            std::cout << "bad_alloc\n";
+        }
+
+        Counting_resource counting;
+        auto old = cyy::pmr::set_default_resource(&counting);
+        {
+            cyy::pmr::polymorphic_allocator<int> alloc;
+            std::cout << (alloc.resource() == &counting) << '\n';
+            int* ip = alloc.allocate(10);
+            std::cout << counting.in_use << '\n';
+            alloc.deallocate(ip, 10);
+        }
+        std::cout << counting.in_use << '\n';
+        std::cout << (cyy::pmr::set_default_resource(old) == &counting) << '\n';
+    }
+
+    std::cout << "\nTest for polymorphic_allocator:\n";
+    {
+        Counting_resource r1, r2;
+        cyy::pmr::polymorphic_allocator<int> a1(&r1);
+        cyy::pmr::polymorphic_allocator<double> a2(a1);
+        cyy::pmr::polymorphic_allocator<int> a3(&r2);
+        std::cout << (a1 == a2) << ' ' << (a1 == a3) << '\n';
+
+        cyy::pmr::Vector<std::string> v(&r1);
+        v.push_back("hello");
+        v.push_back("world");
+        std::cout << (r1.in_use > 0) << ' ' << r2.in_use << '\n';
+
+        // the resource is not propagated
+        cyy::pmr::Vector<std::string> w(&r2);
+        w = v;
+        std::cout << w[0] << ' ' << w[1] << ' ' << (w.get_allocator().resource() == &r2) << ' ' << (r2.in_use > 0) << '\n';
+        w = std::move(v);
+        std::cout << w.size() << ' ' << (w.get_allocator().resource() == &r2) << '\n';
+
+        // a copy gets the default resource
+        auto copy = w;
+        std::cout << (copy.get_allocator().resource() == cyy::pmr::get_default_resource()) << '\n';
+
+        cyy::pmr::List<int> l1({1, 2, 3}, &r1);
+        cyy::pmr::List<int> l2(std::move(l1), &r2);
+        std::cout << l2.size() << ' ' << l2.back() << '\n';
+        cyy::pmr::Forward_list<int> f1({1, 2, 3}, &r1);
+        cyy::pmr::Forward_list<int> f2(&r2);
+        f2 = std::move(f1);
+        std::cout << f2.front() << ' ' << (f2.get_allocator().resource() == &r2) << '\n';
+    }
+
+    std::cout << "\nTest for unsynchronized_pool_resource:\n";
+    {
+        Counting_resource upstream;
+        {
+            cyy::pmr::unsynchronized_pool_resource pool(cyy::pmr::pool_options{64, 512}, &upstream);
+            std::cout << pool.options().max_blocks_per_chunk << ' '
+                      << pool.options().largest_required_pool_block << '\n';
+            void* blocks[100];
+            for (int i = 0; i < 100; ++i)
+            {
+                blocks[i] = pool.allocate(24);
+            }
+            std::size_t allocations = upstream.allocations;
+            for (int i = 0; i < 100; ++i)
+            {
+                pool.deallocate(blocks[i], 24);
+            }
+            // freed blocks are used again
+            for (int i = 0; i < 100; ++i)
+            {
+                blocks[i] = pool.allocate(24);
+            }
+            std::cout << (upstream.allocations == allocations) << '\n';
+
+            void* aligned = pool.allocate(8, 128);
+            assert(reinterpret_cast<std::uintptr_t>(aligned) % 128 == 0);
+            pool.deallocate(aligned, 8, 128);
+
+            // too large for the pools
+            void* big = pool.allocate(10000, 64);
+            assert(reinterpret_cast<std::uintptr_t>(big) % 64 == 0);
+            std::size_t in_use = upstream.in_use;
+            pool.deallocate(big, 10000, 64);
+            std::cout << (upstream.in_use < in_use) << '\n';
+
+            std::cout << sum_of_squares(&pool, 1000) << '\n';
+            pool.release();
+            std::cout << upstream.in_use << '\n';
+        }
+        std::cout << upstream.in_use << '\n';
+    }
+
+    std::cout << "\nTest for synchronized_pool_resource:\n";
+    {
+        cyy::pmr::synchronized_pool_resource pool;
+        std::vector<cyy::Thread> workers;
+        long sums[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            workers.emplace_back([&pool, &sums, i] () {
+                sums[i] = sum_of_squares(&pool, 10000);
+            });
+        }
+        for (auto& t : workers)
+        {
+            t.join();
+        }
+        std::cout << sums[0] << ' ' << (sums[0] == sums[3]) << '\n';
+    }
+
+    std::cout << "\nTest for monotonic_buffer_resource:\n";
+    {
+        Counting_resource upstream;
+        char buffer[256];
+        cyy::pmr::monotonic_buffer_resource mono(buffer, sizeof(buffer), &upstream);
+        void* p = mono.allocate(100);
+        std::cout << (static_cast<char*>(p) >= buffer && static_cast<char*>(p) < buffer + sizeof(buffer))
+                  << ' ' << upstream.allocations << '\n';
+        // doesn't fit in the buffer any more
+        mono.allocate(200);
+        std::cout << upstream.allocations << '\n';
+        void* q = mono.allocate(10, 64);
+        assert(reinterpret_cast<std::uintptr_t>(q) % 64 == 0);
+        mono.deallocate(q, 10, 64);
+
+        std::cout << sum_of_squares(&mono, 1000) << '\n';
+        mono.release();
+        std::cout << upstream.in_use << ' ' << (mono.allocate(8) >= static_cast<void*>(buffer)) << '\n';
+    }
+}
@@ -0,0 +1,115 @@
+#include "pool_allocator.h"
+#include "allocator_traits.h"
+#include "vector.h"
+#include "list.h"
+#include "forward_list.h"
+
+#include <string>
+#include <iostream>
+#include <cassert>
+
+struct alignas(32) Wide
+{
+    double v[4];
+};
+
+int main()
+{
+    std::cout << "Test for Pool_allocator:\n";
+    {
+        using Traits = cyy::Allocator_traits<cyy::Pool_allocator<int>>;
+        std::cout << Traits::is_always_equal::value << ' '
+                  << Traits::propagate_on_container_move_assignment::value << '\n';
+
+        cyy::Pool_allocator<int> a1;
+        int* p = Traits::allocate(a1, 4);
+        for (int i = 0; i < 4; ++i)
+        {
+            Traits::construct(a1, p + i, i);
+        }
+        std::cout << p[0] + p[1] + p[2] + p[3] << '\n';
+        Traits::deallocate(a1, p, 4);
+
+        // rebind and compare
+        Traits::rebind_alloc<std::string> a2(a1);
+        std::cout << (a1 == cyy::Pool_allocator<int>(a2)) << '\n';
+
+        // over-aligned types do not come from the pool
+        cyy::Pool_allocator<Wide> a3;
+        Wide* w = a3.allocate(3);
+        std::cout << (reinterpret_cast<std::uintptr_t>(w) % alignof(Wide)) << '\n';
+        a3.deallocate(w, 3);
+    }
+
+    std::cout << "\nTest for containers with Pool_allocator:\n";
+    {
+        cyy::List<std::string, cyy::Pool_allocator<std::string>> l1{"a", "b", "c"};
+        cyy::List<std::string, cyy::Pool_allocator<std::string>> l2{"d"};
+        l1.push_back("e");
+        l1.swap(l2);
+        for (auto& s : l2)
+            std::cout << s << ' ';
+        std::cout << "| " << l1.front() << '\n';
+
+        cyy::Forward_list<int, cyy::Pool_allocator<int>> f1{3, 1, 2};
+        cyy::Forward_list<int, cyy::Pool_allocator<int>> f2;
+        f1.sort();
+        f1.swap(f2);
+        std::cout << f1.empty() << ' ';
+        for (int i : f2)
+            std::cout << i << ' ';
+        std::cout << '\n';
+
+        cyy::Vector<int, cyy::Pool_allocator<int, cyy::single_client_alloc>> v1{1, 2, 3};
+        cyy::Vector<int, cyy::Pool_allocator<int, cyy::single_client_alloc>> v2;
+        for (int i = 0; i < 100; ++i)
+            v1.push_back(i);
+        v2 = std::move(v1);
+        std::cout << v1.size() << ' ' << v2.size() << ' ' << v2[3] << '\n';
+    }
+
+    std::cout << "\nTest for allocate_at_least and try_expand:\n";
+    {
+        using Alloc = cyy::Pool_allocator<char, cyy::single_client_alloc>;
+        using Traits = cyy::Allocator_traits<Alloc>;
+        Alloc a;
+        // 5 bytes come from the 8 bytes class
+        auto r = Traits::allocate_at_least(a, 5);
+        std::cout << r.count << ' ' << Traits::try_expand(a, r.ptr, r.count, 8) << ' '
+                  << Traits::try_expand(a, r.ptr, 8, 9) << '\n';
+        Traits::deallocate(a, r.ptr, 8);
+
+        // the default is to get what was asked for and never expand
+        cyy::Allocator<int> b;
+        using Default_traits = cyy::Allocator_traits<cyy::Allocator<int>>;
+        auto r2 = Default_traits::allocate_at_least(b, 5);
+        std::cout << r2.count << ' ' << Default_traits::try_expand(b, r2.ptr, 5, 6) << ' '
+                  << Default_traits::can_reallocate::value << ' ' << Traits::can_reallocate::value << '\n';
+        Default_traits::deallocate(b, r2.ptr, 5);
+
+        // the capacity follows the size classes
+        cyy::Vector<char, Alloc> v;
+        v.push_back('a');
+        std::cout << v.capacity() << ' ';
+        for (int i = 0; i < 20; ++i)
+            v.push_back('b');
+        std::cout << v.capacity() << '\n';
+
+        // large blocks of trivially copyable elements are realloc'ed
+        cyy::Vector<long, cyy::Pool_allocator<long>> big;
+        for (long i = 0; i < 1000000; ++i)
+            big.push_back(i);
+        long sum = 0;
+        for (long i : big)
+            sum += i;
+        std::cout << big.size() << ' ' << (big.capacity() >= big.size()) << ' ' << sum << '\n';
+        big.shrink_to_fit();
+        std::cout << (big.capacity() < 2 * big.size()) << ' ' << big[999999] << '\n';
+
+        // not for the others
+        cyy::Vector<std::string, cyy::Pool_allocator<std::string>> strings;
+        for (int i = 0; i < 1000; ++i)
+            strings.push_back(std::to_string(i));
+        std::cout << strings[999] << '\n';
+    }
+}
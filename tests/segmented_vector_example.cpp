@@ -0,0 +1,146 @@
+#include "segmented_vector.h"
+#include "vector.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <sstream>
+#include <iterator>
+#include <cassert>
+
+template<typename Container>
+void print(const Container& c)
+{
+    for (const auto& x : c)
+        std::cout << x << ' ';
+    std::cout << '\n';
+}
+
+// longest single push_back while pushing n elements
+template<typename Container>
+double worst_push_back_us(Container& c, std::size_t n)
+{
+    double worst = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        c.push_back(i);
+        auto t1 = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        if (us > worst)
+            worst = us;
+    }
+    return worst;
+}
+
+int main()
+{
+    std::cout << "Test for constructors:\n";
+    {
+        cyy::Segmented_vector<int> a;
+        cyy::Segmented_vector<int> b(5, 3);
+        cyy::Segmented_vector<int> c(3);
+        cyy::Segmented_vector<int> d{1, 2, 3, 4};
+        std::istringstream in("7 8 9");
+        cyy::Segmented_vector<int> e{std::istream_iterator<int>(in), std::istream_iterator<int>()};
+        cyy::Segmented_vector<int> f(d);
+        cyy::Segmented_vector<int> g(std::move(f));
+        std::cout << a.size() << ' ' << f.size() << '\n';
+        print(b);
+        print(c);
+        print(d);
+        print(e);
+        print(g);
+    }
+
+    std::cout << "\nTest for segments:\n";
+    {
+        using Small = cyy::Segmented_vector<std::string, cyy::Allocator<std::string>, 4>;
+        Small v;
+        v.push_back("a");
+        std::string* first = &v[0];
+        for (int i = 1; i < 10; ++i)
+        {
+            v.push_back(std::string(1, 'a' + i));
+        }
+        // growth never moves an element
+        assert(first == &v[0]);
+        std::cout << v.size() << ' ' << v.capacity() << ' ' << *first << ' ' << v.back() << '\n';
+        print(v);
+
+        v.reserve(20);
+        std::cout << v.capacity() << '\n';
+        v.resize(5);
+        v.shrink_to_fit();
+        std::cout << v.size() << ' ' << v.capacity() << ' ' << (first == &v[0]) << '\n';
+        v.clear();
+        std::cout << v.empty() << ' ' << v.capacity() << '\n';
+
+        std::cout << cyy::Segmented_vector<char>::segment_size << ' '
+                  << cyy::Segmented_vector<double>::segment_size << ' '
+                  << cyy::Segmented_vector<char[1000]>::segment_size << '\n';
+    }
+
+    std::cout << "\nTest for modifiers:\n";
+    {
+        cyy::Segmented_vector<int, cyy::Allocator<int>, 4> v{1, 2, 3, 4, 5, 6, 7, 8, 9};
+        v.insert(v.begin() + 2, 100);
+        v.insert(v.begin(), 2, -1);
+        v.insert(v.end(), {10, 11});
+        int& x = v.emplace_back(12);
+        x += 100;
+        print(v);
+
+        v.erase(v.begin());
+        v.erase(v.begin() + 2, v.begin() + 6);
+        v.pop_back();
+        print(v);
+
+        v.resize(10, 0);
+        print(v);
+        v.assign(3, 5);
+        print(v);
+        v.insert(v.begin() + 1, v[0]);
+        print(v);
+    }
+
+    std::cout << "\nTest for iterators:\n";
+    {
+        cyy::Segmented_vector<int, cyy::Allocator<int>, 8> v;
+        for (int i = 0; i < 30; ++i)
+            v.push_back(30 - i);
+        std::sort(v.begin(), v.end());
+        cyy::Segmented_vector<int, cyy::Allocator<int>, 8>::const_iterator it = v.begin() + 10;
+        std::cout << *it << ' ' << it[5] << ' ' << (v.end() - it) << ' ' << *v.rbegin() << '\n';
+        for (auto r = v.rbegin(); r != v.rbegin() + 3; ++r)
+            std::cout << *r << ' ';
+        std::cout << '\n';
+    }
+
+    std::cout << "\nTest for comparison and swap:\n";
+    {
+        cyy::Segmented_vector<int> a{1, 2, 3};
+        cyy::Segmented_vector<int> b{1, 2, 4};
+        std::cout << (a == b) << ' ' << (a != b) << ' ' << (a < b) << ' ' << (a >= b) << '\n';
+        swap(a, b);
+        print(a);
+        b = a;
+        std::cout << (a == b) << '\n';
+        b = {9};
+        a = std::move(b);
+        print(a);
+        std::cout << a.at(0) << ' ' << a.front() << '\n';
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr std::size_t n = 1 << 25;
+        cyy::Vector<long> v;
+        cyy::Segmented_vector<long> s;
+        double vector_worst = worst_push_back_us(v, n);
+        double segmented_worst = worst_push_back_us(s, n);
+        std::cerr << "worst push_back of " << n << " longs: Vector " << vector_worst
+                  << "us, Segmented_vector " << segmented_worst << "us\n";
+        std::cout << v.size() << ' ' << s.size() << ' ' << (s[n - 1] == v[n - 1]) << '\n';
+    }
+}
@@ -0,0 +1,119 @@
+#include "small_vector.h"
+#include "tracking_allocator.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cassert>
+
+template<typename T, std::size_t N, typename Alloc>
+std::ostream& operator<<(std::ostream& s, const cyy::Small_vector<T, N, Alloc>& v)
+{
+    s.put('[');
+    char comma[3] = {'\0', ' ', '\0'};
+    for (const auto& e : v)
+    {
+        s << comma << e;
+        comma[0] = ',';
+    }
+    return s << ']';
+}
+
+template<typename Container>
+double build_small_lists(int rounds)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    long sum = 0;
+    for (int i = 0; i < rounds; ++i)
+    {
+        Container c;
+        for (int j = 0; j < 6; ++j)
+        {
+            c.push_back(i + j);
+        }
+        sum += c.back();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    assert(sum > 0);
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main()
+{
+    struct Int_tag { };
+    using Alloc = cyy::Tracking_allocator<cyy::Allocator<int>, Int_tag>;
+    auto& stats = cyy::allocation_stats<Int_tag>();
+
+    std::cout << "Test for inline storage:\n";
+    {
+        cyy::Small_vector<int, 4, Alloc> v;
+        std::cout << v.capacity() << ' ' << v.is_inline() << '\n';
+        for (int i = 1; i < 4; ++i)
+        {
+            v.push_back(i);
+        }
+        v.insert(v.begin(), 0);
+        std::cout << v << ' ' << v.is_inline() << ' ' << stats.snapshot().allocations << '\n';
+
+        // grows past the buffer
+        v.push_back(4);
+        std::cout << v << ' ' << v.is_inline() << ' ' << stats.snapshot().allocations << '\n';
+
+        // comes back to the buffer
+        v.resize(2);
+        v.shrink_to_fit();
+        std::cout << v << ' ' << v.is_inline() << ' ' << v.capacity() << '\n';
+        v.shrink_to_fit();
+        std::cout << v.is_inline() << ' ' << stats.snapshot().bytes_in_use << '\n';
+    }
+
+    std::cout << "\nTest for constructors and assignment:\n";
+    {
+        cyy::Small_vector<std::string, 2> a{"hello", "world"};
+        cyy::Small_vector<std::string, 2> b(a);
+        cyy::Small_vector<std::string, 2> c(3, "x");
+        std::cout << b[0] << ' ' << b[1] << ' ' << b.is_inline() << ' ' << c.size() << ' ' << c.is_inline() << '\n';
+
+        // the elements of an inline Small_vector are moved
+        cyy::Small_vector<std::string, 2> d(std::move(a));
+        std::cout << d[1] << ' ' << a.size() << ' ' << d.is_inline() << '\n';
+
+        // heap storage is taken
+        const std::string* p = &c[0];
+        cyy::Small_vector<std::string, 2> e(std::move(c));
+        std::cout << (&e[0] == p) << ' ' << c.size() << ' ' << c.is_inline() << '\n';
+        c = e;
+        std::cout << c << ' ' << (c == e) << '\n';
+        d = std::move(e);
+        std::cout << d << ' ' << (&d[0] == p) << '\n';
+    }
+
+    std::cout << "\nTest for swap:\n";
+    {
+        cyy::Small_vector<int, 3> a{1, 2};
+        cyy::Small_vector<int, 3> b{3, 4, 5, 6};
+        cyy::swap(a, b);
+        std::cout << a << ' ' << b << ' ' << a.is_inline() << ' ' << b.is_inline() << '\n';
+        cyy::Small_vector<int, 3> c{7, 8, 9, 10, 11};
+        const int* p = &c[0];
+        a.swap(c);
+        std::cout << a << ' ' << c << ' ' << (&a[0] == p) << '\n';
+        a.swap(a);
+        std::cout << a.size() << '\n';
+
+        cyy::Vector<cyy::Small_vector<int, 3>> nested;
+        for (int i = 0; i < 100; ++i)
+        {
+            nested.push_back(cyy::Small_vector<int, 3>(i % 5, i));
+        }
+        std::cout << nested[99] << ' ' << nested[98].is_inline() << ' ' << nested[99].is_inline() << '\n';
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        double vec = build_small_lists<cyy::Vector<int>>(1000000);
+        double small = build_small_lists<cyy::Small_vector<int, 8>>(1000000);
+        std::cerr << "1M lists of 6 ints: " << vec << "ms with Vector, " << small << "ms with Small_vector\n";
+        std::cout << "done\n";
+    }
+}
@@ -0,0 +1,118 @@
+#include "tracking_allocator.h"
+#include "vector.h"
+#include "list.h"
+#include "forward_list.h"
+#include "thread.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cassert>
+
+struct Growth_tag
+{
+    static const char* name()
+    {
+        return "vector growth";
+    }
+};
+
+int main()
+{
+    std::cout << "Test for Allocation_stats:\n";
+    {
+        cyy::Allocation_stats stats;
+        stats.record_allocate(24);
+        stats.record_allocate(100);
+        stats.record_deallocate(24);
+        auto s = stats.snapshot();
+        std::cout << s.allocations << ' ' << s.deallocations << ' ' << s.bytes_in_use << ' '
+                  << s.peak_bytes << ' ' << s.total_bytes << '\n';
+        std::cout << cyy::Allocation_stats::bucket(1) << ' ' << cyy::Allocation_stats::bucket(24) << ' '
+                  << cyy::Allocation_stats::bucket(32) << ' ' << cyy::Allocation_stats::bucket(std::size_t(-1)) << '\n';
+        stats.reset();
+        s = stats.snapshot();
+        std::cout << s.allocations << ' ' << s.bytes_in_use << ' ' << s.peak_bytes << '\n';
+    }
+
+    std::cout << "\nTest for Tracking_allocator with the containers:\n";
+    {
+        using Int_alloc = cyy::Tracking_allocator<cyy::Allocator<int>>;
+        {
+            cyy::Vector<int, Int_alloc> v;
+            for (int i = 0; i < 100; ++i)
+                v.push_back(i);
+            auto s = Int_alloc::stats().snapshot();
+            std::cout << s.allocations << ' ' << s.deallocations << ' ' << s.bytes_in_use << ' '
+                      << s.peak_bytes << '\n';
+        }
+        std::cout << Int_alloc::stats().snapshot().bytes_in_use << '\n';
+
+        // List<int> allocates nodes, which are counted apart from Vector<int>
+        {
+            cyy::List<int, Int_alloc> l;
+            for (int i = 0; i < 10; ++i)
+                l.push_back(i);
+            cyy::Forward_list<int, Int_alloc> fl;
+            fl.push_front(1);
+            fl.push_front(2);
+            std::cout << Int_alloc::stats().snapshot().allocations << '\n';
+        }
+
+        int types = 0;
+        cyy::for_each_allocation_stats([&types] (const std::string&, const cyy::Allocation_snapshot& s) {
+            ++types;
+            assert(s.bytes_in_use == 0);
+        });
+        std::cout << types << '\n';
+
+        // an explicit tag is kept when the allocator is rebound
+        using Tagged = cyy::Tracking_allocator<cyy::Allocator<int>, Growth_tag>;
+        {
+            cyy::Vector<int, Tagged> v;
+            for (int i = 0; i < 1000; ++i)
+                v.push_back(i);
+            cyy::List<int, Tagged> l{1, 2, 3};
+            auto s = cyy::allocation_stats<Growth_tag>().snapshot();
+            std::cout << s.allocations << ' ' << s.total_bytes << '\n';
+        }
+    }
+
+    std::cout << "\nTest for Tracking_allocator in threads:\n";
+    {
+        struct Thread_tag { };
+        using Alloc = cyy::Tracking_allocator<cyy::Allocator<long>, Thread_tag>;
+        std::vector<cyy::Thread> workers;
+        for (int i = 0; i < 4; ++i)
+        {
+            workers.emplace_back([] () {
+                for (int j = 0; j < 1000; ++j)
+                {
+                    cyy::Vector<long, Alloc> v;
+                    v.push_back(j);
+                }
+            });
+        }
+        for (auto& t : workers)
+        {
+            t.join();
+        }
+        auto s = cyy::allocation_stats<Thread_tag>().snapshot();
+        std::cout << s.allocations << ' ' << s.deallocations << ' ' << s.bytes_in_use << '\n';
+    }
+
+    std::cout << "\nTest for dump_allocation_stats:\n";
+    {
+        std::ostringstream os;
+        cyy::dump_allocation_stats(os);
+        std::string json = os.str();
+        std::cout << (json.find("\"type\": \"vector growth\"") != std::string::npos) << ' '
+                  << (json.find("\"type\": \"int\"") != std::string::npos) << '\n';
+        int entries = 0;
+        for (auto pos = json.find("{\"type\""); pos != std::string::npos; pos = json.find("{\"type\"", pos + 1))
+        {
+            ++entries;
+        }
+        std::cout << entries << ' ' << json.front() << json[json.size() - 2] << '\n';
+    }
+}
@@ -0,0 +1,125 @@
+#include "uninitialized.h"
+#include "vector.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cassert>
+
+struct Point
+{
+    int x;
+    int y;
+};
+
+// counts its constructions, never trivial
+struct Counted
+{
+    static int constructions;
+
+    Counted()
+    {
+        ++constructions;
+    }
+
+    Counted(const Counted&)
+    {
+        ++constructions;
+    }
+};
+
+int Counted::constructions = 0;
+
+template<typename Function>
+double time_ms(Function f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main()
+{
+    std::cout << "Test for trivial types:\n";
+    {
+        cyy::Allocator<int> alloc;
+        int* p = alloc.allocate(10);
+        int* end = cyy::uninitialized_fill_n_a(p, 10, 7, alloc);
+        std::cout << (end - p) << ' ' << p[0] << ' ' << p[9] << '\n';
+        end = cyy::uninitialized_default_n_a(p, 5, alloc);
+        std::cout << p[0] << ' ' << p[4] << ' ' << p[5] << '\n';
+
+        int* q = alloc.allocate(10);
+        const int* cp = p;
+        end = cyy::uninitialized_copy_a(cp, cp + 10, q, alloc);
+        std::cout << (end - q) << ' ' << q[4] << ' ' << q[5] << '\n';
+        alloc.deallocate(q, 10);
+        alloc.deallocate(p, 10);
+
+        cyy::Allocator<char> chars;
+        char* s = chars.allocate(4);
+        cyy::uninitialized_fill_n_a(s, 3, 'a', chars);
+        s[3] = '\0';
+        std::cout << s << '\n';
+        chars.deallocate(s, 4);
+
+        cyy::Allocator<Point> points;
+        Point* pt = points.allocate(3);
+        cyy::uninitialized_fill_n_a(pt, 3, Point{1, 2}, points);
+        std::cout << pt[2].x << ' ' << pt[2].y << '\n';
+        cyy::uninitialized_default_n_a(pt, 3, points);
+        std::cout << pt[2].x << ' ' << pt[2].y << '\n';
+        points.deallocate(pt, 3);
+    }
+
+    std::cout << "\nTest for other types:\n";
+    {
+        cyy::Allocator<Counted> alloc;
+        Counted* p = alloc.allocate(4);
+        cyy::uninitialized_default_n_a(p, 2, alloc);
+        cyy::uninitialized_fill_n_a(p + 2, 2, p[0], alloc);
+        std::cout << Counted::constructions << '\n';
+        cyy::Destroy(p, p + 4, alloc);
+        alloc.deallocate(p, 4);
+
+        cyy::Allocator<std::string> strings;
+        std::string* s = strings.allocate(2);
+        std::string from[2] = {"hello", "world"};
+        cyy::uninitialized_move_a(from, from + 2, s, strings);
+        std::cout << s[0] << ' ' << s[1] << ' ' << from[0].size() << '\n';
+        cyy::Destroy(s, s + 2, strings);
+        strings.deallocate(s, 2);
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr std::size_t n = 1 << 24;
+        long sum = 0;
+        double fill = time_ms([&sum] {
+            for (int i = 0; i < 10; ++i)
+            {
+                cyy::Vector<int> v(n, i);
+                sum += v[n - 1];
+            }
+        });
+        double zero = time_ms([&sum] {
+            for (int i = 0; i < 10; ++i)
+            {
+                cyy::Vector<int> v(n);
+                sum += v[n - 1];
+            }
+        });
+        cyy::Vector<double> source(n, 1.5);
+        double copy = time_ms([&sum, &source] {
+            for (int i = 0; i < 10; ++i)
+            {
+                cyy::Vector<double> v(source);
+                sum += static_cast<long>(v[n - 1]);
+            }
+        });
+        std::cerr << "10 Vectors of 16M elements: fill " << fill << "ms, value-initialize "
+                  << zero << "ms, copy " << copy << "ms\n";
+        std::cout << sum << '\n';
+    }
+}
@@ -0,0 +1,312 @@
+#include "unrolled_list.h"
+#include "list.h"
+#include "vector.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <iterator>
+#include <cstdint>
+#include <algorithm>
+
+// pseudo random numbers, the same on every run
+struct Lcg
+{
+    std::uint32_t operator()()
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return state >> 33;
+    }
+
+    std::uint64_t state = 42;
+};
+
+template<typename Function>
+double time_ms(Function f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+template<typename Container>
+void print(const Container& c)
+{
+    for (const auto& x : c)
+        std::cout << x << ' ';
+    std::cout << '\n';
+}
+
+// the list holds the elements of v, in both directions
+template<typename List>
+bool same(const List& l, const cyy::Vector<int>& v)
+{
+    return l.size() == v.size() && std::equal(l.begin(), l.end(), v.begin())
+        && std::equal(l.rbegin(), l.rend(), v.rbegin());
+}
+
+int main()
+{
+    std::cout << "Test for constructors:\n";
+    {
+        cyy::Unrolled_list<int> a;
+        cyy::Unrolled_list<int, 4> b(10, 7);
+        cyy::Unrolled_list<std::string, 4> c{"a", "b", "c", "d", "e", "f"};
+        cyy::Unrolled_list<std::string, 4> d(c);
+        cyy::Unrolled_list<std::string, 4> e(std::move(d));
+        std::cout << a.size() << ' ' << a.empty() << ' ' << (a.begin() == a.end()) << '\n';
+        print(b);
+        print(c);
+        std::cout << d.size() << ' ' << (c == e) << '\n';
+
+        d = e;
+        e = {"x", "y"};
+        print(d);
+        print(e);
+        d.swap(e);
+        print(d);
+        print(e);
+        std::cout << d.front() << ' ' << d.back() << ' ' << e.front() << ' ' << e.back() << '\n';
+        std::cout << cyy::Unrolled_list<int>::node_capacity << ' ' << cyy::Unrolled_list<double>::node_capacity << '\n';
+    }
+
+    std::cout << "\nTest for push and pop:\n";
+    {
+        cyy::Unrolled_list<int, 4> l;
+        for (int i = 0; i < 10; ++i)
+        {
+            l.push_back(i);
+            l.push_front(-i - 1);
+        }
+        print(l);
+        l.pop_front();
+        l.pop_back();
+        l.pop_back();
+        print(l);
+        std::copy(l.rbegin(), l.rend(), std::ostream_iterator<int>(std::cout, " "));
+        std::cout << '\n';
+
+        // as a queue, the nodes drained at the front are freed
+        cyy::Unrolled_list<int, 4> q;
+        long sum = 0;
+        for (int i = 0; i < 1000; ++i)
+        {
+            q.push_back(i);
+            q.push_back(i);
+            sum += q.front();
+            q.pop_front();
+        }
+        std::cout << q.size() << ' ' << sum << ' ' << q.front() << ' ' << q.back() << '\n';
+    }
+
+    std::cout << "\nTest for insert and erase:\n";
+    {
+        cyy::Unrolled_list<int, 4> l{0, 1, 2, 3, 4, 5, 6, 7};
+        auto it = l.insert(std::next(l.begin(), 2), 100);
+        std::cout << *it << ' ' << *std::next(it) << '\n';
+        it = l.insert(std::next(l.begin(), 5), 3, 200);
+        std::cout << *it << ' ' << *std::next(it, 3) << '\n';
+        it = l.insert(l.end(), {300, 301});
+        std::cout << *it << '\n';
+        it = l.emplace(l.begin(), -1);
+        print(l);
+
+        it = l.erase(std::next(l.begin(), 3));
+        std::cout << *it << '\n';
+        it = l.erase(std::next(l.begin(), 4), std::next(l.begin(), 9));
+        std::cout << *it << '\n';
+        print(l);
+        it = l.erase(std::next(l.begin(), 2), l.end());
+        std::cout << (it == l.end()) << ' ';
+        print(l);
+
+        l.resize(5, 9);
+        print(l);
+        l.assign(3, 4);
+        print(l);
+        l.assign({5, 6, 7, 8, 9, 10});
+        print(l);
+
+        // the element inserted is one of the list, in a node that is split
+        cyy::Unrolled_list<std::string, 4> s{"a", "b", "c", "d"};
+        s.insert(std::next(s.begin()), s.back());
+        s.emplace(std::next(s.begin(), 4), s.front());
+        print(s);
+    }
+
+    std::cout << "\nTest for splice:\n";
+    {
+        cyy::Unrolled_list<int, 4> a{1, 2, 3, 4, 5, 6};
+        cyy::Unrolled_list<int, 4> b{10, 11, 12, 13, 14, 15, 16};
+        a.splice(std::next(a.begin(), 3), b, std::next(b.begin(), 2), std::next(b.begin(), 5));
+        print(a);
+        print(b);
+        a.splice(a.begin(), b, std::next(b.begin()));
+        print(a);
+        print(b);
+        a.splice(std::next(a.begin(), 2), b);
+        print(a);
+        std::cout << a.size() << ' ' << b.size() << ' ' << b.empty() << '\n';
+
+        // within one list
+        a.splice(a.end(), a, a.begin(), std::next(a.begin(), 4));
+        print(a);
+        a.splice(std::next(a.begin(), 1), a, std::prev(a.end()));
+        print(a);
+        std::cout << a.size() << '\n';
+    }
+
+    std::cout << "\nTest for operations:\n";
+    {
+        cyy::Unrolled_list<int, 4> l{5, 3, 3, 8, 1, 1, 1, 9, 2, 7, 3};
+        l.unique();
+        print(l);
+        l.remove(3);
+        print(l);
+        l.remove_if([] (int x) { return x > 7; });
+        print(l);
+        l.reverse();
+        print(l);
+        l.sort();
+        print(l);
+        cyy::Unrolled_list<int, 4> m{0, 2, 4, 6, 8};
+        l.merge(m);
+        print(l);
+        std::cout << m.size() << '\n';
+
+        cyy::Unrolled_list<int, 4> x{1, 2, 3}, y{1, 2, 4};
+        std::cout << (x == y) << ' ' << (x != y) << ' ' << (x < y) << ' ' << (x >= y) << '\n';
+    }
+
+    std::cout << "\nTest for random operations:\n";
+    {
+        // every operation is checked against a Vector
+        Lcg rand;
+        cyy::Unrolled_list<int, 5> l;
+        cyy::Vector<int> v;
+        bool ok = true;
+        for (int step = 0; step < 50000 && ok; ++step)
+        {
+            int value = step;
+            std::size_t i = v.empty() ? 0 : rand() % (v.size() + 1);
+            switch (rand() % 8)
+            {
+            case 0:
+                l.push_back(value);
+                v.push_back(value);
+                break;
+            case 1:
+                l.push_front(value);
+                v.insert(v.begin(), value);
+                break;
+            case 2:
+            case 3:
+            {
+                auto it = l.insert(std::next(l.begin(), i), value);
+                v.insert(v.begin() + i, value);
+                ok = *it == value;
+                break;
+            }
+            case 4:
+                if (i < v.size())
+                {
+                    auto it = l.erase(std::next(l.begin(), i));
+                    v.erase(v.begin() + i);
+                    ok = i == v.size() ? it == l.end() : *it == v[i];
+                }
+                break;
+            case 5:
+            {
+                std::size_t j = i + rand() % 4;
+                j = j < v.size() ? j : v.size();
+                auto it = l.erase(std::next(l.begin(), i), std::next(l.begin(), j));
+                v.erase(v.begin() + i, v.begin() + j);
+                ok = i == v.size() ? it == l.end() : *it == v[i];
+                break;
+            }
+            case 6:
+            {
+                cyy::Unrolled_list<int, 5> other;
+                std::size_t n = rand() % 9;
+                for (std::size_t k = 0; k < n; ++k)
+                    other.push_back(-value - int(k));
+                std::size_t first = n == 0 ? 0 : rand() % n;
+                std::size_t last = first + rand() % (n - first + 1);
+                l.splice(std::next(l.begin(), i), other, std::next(other.begin(), first), std::next(other.begin(), last));
+                for (std::size_t k = first; k < last; ++k)
+                    v.insert(v.begin() + i + (k - first), -value - int(k));
+                ok = other.size() == n - (last - first);
+                break;
+            }
+            case 7:
+                if (v.size() > 1)
+                {
+                    // move a range within the list
+                    std::size_t first = rand() % v.size();
+                    std::size_t last = first + rand() % (v.size() - first + 1);
+                    std::size_t pos = rand() % (v.size() - (last - first) + 1);
+                    pos = pos < first ? pos : pos + (last - first);
+                    l.splice(std::next(l.begin(), pos), l, std::next(l.begin(), first), std::next(l.begin(), last));
+                    if (pos < first)
+                        std::rotate(v.begin() + pos, v.begin() + first, v.begin() + last);
+                    else
+                        std::rotate(v.begin() + first, v.begin() + last, v.begin() + pos);
+                }
+                break;
+            }
+            ok = ok && same(l, v);
+        }
+        std::cout << ok << ' ' << l.size() << ' ' << v.size() << '\n';
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr int n = 4000000;
+        Lcg rand;
+        cyy::List<int> list;
+        cyy::Unrolled_list<int> unrolled;
+        // interleave with other allocations, as lists built over time are
+        cyy::Vector<cyy::List<int>> noise(16);
+        for (int i = 0; i < n; ++i)
+        {
+            int x = rand() % 1000;
+            list.push_back(x);
+            unrolled.push_back(x);
+            noise[rand() % 16].push_back(x);
+        }
+
+        long s1 = 0, s2 = 0;
+        double t_list = time_ms([&] {
+            for (int round = 0; round < 5; ++round)
+                for (int x : list)
+                    s1 += x;
+        });
+        double t_unrolled = time_ms([&] {
+            for (int round = 0; round < 5; ++round)
+                for (int x : unrolled)
+                    s2 += x;
+        });
+        std::cerr << "traverse 4M ints 5 times: List " << t_list << "ms, Unrolled_list " << t_unrolled << "ms\n";
+        std::cout << (s1 == s2) << '\n';
+
+        // a queue of messages, drained at the front while filled at the back
+        double t_list_queue = time_ms([&] {
+            for (int i = 0; i < n; ++i)
+            {
+                list.push_back(i);
+                list.pop_front();
+            }
+        });
+        double t_unrolled_queue = time_ms([&] {
+            for (int i = 0; i < n; ++i)
+            {
+                unrolled.push_back(i);
+                unrolled.pop_front();
+            }
+        });
+        std::cerr << "queue of 4M ints, 4M push_back and pop_front: List " << t_list_queue
+                  << "ms, Unrolled_list " << t_unrolled_queue << "ms\n";
+        std::cout << (list.front() == unrolled.front()) << ' ' << (list.back() == unrolled.back()) << '\n';
+    }
+}
@@ -0,0 +1,119 @@
+// Checks of Vector at CYY_VECTOR_CHECK_LEVEL 2 unless given otherwise. Build
+// with -O2 -DCYY_VECTOR_CHECK_LEVEL=0, 1 and 2 to compare the timings of the
+// performance test, printed to stderr.
+#ifndef CYY_VECTOR_CHECK_LEVEL
+#define CYY_VECTOR_CHECK_LEVEL 2
+#endif
+
+#include <stdexcept>
+
+// report failed checks as exceptions instead of aborting
+#define CYY_VECTOR_CHECK_FAILED(message) throw std::logic_error(message)
+
+#include "vector.h"
+
+#include <iostream>
+#include <chrono>
+#include <numeric>
+
+template<typename Function>
+void expect_failure(const char* what, Function f)
+{
+    try
+    {
+        f();
+        std::cout << what << ": no check\n";
+    }
+    catch (std::logic_error& e)
+    {
+        std::cout << what << ": " << e.what() << '\n';
+    }
+}
+
+template<typename Function>
+double time_ms(Function f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main()
+{
+    if constexpr (CYY_VECTOR_CHECK_LEVEL >= 1)
+    {
+        std::cout << "Test for bounds checks:\n";
+        cyy::Vector<int> v{1, 2, 3};
+        expect_failure("v[3]", [&v] { return v[3]; });
+        expect_failure("pop_back", [] { cyy::Vector<int> e; e.pop_back(); });
+        expect_failure("erase(end())", [&v] { v.erase(v.end()); });
+        expect_failure("erase(last, first)", [&v] { v.erase(v.end() - 1, v.begin()); });
+        expect_failure("emplace_back_unchecked", [&v] {
+            v.shrink_to_fit();
+            v.reserve_exact(v.size());
+            v.emplace_back_unchecked(4);
+        });
+        std::cout << v.size() << ' ' << v[2] << '\n';
+    }
+
+    if constexpr (CYY_VECTOR_CHECK_LEVEL >= 2)
+    {
+        std::cout << "\nTest for iterator checks:\n";
+        cyy::Vector<int> v{1, 2, 3};
+        auto it = v.begin() + 1;
+        std::cout << *it << '\n';
+        v.reserve(100);
+        expect_failure("after reallocation", [&it] { return *it; });
+
+        it = v.begin() + 1;
+        v.push_back(4);
+        std::cout << *it << '\n';
+        it = v.end() - 1;
+        v.erase(it);
+        expect_failure("after erase", [&it] { return *it; });
+
+        // changes in place keep the iterators before them valid
+        it = v.begin();
+        v.pop_back();
+        v.erase(v.end() - 1, v.end());
+        v.insert(v.end(), {7, 8});
+        v.insert(v.begin() + 1, 6);
+        v.resize(3);
+        std::cout << *it << ' ' << v[1] << ' ' << v.size() << '\n';
+
+        it = v.end();
+        expect_failure("end()", [&it] { return *it; });
+
+        cyy::Vector<int> w{5};
+        auto wit = w.begin();
+        expect_failure("insert at another vector's iterator", [&v, &wit] { v.insert(wit, 0); });
+        expect_failure("compare with another vector's iterator", [&v, &w] { return v.begin() == w.begin(); });
+
+        cyy::Vector<int>::const_iterator cit = v.cbegin();
+        std::cout << *cit << ' ' << (cit == v.begin()) << ' ' << (v.end() - cit) << ' ' << *v.rbegin() << '\n';
+    }
+
+    std::cout << "\nTest for performance:\n";
+    {
+        constexpr std::size_t n = 1 << 22;
+        cyy::Vector<int> v;
+        long sum = 0;
+        double push = time_ms([&v] {
+            for (std::size_t i = 0; i < n; ++i)
+                v.push_back(i % 100);
+        });
+        double index = time_ms([&v, &sum] {
+            for (int round = 0; round < 10; ++round)
+                for (std::size_t i = 0; i < v.size(); ++i)
+                    sum += v[i];
+        });
+        double iterate = time_ms([&v, &sum] {
+            for (int round = 0; round < 10; ++round)
+                sum += std::accumulate(v.begin(), v.end(), 0L);
+        });
+        std::cerr << "check level " << CYY_VECTOR_CHECK_LEVEL << ": push_back " << push << "ms, operator[] "
+                  << index << "ms, iterators " << iterate << "ms\n";
+        std::cout << sum << '\n';
+    }
+}
@@ -1,9 +1,14 @@
 #include <string>
+#include <sstream>
+#include <iterator>
 #include <memory>
 #include <vector>
 #include <iomanip>
 #include <iostream>
 #include "vector.h"
+#include "unique_ptr.h"
+#include "pair.h"
+#include "list.h"
  
 template<typename T, typename Alloc>
 std::ostream& operator<<(std::ostream& s, const cyy::Vector<T, Alloc>& v) {
@@ -43,6 +48,20 @@ struct NAlloc {
     }
 };
 
+// copies throw once copies_left reaches 0, and it has no move constructor,
+// so Vector copies it when it reallocates
+struct Thrower {
+    std::string s;
+    static int copies_left;
+    Thrower(const char* str) : s(str) {}
+    Thrower(const Thrower& other) : s(other.s) {
+        if (--copies_left == 0)
+            throw std::runtime_error("copy failed");
+    }
+    Thrower& operator=(const Thrower&) = default;
+};
+int Thrower::copies_left = -1;
+
 template <class T, class U>
 bool operator==(const NAlloc<T>&, const NAlloc<U>&) { return true; }
 template <class T, class U>
@@ -401,4 +420,130 @@ int main()
             std::cout << e << " ";
         std::cout << "\n";
     }
+
+    std::cout << "\ntests for trivially relocatable elements\n";
+    {
+        std::cout << std::boolalpha
+            << is_trivially_relocatable_v<int> << " "
+            << is_trivially_relocatable_v<Unique_ptr<int>> << " "
+            << is_trivially_relocatable_v<pair<int, Unique_ptr<int>>> << " "
+            << is_trivially_relocatable_v<Vector<std::string>> << " "
+            << is_trivially_relocatable_v<std::string> << " "
+            << is_trivially_relocatable_v<List<int>> << "\n";
+
+        // growth moves the bytes, the old elements are not destroyed
+        Vector<Unique_ptr<int>> ptrs;
+        for (int i = 0; i < 100; ++i)
+            ptrs.push_back(Unique_ptr<int>(new int(i)));
+        ptrs.insert(ptrs.begin() + 50, Unique_ptr<int>(new int(-1)));
+        ptrs.shrink_to_fit();
+        std::cout << ptrs.size() << " " << *ptrs[49] << " " << *ptrs[50] << " " << *ptrs[100] << "\n";
+
+        Vector<Vector<int>> nested;
+        for (int i = 0; i < 1000; ++i)
+            nested.push_back(Vector<int>(i % 10, i));
+        std::cout << nested.size() << " " << nested[999].size() << " " << nested[999][0] << "\n";
+    }
+
+    std::cout << "\ntests for growth policies and reserve_exact\n";
+    {
+        auto capacities = [](auto v) {
+            std::size_t last = 0;
+            for (int i = 0; i < 2000; ++i)
+            {
+                v.push_back(i);
+                if (v.capacity() != last)
+                {
+                    last = v.capacity();
+                    std::cout << last << " ";
+                }
+            }
+            std::cout << "\n";
+        };
+        capacities(Vector<int>());
+        capacities(Vector<int, Allocator<int>, Half_growth>());
+        capacities(Vector<int, Allocator<int>, Power_of_two_growth>());
+        capacities(Vector<int, Allocator<int>, Page_growth<Half_growth>>());
+
+        Vector<int> v{1, 2, 3};
+        v.reserve_exact(10);
+        std::cout << v.capacity() << " ";
+        v.reserve_exact(5);
+        std::cout << v.capacity() << " ";
+        v.reserve_exact(0);
+        std::cout << v.capacity() << " " << v.size() << " " << v[2] << "\n";
+        v.clear();
+        v.reserve_exact(0);
+        std::cout << v.capacity() << " " << v.empty() << "\n";
+    }
+
+    std::cout << "\ntests for bulk append\n";
+    {
+        // input iterators are read once
+        std::istringstream in("1 2 3 4 5 6 7 8 9 10");
+        Vector<int> parsed{std::istream_iterator<int>(in), std::istream_iterator<int>()};
+        std::cout << parsed << "\n";
+
+        std::istringstream more("100 200 300");
+        parsed.insert(parsed.begin() + 2, std::istream_iterator<int>(more), std::istream_iterator<int>());
+        std::cout << parsed << "\n";
+
+        Vector<int> v;
+        v.append_range(parsed);
+        int i = 0;
+        v.append(3, [&i] { return --i; });
+        std::cout << v.size() << " " << v[12] << " " << v.back() << "\n";
+
+        Vector<std::string> words;
+        words.reserve(3);
+        words.emplace_back_unchecked("alpha");
+        words.emplace_back_unchecked(3, 'b');
+        words.emplace_back("gamma");
+        words.emplace_back(words[0]);
+        words.emplace(words.begin() + 1, words[3]);
+        std::cout << words << "\n";
+    }
+
+    std::cout << "\ntests for inserting elements of the vector\n";
+    {
+        // the new elements are built before the others move
+        Vector<std::string> v{"a", "b", "c", "d"};
+        v.shrink_to_fit();
+        v.insert(v.begin() + 2, 3, v[0]);
+        std::cout << v << "\n";
+        v.reserve(20);
+        v.insert(v.begin() + 1, 2, v.back());
+        std::cout << v << "\n";
+        Vector<std::string> more{"e", "f", "g"};
+        v.insert(v.begin() + 2, more.begin(), more.end());
+        v.shrink_to_fit();
+        v.insert(v.begin() + 1, more.begin(), more.begin() + 2);
+        std::cout << v << "\n";
+
+        Vector<std::string> w{"x", "y"};
+        w.shrink_to_fit();
+        w.resize(4, w[0]);
+        std::cout << w << "\n";
+
+        // a copy throwing while reallocating leaves the vector as it was,
+        // whether it builds a new element or moves an old one
+        Vector<Thrower> t{"p", "q", "r"};
+        Vector<Thrower> src{"s", "t"};
+        for (int n = 1; n <= 5; ++n) {
+            for (bool range : {false, true}) {
+                t.shrink_to_fit();
+                Thrower::copies_left = n;
+                try {
+                    if (range)
+                        t.insert(t.begin() + 1, src.begin(), src.end());
+                    else
+                        t.insert(t.begin() + 1, 2, src[0]);
+                } catch (const std::runtime_error&) {
+                }
+                std::cout << t.size() << t[0].s << t[1].s << t[2].s << " ";
+            }
+        }
+        Thrower::copies_left = -1;
+        std::cout << "\n";
+    }
 }
\ No newline at end of file